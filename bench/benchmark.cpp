@@ -0,0 +1,161 @@
+#include "benchmark.hpp"
+
+#include <fmt/format.h>
+
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace bs::bench {
+namespace {
+// A cursor over the subset of JSON to_json() writes: objects, arrays,
+// strings without escapes other than \" and \\, and numbers.
+class JsonReader {
+public:
+  explicit JsonReader(std::string_view json) : m_json(json) {}
+
+  void expect(char c) {
+    skip_space();
+    if (m_position >= m_json.size() || m_json[m_position] != c)
+      throw std::runtime_error(
+          fmt::format("Expected '{0}' at offset {1}", c, m_position));
+    m_position++;
+  }
+  // Consumes `c` if it's next.
+  bool accept(char c) {
+    skip_space();
+    if (m_position < m_json.size() && m_json[m_position] == c) {
+      m_position++;
+      return true;
+    }
+    return false;
+  }
+  std::string string() {
+    expect('"');
+    std::string value;
+    while (m_position < m_json.size() && m_json[m_position] != '"') {
+      if (m_json[m_position] == '\\')
+        m_position++;
+      if (m_position < m_json.size())
+        value.push_back(m_json[m_position++]);
+    }
+    expect('"');
+    return value;
+  }
+  double number() {
+    skip_space();
+    double value = 0.0;
+    const auto [end, error] = std::from_chars(
+        m_json.data() + m_position, m_json.data() + m_json.size(), value);
+    if (error != std::errc())
+      throw std::runtime_error(
+          fmt::format("Expected a number at offset {0}", m_position));
+    m_position = end - m_json.data();
+    return value;
+  }
+
+private:
+  void skip_space() {
+    while (m_position < m_json.size() &&
+           std::isspace(static_cast<unsigned char>(m_json[m_position])))
+      m_position++;
+  }
+
+  std::string_view m_json;
+  size_t m_position = 0;
+};
+
+std::string escape(std::string_view text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      escaped.push_back('\\');
+    escaped.push_back(c);
+  }
+  return escaped;
+}
+} // namespace
+
+void Suite::add(Result result) {
+  fmt::print("  {0:<40} {1:12.3f} {2}\n", result.name, result.value,
+             result.unit);
+  m_results.push_back(std::move(result));
+}
+
+std::string to_json(const std::vector<Result> &results) {
+  std::string json = "{\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    json += fmt::format("{0}\n    {{\"name\": \"{1}\", \"value\": {2}, "
+                        "\"unit\": \"{3}\"}}",
+                        i == 0 ? "" : ",", escape(results[i].name),
+                        results[i].value, escape(results[i].unit));
+  }
+  json += "\n  ]\n}\n";
+  return json;
+}
+
+std::vector<Result> from_json(std::string_view json) {
+  JsonReader reader(json);
+  std::vector<Result> results;
+  reader.expect('{');
+  if (reader.string() != "benchmarks")
+    throw std::runtime_error("Expected a \"benchmarks\" array");
+  reader.expect(':');
+  reader.expect('[');
+  if (!reader.accept(']')) {
+    do {
+      Result result;
+      reader.expect('{');
+      do {
+        const std::string key = reader.string();
+        reader.expect(':');
+        if (key == "name") {
+          result.name = reader.string();
+        } else if (key == "value") {
+          result.value = reader.number();
+        } else if (key == "unit") {
+          result.unit = reader.string();
+        } else {
+          throw std::runtime_error(fmt::format("Unknown key \"{0}\"", key));
+        }
+      } while (reader.accept(','));
+      reader.expect('}');
+      results.push_back(std::move(result));
+    } while (reader.accept(','));
+    reader.expect(']');
+  }
+  reader.expect('}');
+  return results;
+}
+
+uint32_t compare(const std::vector<Result> &baseline,
+                 const std::vector<Result> &results, double threshold) {
+  std::unordered_map<std::string, const Result *> baseline_by_name;
+  for (const Result &result : baseline) {
+    baseline_by_name.emplace(result.name, &result);
+  }
+  fmt::print("Against the baseline, failing past {0:+.1f}%:\n",
+             threshold * 100.0);
+  uint32_t regressions = 0;
+  for (const Result &result : results) {
+    const auto found = baseline_by_name.find(result.name);
+    if (found == baseline_by_name.end()) {
+      fmt::print("  {0:<40} {1:>12} new\n", result.name, "");
+      continue;
+    }
+    const double base = found->second->value;
+    baseline_by_name.erase(found);
+    const double change = base > 0.0 ? result.value / base - 1.0 : 0.0;
+    const bool regressed = change > threshold;
+    regressions += regressed;
+    fmt::print("  {0:<40} {1:+11.1f}% {2}\n", result.name, change * 100.0,
+               regressed ? "REGRESSED" : "ok");
+  }
+  for (const Result &result : baseline) {
+    if (baseline_by_name.contains(result.name))
+      fmt::print("  {0:<40} {1:>12} missing\n", result.name, "");
+  }
+  return regressions;
+}
+} // namespace bs::bench
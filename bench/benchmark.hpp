@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bs::bench {
+struct Options {
+  // Timed runs per benchmark; each reports its best.
+  uint32_t repeats = 20;
+  // Job system workers; zero spawns one per remaining hardware thread.
+  uint32_t worker_threads = 0;
+  // Only benchmarks whose name contains this run.
+  std::string filter;
+  bool frames = true;
+  // Render on whatever device comes first instead of requiring a software
+  // one.
+  bool any_device = false;
+  uint32_t warmup_frames = 20;
+  uint32_t timed_frames = 200;
+};
+
+// Every result is a time per item (a frame, for frame benchmarks), so
+// lower is always better.
+struct Result {
+  std::string name;
+  double value = 0.0;
+  std::string unit;
+};
+
+class Suite {
+public:
+  explicit Suite(const Options &options) : m_options(options) {}
+
+  const Options &options() const { return m_options; }
+  bool enabled(std::string_view name) const {
+    return name.find(m_options.filter) != std::string_view::npos;
+  }
+
+  // Times f() options().repeats times after one untimed run, and records
+  // the best run in nanoseconds per item.
+  template <typename F> void time(std::string name, uint64_t items, F &&f) {
+    if (!enabled(name))
+      return;
+    f();
+    double best = 1e300;
+    for (uint32_t i = 0; i < m_options.repeats; i++) {
+      const auto start = std::chrono::steady_clock::now();
+      f();
+      const std::chrono::duration<double, std::nano> elapsed =
+          std::chrono::steady_clock::now() - start;
+      best = std::min(best, elapsed.count());
+    }
+    add(Result{
+        .name = std::move(name),
+        .value = best / static_cast<double>(std::max<uint64_t>(items, 1)),
+        .unit = "ns/item",
+    });
+  }
+  // Prints the result as it comes in.
+  void add(Result result);
+
+  const std::vector<Result> &results() const { return m_results; }
+
+private:
+  Options m_options;
+  std::vector<Result> m_results;
+};
+
+// ECS iteration, culling, vertex encoding, mesh optimization, draw sorting
+// and allocators, on fixed-seed data so runs are comparable.
+void run_cpu_benchmarks(Suite &suite);
+// Headless frames on a software Vulkan device, CPU-culled and GPU-driven.
+// Skipped, with a note, when there is no such device.
+void run_frame_benchmarks(Suite &suite);
+
+std::string to_json(const std::vector<Result> &results);
+// Reads what to_json() writes. Throws std::runtime_error on anything else.
+std::vector<Result> from_json(std::string_view json);
+
+// Prints every result next to its baseline and returns how many are slower
+// than it by more than `threshold`, e.g. 0.1 for 10%. Results missing from
+// either side are reported but don't count.
+uint32_t compare(const std::vector<Result> &baseline,
+                 const std::vector<Result> &results, double threshold);
+} // namespace bs::bench
@@ -0,0 +1,257 @@
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include "benchmark.hpp"
+
+#include <engine/culling/culling.hpp>
+#include <engine/ecs/ecs.hpp>
+#include <engine/jobs/job_system.hpp>
+#include <engine/renderer/draw_list.hpp>
+#include <engine/renderer/mesh_arena.hpp>
+#include <engine/types/handle.hpp>
+#include <engine/types/mesh_optimizer.hpp>
+#include <engine/types/quantized_vertex.hpp>
+
+#include <fmt/format.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace bs::engine;
+
+namespace bs::bench {
+namespace {
+// Results are written here so the work producing them can't be optimized
+// away.
+volatile uint64_t sink = 0;
+
+struct Position {
+  glm::vec3 value;
+};
+struct Velocity {
+  glm::vec3 value;
+};
+
+void ecs_benchmarks(Suite &suite, jobs::JobSystem &job_system) {
+  // Moving entities plus as many static ones in another archetype, so the
+  // query skips a table.
+  const uint32_t count = 200000;
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> value(-1.f, 1.f);
+  ecs::ECS ecs;
+  for (uint32_t i = 0; i < count; i++) {
+    const ecs::Entity entity = ecs.create();
+    ecs.add<Position>(entity, glm::vec3(value(rng), value(rng), value(rng)));
+    ecs.add<Velocity>(entity, glm::vec3(value(rng), value(rng), value(rng)));
+    ecs.add<Position>(ecs.create(), glm::vec3(0.f));
+  }
+  const float dt = 1.f / 60.f;
+  suite.time("ecs/each", count, [&]() {
+    ecs.each<Position, Velocity>(
+        [dt](Position &position, const Velocity &velocity) {
+          position.value += velocity.value * dt;
+        });
+  });
+  suite.time("ecs/parallel_each", count, [&]() {
+    ecs.parallel_each<Position, Velocity>(
+        job_system, [dt](Position &position, const Velocity &velocity) {
+          position.value += velocity.value * dt;
+        });
+  });
+}
+
+void culling_benchmarks(Suite &suite, jobs::JobSystem &job_system) {
+  // The scene of examples/cull_bench: about a sixth of the spheres end up
+  // in the frustum.
+  const uint32_t count = 200000;
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> position(-100.f, 100.f);
+  std::uniform_real_distribution<float> radius(0.1f, 2.f);
+  culling::SphereSoA spheres;
+  spheres.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    spheres.push_back(glm::vec3(position(rng), position(rng), position(rng)),
+                      radius(rng));
+  }
+  const float near = 0.1f;
+  const float far = 100.f;
+  glm::mat4 projection(0.f);
+  projection[0][0] = 1.f;
+  projection[1][1] = -1.f;
+  projection[2][2] = far / (near - far);
+  projection[2][3] = -1.f;
+  projection[3][2] = far * near / (near - far);
+  const culling::Frustum frustum = culling::Frustum::from_matrix(projection);
+
+  std::vector<uint32_t> visible(spheres.padded_size());
+  for (culling::CullKernel kernel :
+       {culling::CullKernel::eScalar, culling::CullKernel::eSse2,
+        culling::CullKernel::eAvx2}) {
+    if (kernel > culling::best_cull_kernel())
+      continue;
+    suite.time(fmt::format("culling/{0}", culling::cull_kernel_name(kernel)),
+               count, [&]() {
+                 culling::cull_spheres(frustum, spheres, 0, count,
+                                       visible.data(), kernel);
+               });
+  }
+  suite.time("culling/parallel", count, [&]() {
+    culling::cull_spheres(job_system, frustum, spheres, visible);
+  });
+}
+
+// A bumpy grid of `size` by `size` quads as an unindexed triangle soup,
+// triangles shuffled so the optimizer has work to do.
+std::vector<types::Vertex> grid_soup(uint32_t size) {
+  const auto vertex = [size](uint32_t x, uint32_t y) {
+    const float u = static_cast<float>(x) / size;
+    const float v = static_cast<float>(y) / size;
+    const float height = 0.05f * std::sin(u * 20.f) * std::cos(v * 20.f);
+    return types::Vertex{
+        .position = glm::vec3(u, height, v),
+        .normal = glm::normalize(glm::vec3(-height, 1.f, height)),
+    };
+  };
+  std::vector<std::array<types::Vertex, 3>> triangles;
+  triangles.reserve(size * size * 2);
+  for (uint32_t y = 0; y < size; y++) {
+    for (uint32_t x = 0; x < size; x++) {
+      triangles.push_back({vertex(x, y), vertex(x, y + 1), vertex(x + 1, y)});
+      triangles.push_back(
+          {vertex(x + 1, y), vertex(x, y + 1), vertex(x + 1, y + 1)});
+    }
+  }
+  std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+  std::vector<types::Vertex> vertices;
+  vertices.reserve(triangles.size() * 3);
+  for (const auto &triangle : triangles) {
+    vertices.insert(vertices.end(), triangle.begin(), triangle.end());
+  }
+  return vertices;
+}
+
+void vertex_benchmarks(Suite &suite) {
+  const std::vector<types::Vertex> vertices = grid_soup(256);
+  const uint32_t count = static_cast<uint32_t>(vertices.size());
+  const types::VertexBounds bounds = types::compute_bounds(vertices);
+  std::vector<types::QuantizedVertex> quantized;
+  suite.time("vertex/quantize", count, [&]() {
+    quantized = types::quantize_vertices(vertices, bounds);
+  });
+  std::vector<types::Vertex> decoded(count);
+  suite.time("vertex/dequantize", count, [&]() {
+    for (uint32_t i = 0; i < count; i++) {
+      decoded[i] = types::dequantize_vertex(quantized[i], bounds);
+    }
+  });
+}
+
+void mesh_benchmarks(Suite &suite) {
+  const std::vector<types::Vertex> soup = grid_soup(128);
+  const uint32_t triangles = static_cast<uint32_t>(soup.size() / 3);
+  // Each run starts from a copy of the soup, which is part of the time.
+  std::vector<types::Vertex> vertices;
+  std::vector<uint32_t> indices;
+  suite.time("mesh/optimize", triangles, [&]() {
+    vertices = soup;
+    indices.clear();
+    types::optimize_mesh(vertices, indices);
+  });
+  if (indices.empty()) {
+    vertices = soup;
+    types::optimize_mesh(vertices, indices);
+  }
+  suite.time("mesh/build_meshlets", triangles, [&]() {
+    types::build_meshlets(indices, vertices);
+  });
+  std::vector<uint32_t> simplified;
+  suite.time("mesh/simplify_clustered", triangles, [&]() {
+    types::simplify_clustered(indices, vertices, 32, simplified);
+  });
+}
+
+void draw_sort_benchmarks(Suite &suite) {
+  // Two pipelines, a thousand meshes and random depths.
+  const uint32_t count = 100000;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<uint32_t> mesh(0, 999);
+  std::uniform_real_distribution<float> depth(0.f, 100.f);
+  std::vector<renderer::SortedDraw> unsorted(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const uint32_t index = mesh(rng);
+    const uint32_t quantized = renderer::draw_key::quantize_depth(depth(rng));
+    unsorted[i] = renderer::SortedDraw{
+        .key = renderer::draw_key::make(index % 2, 0, index, quantized),
+        .item = i,
+    };
+  }
+  std::vector<renderer::SortedDraw> draws;
+  std::vector<renderer::SortedDraw> scratch;
+  suite.time("draws/sort", count, [&]() {
+    draws = unsorted;
+    renderer::sort_draws(draws, scratch);
+  });
+}
+
+void allocator_benchmarks(Suite &suite) {
+  // Steady-state churn: a few thousand live ranges, each step freeing a
+  // random one and allocating another, as meshes stream in and out.
+  const uint32_t live = 4096;
+  const uint32_t steps = 100000;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<uint32_t> size(16, 4096);
+  std::uniform_int_distribution<uint32_t> victim(0, live - 1);
+  std::vector<uint32_t> sizes(live + steps);
+  std::vector<uint32_t> victims(steps);
+  for (uint32_t &s : sizes) {
+    s = size(rng);
+  }
+  for (uint32_t &v : victims) {
+    v = victim(rng);
+  }
+
+  suite.time("alloc/range_allocator", steps, [&]() {
+    renderer::RangeAllocator allocator(64 * 1024 * 1024);
+    std::vector<std::pair<uint32_t, uint32_t>> ranges(live);
+    for (uint32_t i = 0; i < live; i++) {
+      ranges[i] = {*allocator.allocate(sizes[i]), sizes[i]};
+    }
+    for (uint32_t i = 0; i < steps; i++) {
+      auto &range = ranges[victims[i]];
+      allocator.free(range.first, range.second);
+      range = {*allocator.allocate(sizes[live + i]), sizes[live + i]};
+    }
+  });
+
+  suite.time("alloc/handle_pool", steps, [&]() {
+    types::Pool<uint64_t> pool;
+    std::vector<types::Handle<uint64_t>> handles(live);
+    for (uint32_t i = 0; i < live; i++) {
+      handles[i] = pool.create(i);
+    }
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < steps; i++) {
+      auto &handle = handles[victims[i]];
+      pool.destroy(handle);
+      handle = pool.create(i);
+      sum += *pool.get(handles[victims[steps - 1 - i]]);
+    }
+    sink = sum;
+  });
+}
+} // namespace
+
+void run_cpu_benchmarks(Suite &suite) {
+  jobs::JobSystem job_system(suite.options().worker_threads);
+  fmt::print("CPU benchmarks, {0} threads, best of {1} runs:\n",
+             job_system.thread_count(), suite.options().repeats);
+  ecs_benchmarks(suite, job_system);
+  culling_benchmarks(suite, job_system);
+  vertex_benchmarks(suite);
+  mesh_benchmarks(suite);
+  draw_sort_benchmarks(suite);
+  allocator_benchmarks(suite);
+}
+} // namespace bs::bench
@@ -0,0 +1,171 @@
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include "benchmark.hpp"
+
+#include <engine/jobs/job_system.hpp>
+#include <engine/renderer/renderer.hpp>
+
+#include <fmt/format.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace bs::engine;
+
+namespace bs::bench {
+namespace {
+// A cube with flat normals, `size` from its center to each face.
+types::Mesh cube(float size) {
+  types::Mesh mesh;
+  for (int axis = 0; axis < 3; axis++) {
+    for (float sign : {-1.f, 1.f}) {
+      glm::vec3 normal(0.f);
+      normal[axis] = sign;
+      glm::vec3 u(0.f);
+      u[(axis + 1) % 3] = 1.f;
+      glm::vec3 v = glm::cross(normal, u);
+      const glm::vec3 center = normal * size;
+      const glm::vec3 corners[4] = {
+          center + (-u - v) * size, center + (u - v) * size,
+          center + (u + v) * size, center + (-u + v) * size};
+      for (int corner : {0, 1, 2, 0, 2, 3}) {
+        mesh.vertices().push_back(
+            types::Vertex{.position = corners[corner], .normal = normal});
+      }
+    }
+  }
+  return mesh;
+}
+
+// Context exits the process when no device has the requested type, so the
+// benchmarks look for one first.
+bool has_device(std::optional<vk::PhysicalDeviceType> type) {
+  const vk::ApplicationInfo app_info{.apiVersion = VK_API_VERSION_1_3};
+  vk::Instance instance;
+  try {
+    instance = vk::createInstance(vk::InstanceCreateInfo{
+        .pApplicationInfo = &app_info,
+    });
+  } catch (vk::SystemError &) {
+    return false;
+  }
+  bool found = false;
+  for (vk::PhysicalDevice physical_device :
+       instance.enumeratePhysicalDevices()) {
+    found = found || !type ||
+            physical_device.getProperties().deviceType == *type;
+  }
+  instance.destroy();
+  return found;
+}
+
+void run_frames(Suite &suite, const char *name, bool gpu_driven) {
+  if (!suite.enabled(name))
+    return;
+  const Options &options = suite.options();
+  const std::optional<vk::PhysicalDeviceType> device_type =
+      options.any_device ? std::optional<vk::PhysicalDeviceType>()
+                         : vk::PhysicalDeviceType::eCpu;
+  if (!has_device(device_type)) {
+    fmt::print("  {0:<40} skipped, no {1}\n", name,
+               device_type ? "software Vulkan device, see --any-device"
+                           : "Vulkan device");
+    return;
+  }
+  jobs::JobSystem job_system(options.worker_threads);
+  renderer::Renderer renderer(
+      job_system,
+      context::ContextCreateInfo{
+          .headless = true,
+          .extent = vk::Extent2D{640, 360},
+          .device_type = device_type,
+      },
+      renderer::RendererCreateInfo{
+          // Compiling from scratch every run keeps disk state out of it.
+          .pipeline_cache_path = "",
+          .gpu_driven = gpu_driven,
+      });
+  if (gpu_driven && !renderer.gpu_driven()) {
+    fmt::print("  {0:<40} skipped, GPU-driven rendering is unavailable\n",
+               name);
+    return;
+  }
+
+  // 256 cube meshes of both vertex formats, each drawn 20 times through a
+  // box in front of the camera: 5120 draws a frame, about half of them
+  // visible.
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> position(-60.f, 60.f);
+  std::uniform_real_distribution<float> depth(-120.f, 0.f);
+  std::uniform_real_distribution<float> size(0.2f, 1.5f);
+  std::vector<types::MeshHandle> meshes;
+  for (uint32_t i = 0; i < 256; i++) {
+    types::Mesh mesh = cube(size(rng));
+    mesh.set_vertex_format(i % 2 == 0 ? types::VertexFormat::eFull
+                                      : types::VertexFormat::eQuantized);
+    meshes.push_back(renderer.add_mesh(std::move(mesh)));
+  }
+  renderer.uploader().wait(renderer.uploader().flush());
+  // Draws are skipped until their pipelines compile.
+  renderer.wait_for_pipelines();
+  std::vector<std::pair<types::MeshHandle, glm::mat4>> draws;
+  for (uint32_t i = 0; i < 20; i++) {
+    for (types::MeshHandle mesh : meshes) {
+      glm::mat4 transform(1.f);
+      transform[3] = glm::vec4(position(rng), position(rng), depth(rng), 1.f);
+      draws.emplace_back(mesh, transform);
+    }
+  }
+
+  // Right-handed perspective with 0..1 depth: 90 degree field of view,
+  // near 0.1 and far 100.
+  const float near = 0.1f;
+  const float far = 100.f;
+  types::CameraUBO &camera = renderer.camera()->camera_data();
+  camera.model = glm::mat4(1.f);
+  camera.view = glm::mat4(1.f);
+  camera.proj = glm::mat4(0.f);
+  camera.proj[0][0] = 360.f / 640.f;
+  camera.proj[1][1] = -1.f;
+  camera.proj[2][2] = far / (near - far);
+  camera.proj[2][3] = -1.f;
+  camera.proj[3][2] = far * near / (near - far);
+
+  const auto frame = [&]() {
+    for (const auto &[mesh, transform] : draws) {
+      renderer.draw(mesh, transform);
+    }
+    renderer.render();
+  };
+  for (uint32_t i = 0; i < options.warmup_frames; i++) {
+    frame();
+  }
+  // Waiting for idle rather than reading back keeps the image copy out of
+  // the timing, while the time still covers the GPU's work.
+  renderer.context()->device().waitIdle();
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < options.timed_frames; i++) {
+    frame();
+  }
+  renderer.context()->device().waitIdle();
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const double ms = elapsed.count() / options.timed_frames;
+  suite.add(Result{.name = name, .value = ms, .unit = "ms/frame"});
+  fmt::print("  {0:<40} {1:12.1f} fps on {2}\n", "", 1000.0 / ms,
+             renderer.context()
+                 ->physical_device()
+                 .getProperties()
+                 .deviceName.data());
+}
+} // namespace
+
+void run_frame_benchmarks(Suite &suite) {
+  fmt::print("Frame benchmarks, {0} frames after {1} warm-up frames:\n",
+             suite.options().timed_frames, suite.options().warmup_frames);
+  run_frames(suite, "frame/cpu_culled", false);
+  run_frames(suite, "frame/gpu_driven", true);
+}
+} // namespace bs::bench
@@ -0,0 +1,117 @@
+#include "benchmark.hpp"
+
+#include <fmt/format.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace bs;
+
+namespace {
+constexpr const char *usage =
+    "Usage: bench [options]\n"
+    "  --filter <text>      only run benchmarks whose name contains text\n"
+    "  --repeats <n>        timed runs per CPU benchmark (20)\n"
+    "  --threads <n>        job system workers, 0 for one per core (0)\n"
+    "  --frames <n>         timed frames per frame benchmark (200)\n"
+    "  --no-frames          skip the frame benchmarks\n"
+    "  --any-device         render on the first device, not a software one\n"
+    "  --json <path>        write the results as JSON\n"
+    "  --baseline <path>    compare against results saved with --json\n"
+    "  --threshold <ratio>  fail when slower than the baseline by more than\n"
+    "                       this, e.g. 0.1 for 10% (0.1)\n";
+
+std::string read_file(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw std::runtime_error(fmt::format("Can't open {0}", path));
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+void write_file(const std::string &path, const std::string &contents) {
+  std::ofstream file(path, std::ios::binary);
+  if (!(file << contents))
+    throw std::runtime_error(fmt::format("Can't write {0}", path));
+}
+} // namespace
+
+// Exits with 1 when a result regressed past the threshold and 2 on bad
+// arguments or files, so CI can gate on it.
+int main(int argc, char **argv) {
+  bench::Options options;
+  std::string json_path;
+  std::string baseline_path;
+  double threshold = 0.1;
+  try {
+    for (int i = 1; i < argc; i++) {
+      const std::string_view arg = argv[i];
+      const auto value = [&]() -> std::string {
+        if (i + 1 >= argc)
+          throw std::runtime_error(fmt::format("{0} needs a value", arg));
+        return argv[++i];
+      };
+      // A zero count would report the untouched best-of sentinel.
+      const auto count = [&]() -> uint32_t {
+        const unsigned long n = std::stoul(value());
+        if (n < 1)
+          throw std::runtime_error(fmt::format("{0} must be at least 1", arg));
+        return static_cast<uint32_t>(n);
+      };
+      if (arg == "--filter") {
+        options.filter = value();
+      } else if (arg == "--repeats") {
+        options.repeats = count();
+      } else if (arg == "--threads") {
+        options.worker_threads = std::stoul(value());
+      } else if (arg == "--frames") {
+        options.timed_frames = count();
+      } else if (arg == "--no-frames") {
+        options.frames = false;
+      } else if (arg == "--any-device") {
+        options.any_device = true;
+      } else if (arg == "--json") {
+        json_path = value();
+      } else if (arg == "--baseline") {
+        baseline_path = value();
+      } else if (arg == "--threshold") {
+        threshold = std::stod(value());
+      } else if (arg == "--help" || arg == "-h") {
+        fmt::print("{0}", usage);
+        return 0;
+      } else {
+        throw std::runtime_error(fmt::format("Unknown option {0}", arg));
+      }
+    }
+
+    // Read up front, so a bad baseline fails before minutes of running.
+    std::vector<bench::Result> baseline;
+    if (!baseline_path.empty())
+      baseline = bench::from_json(read_file(baseline_path));
+
+    bench::Suite suite(options);
+    bench::run_cpu_benchmarks(suite);
+    if (options.frames)
+      bench::run_frame_benchmarks(suite);
+
+    if (!json_path.empty())
+      write_file(json_path, bench::to_json(suite.results()));
+    if (!baseline_path.empty()) {
+      const uint32_t regressions =
+          bench::compare(baseline, suite.results(), threshold);
+      if (regressions > 0) {
+        fmt::print("{0} regressed\n", regressions);
+        return 1;
+      }
+    }
+  } catch (std::exception &err) {
+    fmt::print(stderr, "{0}\n{1}", err.what(), usage);
+    return 2;
+  }
+  return 0;
+}
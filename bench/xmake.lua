@@ -0,0 +1,7 @@
+target("bench")
+  set_kind("binary")
+  add_files("./**.cpp")
+  add_includedirs("../include/", "../external/vkfw/include/")
+  add_deps("bs_engine_cpp")
+  add_packages("vulkan-hpp", "vulkan-memory-allocator", "glm", "fmt")
+  add_cxflags("-g")
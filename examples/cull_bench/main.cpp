@@ -0,0 +1,82 @@
+#include <engine/culling/culling.hpp>
+#include <engine/jobs/job_system.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <random>
+#include <vector>
+
+using namespace bs::engine;
+
+namespace {
+// Best of `repeats` runs, in milliseconds.
+template <typename F> double time_best(uint32_t repeats, F &&f) {
+  double best = 1e30;
+  for (uint32_t i = 0; i < repeats; i++) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t count =
+      argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10))
+               : 200000;
+  const uint32_t repeats = 50;
+
+  // Spheres scattered through a box around a camera looking down -z; about
+  // a sixth of them end up in the frustum.
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> position(-100.f, 100.f);
+  std::uniform_real_distribution<float> radius(0.1f, 2.f);
+  culling::SphereSoA spheres;
+  spheres.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    spheres.push_back(glm::vec3(position(rng), position(rng), position(rng)),
+                      radius(rng));
+  }
+  // Right-handed perspective with 0..1 depth: 90 degree field of view,
+  // square aspect, near 0.1 and far 100.
+  const float near = 0.1f;
+  const float far = 100.f;
+  glm::mat4 projection(0.f);
+  projection[0][0] = 1.f;
+  projection[1][1] = -1.f;
+  projection[2][2] = far / (near - far);
+  projection[2][3] = -1.f;
+  projection[3][2] = far * near / (near - far);
+  const culling::Frustum frustum = culling::Frustum::from_matrix(projection);
+
+  fmt::print("Culling {0} spheres, best of {1} runs\n", count, repeats);
+  std::vector<uint32_t> visible(spheres.padded_size());
+  for (culling::CullKernel kernel :
+       {culling::CullKernel::eScalar, culling::CullKernel::eSse2,
+        culling::CullKernel::eAvx2}) {
+    if (kernel > culling::best_cull_kernel())
+      continue;
+    uint32_t visible_count = 0;
+    const double ms = time_best(repeats, [&]() {
+      visible_count = culling::cull_spheres(frustum, spheres, 0, count,
+                                            visible.data(), kernel);
+    });
+    fmt::print("  {0:<8} 1 thread   {1:8.3f}ms  {2:6.2f}ns/sphere  {3} "
+               "visible\n",
+               culling::cull_kernel_name(kernel), ms, ms * 1e6 / count,
+               visible_count);
+  }
+
+  jobs::JobSystem job_system;
+  const double ms = time_best(repeats, [&]() {
+    culling::cull_spheres(job_system, frustum, spheres, visible);
+  });
+  fmt::print("  {0:<8} {1} threads {2:8.3f}ms  {3:6.2f}ns/sphere  {4} "
+             "visible\n",
+             culling::cull_kernel_name(culling::best_cull_kernel()),
+             job_system.thread_count(), ms, ms * 1e6 / count, visible.size());
+}
@@ -0,0 +1,90 @@
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <engine/culling/culling.hpp>
+#include <engine/jobs/job_system.hpp>
+#include <engine/renderer/renderer.hpp>
+
+#include <cstdlib>
+#include <fmt/format.h>
+#include <random>
+#include <vector>
+
+using namespace bs::engine;
+
+// Renders a scattered field of small meshes headless with GPU-driven
+// culling and checks the number of draws the compute pass emitted against
+// the CPU culling of the same bounding spheres. Runs on any device with
+// drawIndirectCount, including lavapipe.
+int main(int argc, char **argv) {
+  const uint32_t count =
+      argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10))
+               : 10000;
+  const uint32_t frames = 3;
+
+  jobs::JobSystem job_system;
+  renderer::Renderer renderer(job_system, context::ContextCreateInfo{
+                                              .headless = true,
+                                          });
+  if (!renderer.gpu_driven()) {
+    fmt::print("GPU-driven rendering is unavailable on this device\n");
+    return 0;
+  }
+
+  // One triangle per mesh, scattered through a box around a camera looking
+  // down -z; both vertex formats are mixed in.
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> position(-100.f, 100.f);
+  std::uniform_real_distribution<float> size(0.1f, 2.f);
+  std::vector<types::MeshHandle> meshes;
+  culling::SphereSoA spheres;
+  spheres.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const glm::vec3 center(position(rng), position(rng), position(rng));
+    const float extent = size(rng);
+    types::Mesh mesh;
+    mesh.vertices() = {
+        {center + glm::vec3(-extent, -extent, 0.f), glm::vec3(0.f, 0.f, 1.f)},
+        {center + glm::vec3(extent, -extent, 0.f), glm::vec3(0.f, 0.f, 1.f)},
+        {center + glm::vec3(0.f, extent, 0.f), glm::vec3(0.f, 0.f, 1.f)},
+    };
+    mesh.set_vertex_format(i % 2 == 0 ? types::VertexFormat::eFull
+                                      : types::VertexFormat::eQuantized);
+    const types::MeshHandle handle = renderer.add_mesh(std::move(mesh));
+    const glm::vec4 sphere = renderer.mesh(handle)->bounding_sphere();
+    spheres.push_back(glm::vec3(sphere), sphere.w);
+    meshes.push_back(handle);
+  }
+  renderer.uploader().wait(renderer.uploader().flush());
+
+  // Right-handed perspective with 0..1 depth: 90 degree field of view,
+  // square aspect, near 0.1 and far 100.
+  const float near = 0.1f;
+  const float far = 100.f;
+  types::CameraUBO &camera = renderer.camera()->camera_data();
+  camera.model = glm::mat4(1.f);
+  camera.view = glm::mat4(1.f);
+  camera.proj = glm::mat4(0.f);
+  camera.proj[0][0] = 1.f;
+  camera.proj[1][1] = -1.f;
+  camera.proj[2][2] = far / (near - far);
+  camera.proj[2][3] = -1.f;
+  camera.proj[3][2] = far * near / (near - far);
+
+  std::vector<uint32_t> visible;
+  culling::cull_spheres(job_system, culling::Frustum::from_camera(camera),
+                        spheres, visible);
+
+  bool ok = true;
+  for (uint32_t frame = 0; frame < frames; frame++) {
+    for (types::MeshHandle mesh : meshes) {
+      renderer.draw(mesh);
+    }
+    renderer.render();
+    renderer.read_back();
+    const uint32_t gpu_visible = renderer.gpu_visible_count();
+    fmt::print("frame {0}: {1} of {2} visible, CPU reference {3}\n", frame,
+               gpu_visible, count, visible.size());
+    ok = ok && gpu_visible == visible.size();
+  }
+  fmt::print("{0}\n", ok ? "match" : "MISMATCH");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <engine/engine.hpp>
+
+#include <cstdlib>
+#include <fmt/format.h>
+
+int main(int argc, char **argv) {
+  const uint64_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 600;
+  bs::engine::Engine engine(bs::engine::EngineCreateInfo{
+      .context = {.headless = true},
+      .max_frames = frames,
+      .profile_trace_path = argc > 2 ? argv[2] : "",
+  });
+  engine.run();
+  fmt::print("{0:016x}\n", engine.renderer()->frame_checksum());
+}
@@ -0,0 +1,76 @@
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <engine/jobs/job_system.hpp>
+#include <engine/renderer/renderer.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <string_view>
+
+using namespace bs::engine;
+
+namespace {
+context::PresentPolicy parse_policy(std::string_view name) {
+  if (name == "adaptive")
+    return context::PresentPolicy::eAdaptive;
+  if (name == "low_latency")
+    return context::PresentPolicy::eLowLatency;
+  if (name == "uncapped")
+    return context::PresentPolicy::eUncapped;
+  return context::PresentPolicy::eThroughput;
+}
+} // namespace
+
+// Opens a 640x480 window with the given present policy (throughput,
+// adaptive, low_latency or uncapped), renders for a while, resizes the
+// window to 800x600 and checks that rendering carries on at the new size.
+// Prints the present mode picked and the input-to-present latency. Runs
+// under Xvfb with lavapipe.
+int main(int argc, char **argv) {
+  const context::PresentPolicy policy =
+      parse_policy(argc > 1 ? argv[1] : "throughput");
+  const uint32_t frames = 60;
+
+  jobs::JobSystem job_system;
+  renderer::Renderer renderer(job_system, context::ContextCreateInfo{
+                                              .extent = {640, 480},
+                                              .fullscreen = false,
+                                              .present_policy = policy,
+                                          });
+  context::Context &context = *renderer.context();
+  fmt::print("Policy {0}: {1}\n", context::present_policy_name(policy),
+             vk::to_string(context.present_mode()));
+
+  const auto render_frame = [&] {
+    vkfw::pollEvents();
+    renderer.set_input_time(std::chrono::steady_clock::now());
+    renderer.render();
+  };
+  for (uint32_t frame = 0; frame < frames; frame++) {
+    render_frame();
+  }
+
+  context.window().setSize(800, 600);
+  // The window manager may take a few frames to apply the new size.
+  bool resized = false;
+  for (uint32_t frame = 0; frame < frames * 4 && !resized; frame++) {
+    render_frame();
+    resized = context.extent().width == 800 && context.extent().height == 600;
+  }
+  for (uint32_t frame = 0; frame < frames; frame++) {
+    render_frame();
+  }
+
+  const renderer::LatencyStats &latency = renderer.latency_stats();
+  fmt::print("Extent {0}x{1}; input to {2} latency {3:.2f}ms mean, "
+             "{4:.2f}ms max over {5} frames\n",
+             context.extent().width, context.extent().height,
+             latency.present_wait ? "present" : "present call",
+             latency.frames > 0 ? latency.total_ms / latency.frames : 0.0,
+             latency.max_ms, latency.frames);
+  if (!resized) {
+    fmt::print("The swapchain was never recreated at the new size\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include <engine/scene/transform_hierarchy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <random>
+#include <vector>
+
+using namespace bs::engine;
+
+namespace {
+// Best of `repeats` runs, in milliseconds.
+template <typename F> double time_best(uint32_t repeats, F &&f) {
+  double best = 1e30;
+  for (uint32_t i = 0; i < repeats; i++) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+glm::mat4 random_transform(std::mt19937 &rng) {
+  std::uniform_real_distribution<float> offset(-10.f, 10.f);
+  std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+  glm::mat4 transform(scale(rng));
+  transform[3] = glm::vec4(offset(rng), offset(rng), offset(rng), 1.f);
+  return transform;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t count =
+      argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10))
+               : 100000;
+  const uint32_t repeats = 50;
+
+  // A forest of scene-like trees: a few hundred roots, most nodes a few
+  // levels down.
+  std::mt19937 rng(42);
+  scene::TransformHierarchy hierarchy;
+  std::vector<scene::TransformHierarchy::Handle> nodes;
+  nodes.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const scene::TransformHierarchy::Handle parent =
+        i < 256 ? scene::TransformHierarchy::Handle{}
+                : nodes[std::uniform_int_distribution<uint32_t>(
+                      i / 2, i - 1)(rng)];
+    nodes.push_back(hierarchy.create(parent, random_transform(rng),
+                                     glm::vec4(0.f, 0.f, 0.f, 1.f)));
+  }
+  hierarchy.update();
+  fmt::print("Updating {0} transforms in {1} levels, best of {2} runs\n",
+             count, hierarchy.depth_count(), repeats);
+
+  for (scene::TransformKernel kernel :
+       {scene::TransformKernel::eScalar, scene::TransformKernel::eSse2}) {
+    if (kernel > scene::best_transform_kernel())
+      continue;
+    uint32_t updated = 0;
+    const double ms = time_best(repeats, [&]() {
+      hierarchy.mark_all_dirty();
+      updated = hierarchy.update(kernel);
+    });
+    fmt::print("  {0:<8} all        {1:8.3f}ms  {2:6.2f}ns/node  {3} "
+               "updated\n",
+               scene::transform_kernel_name(kernel), ms, ms * 1e6 / count,
+               updated);
+  }
+
+  // The same scene with a fraction of the locals changing every frame; the
+  // time includes setting them.
+  for (double fraction : {0.01, 0.05}) {
+    const uint32_t changed = static_cast<uint32_t>(count * fraction);
+    std::vector<uint32_t> picks(changed);
+    std::vector<glm::mat4> locals(changed);
+    for (uint32_t i = 0; i < changed; i++) {
+      picks[i] = std::uniform_int_distribution<uint32_t>(0, count - 1)(rng);
+      locals[i] = random_transform(rng);
+    }
+    uint32_t updated = 0;
+    const double ms = time_best(repeats, [&]() {
+      for (uint32_t i = 0; i < changed; i++) {
+        hierarchy.set_local(nodes[picks[i]], locals[i]);
+      }
+      updated = hierarchy.update();
+    });
+    fmt::print("  {0:<8} {1:4.0f}% dirty {2:8.3f}ms  {3:6.2f}ns/node  {4} "
+               "updated\n",
+               scene::transform_kernel_name(scene::best_transform_kernel()),
+               fraction * 100, ms, ms * 1e6 / count, updated);
+  }
+
+  // Incremental updates have to land exactly where a full recompute with
+  // the same kernel does.
+  const scene::TransformHierarchy incremental = hierarchy;
+  hierarchy.mark_all_dirty();
+  hierarchy.update();
+  float max_error = 0.f;
+  for (scene::TransformHierarchy::Handle node : nodes) {
+    const glm::mat4 &a = incremental.world(node);
+    const glm::mat4 &b = hierarchy.world(node);
+    for (int column = 0; column < 4; column++) {
+      for (int row = 0; row < 4; row++) {
+        max_error =
+            std::max(max_error, std::abs(a[column][row] - b[column][row]));
+      }
+    }
+  }
+  fmt::print("Largest difference from a full recompute: {0}\n", max_error);
+  return max_error == 0.f ? 0 : 1;
+}
@@ -1,4 +1,7 @@
 #define VULKAN_HPP_NO_CONSTRUCTORS
 #include <engine/engine.hpp>
 
-int main() { bs::engine::Engine engine; }
+int main() {
+  bs::engine::Engine engine;
+  engine.run();
+}
@@ -5,3 +5,43 @@ target("triangle")
   add_deps("bs_engine_cpp")
   add_packages("vulkan-hpp", "vulkan-memory-allocator")
   add_cxflags("-g")
+
+target("headless")
+  set_kind("binary")
+  add_files("./headless/**.cpp")
+  add_includedirs("../include/", "../external/vkfw/include/")
+  add_deps("bs_engine_cpp")
+  add_packages("vulkan-hpp", "vulkan-memory-allocator", "fmt")
+  add_cxflags("-g")
+
+target("cull_bench")
+  set_kind("binary")
+  add_files("./cull_bench/**.cpp")
+  add_includedirs("../include/", "../external/vkfw/include/")
+  add_deps("bs_engine_cpp")
+  add_packages("glm", "fmt", "spdlog")
+  add_cxflags("-g")
+
+target("gpu_cull_check")
+  set_kind("binary")
+  add_files("./gpu_cull_check/**.cpp")
+  add_includedirs("../include/", "../external/vkfw/include/")
+  add_deps("bs_engine_cpp")
+  add_packages("vulkan-hpp", "vulkan-memory-allocator", "glm", "fmt")
+  add_cxflags("-g")
+
+target("transform_bench")
+  set_kind("binary")
+  add_files("./transform_bench/**.cpp")
+  add_includedirs("../include/", "../external/vkfw/include/")
+  add_deps("bs_engine_cpp")
+  add_packages("glm", "fmt")
+  add_cxflags("-g")
+
+target("swapchain_check")
+  set_kind("binary")
+  add_files("./swapchain_check/**.cpp")
+  add_includedirs("../include/", "../external/vkfw/include/")
+  add_deps("bs_engine_cpp")
+  add_packages("vulkan-hpp", "vulkan-memory-allocator", "fmt")
+  add_cxflags("-g")
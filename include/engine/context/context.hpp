@@ -1,14 +1,57 @@
 #pragma once
 
+#include <engine/types/buffer.hpp>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
 #include <vector>
 #include <vk_mem_alloc.hpp>
 #include <vkfw/vkfw.hpp>
 #include <vulkan/vulkan.hpp>
 
 namespace bs::engine::context {
+// How the swapchain trades latency against throughput. Each policy falls
+// back to the next mode listed when the surface lacks one; FIFO is always
+// available.
+enum class PresentPolicy : uint8_t {
+  // FIFO with three images: never tears and keeps the GPU busy, at up to
+  // two queued frames of latency.
+  eThroughput,
+  // FIFO_RELAXED, then FIFO: vsynced, but a late frame is shown at once and
+  // tears instead of waiting a whole refresh.
+  eAdaptive,
+  // MAILBOX with three images, so a newer frame replaces a queued one;
+  // then IMMEDIATE, then FIFO with two images.
+  eLowLatency,
+  // IMMEDIATE, then MAILBOX: frames are shown as soon as they're done and
+  // tear. For measuring.
+  eUncapped,
+};
+
+const char *present_policy_name(PresentPolicy policy);
+
+struct ContextCreateInfo {
+  // Headless contexts never touch the windowing system: no surface, no
+  // swapchain, and the color targets are plain VMA images.
+  bool headless = false;
+  // Zero means "use the primary monitor's video mode" when fullscreen (or
+  // 1280x720 windowed and headless).
+  vk::Extent2D extent{};
+  // Windowed contexts get a resizable window.
+  bool fullscreen = true;
+  PresentPolicy present_policy = PresentPolicy::eThroughput;
+  uint32_t offscreen_image_count = 2;
+  // Use the first physical device of this type, e.g. eCpu for a software
+  // rasterizer such as lavapipe; unset takes the first device. Without a
+  // match the Context fails to start like it does without any device.
+  std::optional<vk::PhysicalDeviceType> device_type;
+};
+
 class Context {
 public:
-  Context();
+  Context(const ContextCreateInfo &create_info = {});
   ~Context();
 
   Context(const Context &) = delete;
@@ -16,28 +59,95 @@ public:
   Context &operator=(const Context &) = delete;
   Context &operator=(Context &&) = delete;
 
-  vk::ShaderModule load_shader(std::string shader_path);
+  bool headless() const { return m_headless; }
+  vk::Extent2D extent() const { return m_extent; }
 
   vk::Instance &instance() { return m_instance; }
   vk::PhysicalDevice &physical_device() { return m_physical_device; }
   vk::Device &device() { return m_device; }
   vk::SurfaceKHR &surface() { return m_surface; }
   vk::SwapchainKHR &swapchain() { return m_swapchain; }
+  // In headless mode these are the offscreen color targets.
   std::vector<vk::Image> &swapchain_images() { return m_swapchain_images; }
   std::vector<vk::ImageView> &swapchain_image_views() {
     return m_swapchain_image_views;
   }
+  // queues()[0] renders, computes and presents.
   std::vector<vk::Queue> &queues() { return m_queues; }
+  uint32_t graphics_queue_family() const { return m_graphics_queue_family; }
+  // A compute family without graphics when the device has one, so compute
+  // work runs beside rendering; otherwise queues()[0].
+  vk::Queue &compute_queue() { return m_compute_queue; }
+  uint32_t compute_queue_family() const { return m_compute_queue_family; }
+  // The compute queue is separate from queues()[0]. Work handed between
+  // them needs a queue family ownership transfer.
+  bool async_compute() const {
+    return m_compute_queue_family != m_graphics_queue_family;
+  }
+  // A transfer-only family when the device has one, so uploads run beside
+  // rendering; otherwise another queue of a compute or the graphics family,
+  // or one of the other queues.
+  vk::Queue &transfer_queue() { return m_transfer_queue; }
+  uint32_t transfer_queue_family() const { return m_transfer_queue_family; }
+  // vk::Queue access must be externally synchronised. Accessors of queues
+  // that are the same queue return the same mutex.
+  std::mutex &graphics_queue_mutex() { return m_queue_mutexes[0]; }
+  std::mutex &compute_queue_mutex() { return *m_compute_queue_mutex; }
+  std::mutex &transfer_queue_mutex() { return *m_transfer_queue_mutex; }
   vk::Format color_attachment_format() { return m_color_attachment_format; }
-  std::vector<vk::Buffer> &buffers() { return m_buffers; }
+  vk::PresentModeKHR present_mode() const { return m_present_mode; }
+  // The window's current framebuffer size, which extent() lags behind
+  // until the swapchain is recreated. Zero while minimized.
+  vk::Extent2D framebuffer_extent();
+  // Recreates the swapchain at the window's current size. Nothing may be
+  // using it, and no image may be acquired.
+  // Returns false, keeping the old ones, while the window is minimized.
+  bool recreate_swapchain();
+  // VK_KHR_present_id and VK_KHR_present_wait are both enabled, so
+  // presents can carry an id (vk::PresentIdKHR) to wait for.
+  bool present_wait() const { return m_wait_for_present != nullptr; }
+  // vkWaitForPresentKHR on the current swapchain; eTimeout if the present
+  // with `present_id` isn't visible yet.
+  vk::Result wait_for_present(uint64_t present_id, uint64_t timeout);
+  // multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount are
+  // all enabled.
+  bool draw_indirect_count() const { return m_draw_indirect_count; }
   vma::Allocator &allocator() { return m_allocator; }
 
-  vk::Image &depth_image() { return m_depth_image; }
-  vk::ImageView &depth_image_view() { return m_depth_image_view; }
+  // Buffers live in a pool and are referenced by handle. Mapped buffers
+  // (eMapped) get their pointer recorded in types::Buffer::mapped. The pool
+  // isn't synchronised: create, destroy and look up buffers on the thread
+  // that renders.
+  types::BufferHandle
+  create_buffer(const vk::BufferCreateInfo &buffer_create_info,
+                const vma::AllocationCreateInfo &allocation_create_info);
+  types::Buffer *buffer(types::BufferHandle handle) {
+    return m_buffers.get(handle);
+  }
+  // The handle is invalid right away, but the buffer itself is only freed
+  // once the frame being recorded and `upload_value` on the uploader's
+  // timeline have completed, so in-flight work never loses it. Null and
+  // stale handles are ignored.
+  void destroy_buffer(types::BufferHandle handle, uint64_t upload_value = 0);
+  // Called by the renderer at the start of every frame, once the frames up
+  // to `completed_frame` are known to have finished on the GPU.
+  void begin_frame(uint64_t frame, uint64_t completed_frame,
+                   uint64_t completed_upload_value);
 
   vkfw::Window &window() { return m_window; }
 
 private:
+  void create_surface();
+  void create_swapchain(vk::SwapchainKHR old_swapchain = nullptr);
+  void create_offscreen_images(uint32_t image_count);
+
+  bool m_headless;
+  bool m_draw_indirect_count = false;
+  PresentPolicy m_present_policy;
+  vk::PresentModeKHR m_present_mode = vk::PresentModeKHR::eFifo;
+  PFN_vkWaitForPresentKHR m_wait_for_present = nullptr;
+  vk::Extent2D m_extent;
+
   vk::Instance m_instance;
   vk::PhysicalDevice m_physical_device;
   vk::Device m_device;
@@ -45,19 +155,32 @@ private:
   vk::SwapchainKHR m_swapchain;
   std::vector<vk::Image> m_swapchain_images;
   std::vector<vk::ImageView> m_swapchain_image_views;
+  std::vector<vma::Allocation> m_offscreen_image_allocations;
   std::vector<vk::Queue> m_queues;
+  uint32_t m_graphics_queue_family = 0;
+  vk::Queue m_compute_queue;
+  uint32_t m_compute_queue_family = 0;
+  vk::Queue m_transfer_queue;
+  uint32_t m_transfer_queue_family = 0;
+  // Graphics, compute and transfer. A queue that is also another one
+  // points at that one's mutex.
+  std::array<std::mutex, 3> m_queue_mutexes;
+  std::mutex *m_compute_queue_mutex = &m_queue_mutexes[0];
+  std::mutex *m_transfer_queue_mutex = &m_queue_mutexes[0];
 
   vk::Format m_color_attachment_format;
 
-  std::vector<vk::Buffer> m_buffers;
-  std::vector<vma::Allocation> m_buffer_allocations;
+  struct RetiredBuffer {
+    types::Buffer buffer;
+    uint64_t frame;
+    uint64_t upload_value;
+  };
+  types::Pool<types::Buffer> m_buffers;
+  std::vector<RetiredBuffer> m_retired_buffers;
+  uint64_t m_frame = 0;
 
   vma::Allocator m_allocator;
 
-  vk::Image m_depth_image;
-  vk::ImageView m_depth_image_view;
-  vma::Allocation m_depth_image_allocation;
-
   vkfw::Window m_window;
   GLFWvidmode m_video_mode;
 };
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <engine/jobs/job_system.hpp>
+#include <engine/types/camera_ubo.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace bs::engine::culling {
+// Planes with inward-facing unit normals: a point p is inside when
+// dot(plane.xyz, p) + plane.w >= 0 for every plane.
+struct Frustum {
+  std::array<glm::vec4, 6> planes;
+
+  // Gribb-Hartmann extraction for Vulkan's 0..1 clip depth. The planes are
+  // in whatever space `view_projection` transforms from.
+  static Frustum from_matrix(const glm::mat4 &view_projection);
+  // proj * view * model, so the planes are in the space of the camera's
+  // model matrix.
+  static Frustum from_camera(const types::CameraUBO &camera);
+
+  bool visible(const glm::vec3 &center, float radius) const;
+};
+
+// Sphere (center in xyz, radius in w) through an affine transform. The
+// radius grows by the largest axis scale, so the result still encloses
+// whatever the original did.
+glm::vec4 transform_sphere(const glm::mat4 &transform, const glm::vec4 &sphere);
+
+// Bounding spheres with one array per component, so the kernels load eight
+// of each at once. The arrays are padded to a multiple of batch_width with
+// spheres of radius -inf, which no frustum test accepts.
+class SphereSoA {
+public:
+  static constexpr uint32_t batch_width = 8;
+
+  uint32_t size() const { return m_size; }
+  // Size rounded up to a whole batch; the length of every array.
+  uint32_t padded_size() const { return static_cast<uint32_t>(m_x.size()); }
+  void clear();
+  void reserve(uint32_t count);
+  uint32_t push_back(const glm::vec3 &center, float radius);
+  void set(uint32_t index, const glm::vec3 &center, float radius);
+
+  const float *x() const { return m_x.data(); }
+  const float *y() const { return m_y.data(); }
+  const float *z() const { return m_z.data(); }
+  const float *radius() const { return m_radius.data(); }
+
+private:
+  std::vector<float> m_x;
+  std::vector<float> m_y;
+  std::vector<float> m_z;
+  std::vector<float> m_radius;
+  uint32_t m_size = 0;
+};
+
+enum class CullKernel : uint8_t {
+  eScalar,
+  // 4 spheres per iteration; baseline on x86-64.
+  eSse2,
+  // 8 spheres per iteration, picked at runtime when the CPU supports it.
+  eAvx2,
+};
+
+// Widest kernel this CPU runs.
+CullKernel best_cull_kernel();
+const char *cull_kernel_name(CullKernel kernel);
+
+// Writes the indices of the spheres in [begin, end) that intersect the
+// frustum to `visible`, in order, and returns how many there are. `begin`
+// must be a multiple of SphereSoA::batch_width and `visible` must have room
+// for end - begin rounded up to a whole batch, since the vector kernels
+// store full batches.
+uint32_t cull_spheres(const Frustum &frustum, const SphereSoA &spheres,
+                      uint32_t begin, uint32_t end, uint32_t *visible,
+                      CullKernel kernel = best_cull_kernel());
+
+// Same over every sphere, split across the job system. `visible` is
+// resized to the visible count.
+void cull_spheres(jobs::JobSystem &job_system, const Frustum &frustum,
+                  const SphereSoA &spheres, std::vector<uint32_t> &visible,
+                  CullKernel kernel = best_cull_kernel());
+} // namespace bs::engine::culling
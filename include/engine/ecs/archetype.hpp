@@ -0,0 +1,87 @@
+#pragma once
+
+#include <engine/ecs/component.hpp>
+#include <engine/ecs/entity.hpp>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace bs::engine::ecs {
+inline constexpr size_t chunk_bytes = 16 * 1024;
+inline constexpr size_t cache_line_size = 64;
+
+// All entities with exactly the same component set. Storage is a list of
+// fixed-size chunks; inside a chunk every component (and the entity ids)
+// is a separate cache-line aligned array, so queries stream contiguous
+// memory per component.
+class Archetype {
+public:
+  Archetype(ComponentMask mask);
+  ~Archetype();
+
+  Archetype(const Archetype &) = delete;
+  Archetype(Archetype &&) = delete;
+  Archetype &operator=(const Archetype &) = delete;
+  Archetype &operator=(Archetype &&) = delete;
+
+  ComponentMask mask() const { return m_mask; }
+  bool has(ComponentId id) const { return (m_mask >> id) & 1; }
+  const std::vector<ComponentId> &components() const { return m_components; }
+
+  uint32_t size() const { return m_count; }
+  uint32_t chunk_capacity() const { return m_chunk_capacity; }
+  uint32_t chunk_count() const {
+    return (m_count + m_chunk_capacity - 1) / m_chunk_capacity;
+  }
+  uint32_t chunk_size(uint32_t chunk) const {
+    const uint32_t begin = chunk * m_chunk_capacity;
+    return m_count - begin < m_chunk_capacity ? m_count - begin
+                                              : m_chunk_capacity;
+  }
+
+  Entity *entities(uint32_t chunk) {
+    return reinterpret_cast<Entity *>(m_chunks[chunk]);
+  }
+  template <typename T> T *column(uint32_t chunk) {
+    return reinterpret_cast<T *>(m_chunks[chunk] +
+                                 m_offsets[m_columns[component_id<T>()]]);
+  }
+
+  Entity entity(uint32_t row) {
+    return entities(row / m_chunk_capacity)[row % m_chunk_capacity];
+  }
+  void *component(ComponentId id, uint32_t row) {
+    const uint32_t column = m_columns[id];
+    return m_chunks[row / m_chunk_capacity] + m_offsets[column] +
+           (row % m_chunk_capacity) * m_column_sizes[column];
+  }
+
+  // Appends an uninitialised row; the caller constructs every component.
+  uint32_t allocate_row(Entity entity);
+  // Destroys the row's components and fills the hole with the last row.
+  // Returns the entity that now lives at `row`, or an invalid entity if
+  // the removed row was the last one.
+  Entity remove_row(uint32_t row);
+
+  // Cached transitions, so adding or removing a component is O(1) after
+  // the first time an archetype pair is seen.
+  Archetype *&add_edge(ComponentId id) { return m_add_edges[id]; }
+  Archetype *&remove_edge(ComponentId id) { return m_remove_edges[id]; }
+
+private:
+  ComponentMask m_mask;
+  std::vector<ComponentId> m_components;
+  std::array<uint8_t, max_components> m_columns{};
+  // Byte offset of each column inside a chunk; column 0 is the entity ids.
+  std::vector<size_t> m_offsets;
+  std::vector<size_t> m_column_sizes;
+
+  uint32_t m_chunk_capacity = 0;
+  uint32_t m_count = 0;
+  std::vector<std::byte *> m_chunks;
+
+  std::array<Archetype *, max_components> m_add_edges{};
+  std::array<Archetype *, max_components> m_remove_edges{};
+};
+} // namespace bs::engine::ecs
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace bs::engine::ecs {
+using ComponentId = uint32_t;
+// One bit per component type; archetypes are keyed by their mask.
+using ComponentMask = uint64_t;
+
+inline constexpr uint32_t max_components = 64;
+
+struct ComponentInfo {
+  size_t size;
+  size_t alignment;
+  void (*move_construct)(void *dst, void *src);
+  void (*destroy)(void *component);
+  const char *name;
+};
+
+ComponentId register_component(const ComponentInfo &info);
+const ComponentInfo &component_info(ComponentId id);
+
+template <typename T> void move_construct_component(void *dst, void *src) {
+  new (dst) T(std::move(*static_cast<T *>(src)));
+}
+template <typename T> void destroy_component(void *component) {
+  static_cast<T *>(component)->~T();
+}
+
+template <typename T> ComponentId component_id() {
+  using Component = std::remove_cvref_t<T>;
+  if constexpr (!std::is_same_v<T, Component>) {
+    // Keep one registration per type regardless of cv-qualification.
+    return component_id<Component>();
+  } else {
+    static const ComponentId id = register_component(ComponentInfo{
+        .size = sizeof(Component),
+        .alignment = alignof(Component),
+        .move_construct = &move_construct_component<Component>,
+        .destroy = &destroy_component<Component>,
+        .name = typeid(Component).name(),
+    });
+    return id;
+  }
+}
+
+template <typename... Ts> ComponentMask component_mask() {
+  return (ComponentMask{0} | ... | (ComponentMask{1} << component_id<Ts>()));
+}
+} // namespace bs::engine::ecs
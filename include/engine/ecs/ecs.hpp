@@ -1,7 +1,23 @@
 #pragma once
 
+#include <engine/ecs/archetype.hpp>
+#include <engine/ecs/component.hpp>
+#include <engine/ecs/entity.hpp>
+#include <engine/jobs/job_system.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <shared_mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
 namespace bs::engine::ecs {
+// Archetype-based entity/component store. Structural changes (create,
+// destroy, add, remove) must not happen while a query is iterating.
 class ECS {
+public:
   ECS();
   ~ECS();
 
@@ -9,5 +25,170 @@ class ECS {
   ECS(ECS &&) = delete;
   ECS &operator=(const ECS &) = delete;
   ECS &operator=(ECS &&) = delete;
+
+  Entity create();
+  void destroy(Entity entity);
+  bool alive(Entity entity) const {
+    return entity.index < m_records.size() &&
+           m_records[entity.index].generation == entity.generation &&
+           m_records[entity.index].archetype != nullptr;
+  }
+  uint32_t size() const { return m_alive_count; }
+
+  template <typename T, typename... Args> T &add(Entity entity, Args &&...args);
+  template <typename T> void remove(Entity entity);
+  template <typename T> T *get(Entity entity);
+  template <typename T> bool has(Entity entity) const {
+    return alive(entity) &&
+           m_records[entity.index].archetype->has(component_id<T>());
+  }
+
+  // Archetypes containing every component in `mask`. The list is cached and
+  // kept up to date as archetypes appear, so repeated queries only hash the
+  // mask once per call. Safe to call from several systems at once.
+  const std::vector<Archetype *> &query(ComponentMask mask);
+  template <typename... Ts> const std::vector<Archetype *> &query() {
+    return query(component_mask<Ts...>());
+  }
+
+  // f(uint32_t count, const Entity *entities, Ts *...columns) per chunk.
+  template <typename... Ts, typename F> void each_chunk(F &&f);
+  // f(Ts &...) or f(Entity, Ts &...) per entity.
+  template <typename... Ts, typename F> void each(F &&f);
+
+  // Same callbacks as above, with the matching chunks split across the job
+  // system's threads. f must be safe to call concurrently.
+  template <typename... Ts, typename F>
+  void parallel_each_chunk(jobs::JobSystem &job_system, F &&f);
+  template <typename... Ts, typename F>
+  void parallel_each(jobs::JobSystem &job_system, F &&f);
+
+private:
+  struct EntityRecord {
+    Archetype *archetype = nullptr;
+    uint32_t row = 0;
+    uint32_t generation = 0;
+  };
+
+  Archetype *find_or_create_archetype(ComponentMask mask);
+  Archetype *archetype_with(Archetype *archetype, ComponentId id);
+  Archetype *archetype_without(Archetype *archetype, ComponentId id);
+  // Moves every component the target shares with the source. Components
+  // only the target has are left for the caller to construct.
+  void move_entity(Entity entity, Archetype *target);
+  void remove_row(Archetype *archetype, uint32_t row);
+
+  std::vector<EntityRecord> m_records;
+  std::vector<uint32_t> m_free_indices;
+  uint32_t m_alive_count = 0;
+
+  std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> m_archetypes;
+  std::unordered_map<ComponentMask, std::vector<Archetype *>> m_queries;
+  std::shared_mutex m_queries_mutex;
+  Archetype *m_root;
 };
+
+template <typename T, typename... Args>
+T &ECS::add(Entity entity, Args &&...args) {
+  assert(alive(entity));
+  const ComponentId id = component_id<T>();
+  EntityRecord &record = m_records[entity.index];
+  if (record.archetype->has(id)) {
+    T *component =
+        static_cast<T *>(record.archetype->component(id, record.row));
+    *component = T{std::forward<Args>(args)...};
+    return *component;
+  }
+
+  move_entity(entity, archetype_with(record.archetype, id));
+  return *new (record.archetype->component(id, record.row))
+      T{std::forward<Args>(args)...};
+}
+
+template <typename T> void ECS::remove(Entity entity) {
+  assert(alive(entity));
+  const ComponentId id = component_id<T>();
+  EntityRecord &record = m_records[entity.index];
+  if (!record.archetype->has(id))
+    return;
+  move_entity(entity, archetype_without(record.archetype, id));
+}
+
+template <typename T> T *ECS::get(Entity entity) {
+  if (!alive(entity))
+    return nullptr;
+  const ComponentId id = component_id<T>();
+  EntityRecord &record = m_records[entity.index];
+  if (!record.archetype->has(id))
+    return nullptr;
+  return static_cast<T *>(record.archetype->component(id, record.row));
+}
+
+template <typename... Ts, typename F> void ECS::each_chunk(F &&f) {
+  for (Archetype *archetype : query<Ts...>()) {
+    const uint32_t chunk_count = archetype->chunk_count();
+    for (uint32_t chunk = 0; chunk < chunk_count; chunk++) {
+      f(archetype->chunk_size(chunk),
+        static_cast<const Entity *>(archetype->entities(chunk)),
+        archetype->template column<Ts>(chunk)...);
+    }
+  }
+}
+
+template <typename... Ts, typename F> void ECS::each(F &&f) {
+  each_chunk<Ts...>(
+      [&f](uint32_t count, const Entity *entities, Ts *...columns) {
+        for (uint32_t i = 0; i < count; i++) {
+          if constexpr (std::is_invocable_v<F &, Entity, Ts &...>) {
+            f(entities[i], columns[i]...);
+          } else {
+            f(columns[i]...);
+          }
+        }
+      });
+}
+
+template <typename... Ts, typename F>
+void ECS::parallel_each_chunk(jobs::JobSystem &job_system, F &&f) {
+  const std::vector<Archetype *> &archetypes = query<Ts...>();
+  // chunk_ends[i] is one past the last global chunk index of archetype i.
+  std::vector<uint32_t> chunk_ends;
+  chunk_ends.reserve(archetypes.size());
+  uint32_t chunk_total = 0;
+  for (Archetype *archetype : archetypes) {
+    chunk_total += archetype->chunk_count();
+    chunk_ends.push_back(chunk_total);
+  }
+
+  job_system.parallel_for(chunk_total, [&](uint32_t begin, uint32_t end) {
+    size_t index = std::upper_bound(chunk_ends.begin(), chunk_ends.end(),
+                                    begin) -
+                   chunk_ends.begin();
+    for (uint32_t global = begin; global < end; global++) {
+      while (global >= chunk_ends[index])
+        index++;
+      Archetype *archetype = archetypes[index];
+      const uint32_t chunk =
+          global - (chunk_ends[index] - archetype->chunk_count());
+      f(archetype->chunk_size(chunk),
+        static_cast<const Entity *>(archetype->entities(chunk)),
+        archetype->template column<Ts>(chunk)...);
+    }
+  });
+}
+
+template <typename... Ts, typename F>
+void ECS::parallel_each(jobs::JobSystem &job_system, F &&f) {
+  parallel_each_chunk<Ts...>(
+      job_system,
+      [&f](uint32_t count, const Entity *entities, Ts *...columns) {
+        for (uint32_t i = 0; i < count; i++) {
+          if constexpr (std::is_invocable_v<F &, Entity, Ts &...>) {
+            f(entities[i], columns[i]...);
+          } else {
+            f(columns[i]...);
+          }
+        }
+      });
+}
 } // namespace bs::engine::ecs
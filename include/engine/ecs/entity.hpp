@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace bs::engine::ecs {
+// The generation is bumped every time an index is recycled, so handles to
+// destroyed entities stop resolving instead of aliasing the new owner.
+struct Entity {
+  uint32_t index = UINT32_MAX;
+  uint32_t generation = 0;
+
+  bool operator==(const Entity &other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const Entity &other) const { return !(*this == other); }
+  bool valid() const { return index != UINT32_MAX; }
+};
+} // namespace bs::engine::ecs
+
+template <> struct std::hash<bs::engine::ecs::Entity> {
+  size_t operator()(const bs::engine::ecs::Entity &entity) const {
+    return std::hash<uint64_t>{}(
+        (static_cast<uint64_t>(entity.generation) << 32) | entity.index);
+  }
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <engine/ecs/component.hpp>
+#include <engine/ecs/ecs.hpp>
+#include <engine/jobs/job_system.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace bs::engine::ecs {
+// Access of a system that touches state outside the ECS; it is ordered
+// against every other system.
+inline constexpr ComponentMask exclusive_access = ~ComponentMask{0};
+
+struct SystemStats {
+  std::string name;
+  uint64_t last_ns = 0;
+  double average_ns = 0.0;
+  uint64_t max_ns = 0;
+  uint64_t runs = 0;
+};
+
+// Runs registered systems once per frame. Two systems conflict when one
+// writes a component the other reads or writes; conflicting systems run in
+// registration order, everything else runs concurrently on the job system.
+// Systems must not create or destroy entities or change their components.
+class Scheduler {
+public:
+  using SystemFunction = std::function<void(ECS &, jobs::JobSystem &)>;
+
+  Scheduler(ECS &ecs, jobs::JobSystem &job_system);
+  ~Scheduler();
+
+  Scheduler(const Scheduler &) = delete;
+  Scheduler(Scheduler &&) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+  Scheduler &operator=(Scheduler &&) = delete;
+
+  uint32_t add_system(std::string name, ComponentMask reads,
+                      ComponentMask writes, SystemFunction function);
+
+  // Per-entity system over every entity with Ts. const components are
+  // declared as reads, the rest as writes, and the query is split across
+  // worker threads chunk by chunk.
+  template <typename... Ts, typename F>
+  uint32_t add_each_system(std::string name, F f) {
+    return add_system(
+        std::move(name), component_mask<std::remove_const_t<Ts>...>(),
+        (ComponentMask{0} | ... |
+         (std::is_const_v<Ts> ? ComponentMask{0} : component_mask<Ts>())),
+        [f](ECS &ecs, jobs::JobSystem &job_system) {
+          ecs.parallel_each<Ts...>(job_system, f);
+        });
+  }
+
+  void set_enabled(uint32_t system, bool enabled) {
+    m_systems[system]->enabled = enabled;
+  }
+
+  // Builds the dependency graph for the enabled systems and runs them. The
+  // calling thread executes jobs until the last system has finished.
+  void run();
+
+  std::vector<SystemStats> stats() const;
+  // Logs the slowest systems by average time.
+  void log_stats(uint32_t count = 10) const;
+
+private:
+  struct System {
+    std::string name;
+    ComponentMask reads;
+    ComponentMask writes;
+    SystemFunction function;
+    bool enabled = true;
+
+    std::vector<uint32_t> successors;
+    uint32_t dependency_count = 0;
+    std::atomic<uint32_t> remaining_dependencies{0};
+
+    SystemStats stats;
+  };
+
+  static bool conflicts(const System &a, const System &b);
+  void build_graph();
+  void launch(uint32_t system, jobs::Counter &counter);
+  void execute(uint32_t system, jobs::Counter &counter);
+
+  ECS &m_ecs;
+  jobs::JobSystem &m_job_system;
+  std::vector<std::unique_ptr<System>> m_systems;
+};
+} // namespace bs::engine::ecs
@@ -1,12 +1,29 @@
 #pragma once
 
 #include <engine/context/context.hpp>
+#include <engine/ecs/ecs.hpp>
+#include <engine/ecs/scheduler.hpp>
+#include <engine/jobs/job_system.hpp>
 #include <engine/renderer/renderer.hpp>
 
+#include <cstdint>
+#include <string>
+
 namespace bs::engine {
+struct EngineCreateInfo {
+  context::ContextCreateInfo context{};
+  renderer::RendererCreateInfo renderer{};
+  // Zero spawns one worker per remaining hardware thread.
+  uint32_t worker_threads = 0;
+  // Stop after this many frames; zero runs until the window is closed.
+  uint64_t max_frames = 0;
+  // Written when run() returns if profiling is compiled in.
+  std::string profile_trace_path;
+};
+
 class Engine {
 public:
-  Engine();
+  Engine(const EngineCreateInfo &create_info = {});
   ~Engine();
 
   Engine(const Engine &) = delete;
@@ -14,10 +31,28 @@ public:
   Engine &operator=(const Engine &) = delete;
   Engine &operator=(Engine &&) = delete;
 
+  std::unique_ptr<jobs::JobSystem> &job_system() { return m_job_system; }
+  std::unique_ptr<ecs::ECS> &ecs() { return m_ecs; }
+  std::unique_ptr<ecs::Scheduler> &scheduler() { return m_scheduler; }
+  std::unique_ptr<renderer::Renderer> &renderer() { return m_renderer; }
+  uint64_t frame_count() const { return m_frame_count; }
+
+  // Renders frames, running the scheduler's systems before each, until
+  // the window is closed or max_frames frames have been rendered. Add
+  // systems and entities before calling it.
+  void run();
+
 private:
-  void main_loop();
+  bool should_close();
 
+  std::unique_ptr<jobs::JobSystem> m_job_system;
+  std::unique_ptr<ecs::ECS> m_ecs;
+  std::unique_ptr<ecs::Scheduler> m_scheduler;
   std::unique_ptr<renderer::Renderer> m_renderer;
   std::unique_ptr<context::Context> &m_context;
+
+  uint64_t m_max_frames;
+  std::string m_profile_trace_path;
+  uint64_t m_frame_count = 0;
 };
 } // namespace bs::engine
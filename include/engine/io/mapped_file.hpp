@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace bs::engine::io {
+// Read-only view of a whole file. The pages are mapped lazily by the OS, so
+// opening is cheap and nothing is copied until the bytes are touched.
+class MappedFile {
+public:
+  MappedFile() = default;
+  // Throws std::runtime_error if the file can't be opened or mapped.
+  MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  const uint8_t *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  std::span<const uint8_t> bytes() const { return {m_data, m_size}; }
+  bool empty() const { return m_size == 0; }
+  // Hints that the whole file is about to be read, so the OS starts reading
+  // ahead instead of faulting pages in one at a time.
+  void will_need() const;
+
+private:
+  void close();
+
+  const uint8_t *m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  void *m_file = nullptr;
+  void *m_mapping = nullptr;
+#endif
+};
+} // namespace bs::engine::io
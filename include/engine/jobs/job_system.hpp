@@ -0,0 +1,193 @@
+#pragma once
+
+#include <engine/jobs/work_stealing_deque.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bs::engine::jobs {
+inline constexpr size_t job_storage_size = 64;
+inline constexpr size_t jobs_per_thread = 4096;
+
+class Counter;
+
+// Jobs keep their callable inline, so scheduling never allocates unless a
+// thread's job ring is exhausted.
+struct Job {
+  void (*invoke)(void *storage) = nullptr;
+  void (*destroy)(void *storage) = nullptr;
+  Counter *counter = nullptr;
+  bool heap_allocated = false;
+  std::atomic<bool> in_use{false};
+  alignas(std::max_align_t) std::byte storage[job_storage_size];
+};
+
+// Counts unfinished jobs. Jobs scheduled with run_after() are parked on the
+// counter and released when it drops to zero.
+class Counter {
+public:
+  Counter() = default;
+  ~Counter() = default;
+
+  Counter(const Counter &) = delete;
+  Counter(Counter &&) = delete;
+  Counter &operator=(const Counter &) = delete;
+  Counter &operator=(Counter &&) = delete;
+
+  uint32_t value() const { return m_value.load(std::memory_order_acquire); }
+  bool done() const { return value() == 0; }
+
+private:
+  friend class JobSystem;
+
+  std::atomic<uint32_t> m_value{0};
+  std::mutex m_mutex;
+  std::vector<Job *> m_continuations;
+};
+
+class JobSystem {
+public:
+  // Zero workers means one per hardware thread besides the calling thread,
+  // which becomes thread 0 and participates whenever it waits.
+  JobSystem(uint32_t worker_count = 0);
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem(JobSystem &&) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+  JobSystem &operator=(JobSystem &&) = delete;
+
+  // Worker threads plus the owning thread.
+  uint32_t thread_count() const {
+    return static_cast<uint32_t>(m_threads.size());
+  }
+  // Index of the calling thread, or thread_count() for foreign threads.
+  uint32_t thread_index() const;
+
+  template <typename F> void run(F &&f, Counter *counter = nullptr) {
+    submit(make_job(std::forward<F>(f), counter));
+  }
+  // Schedules f once `dependency` has reached zero.
+  template <typename F>
+  void run_after(Counter &dependency, F &&f, Counter *counter = nullptr);
+
+  // Runs other jobs on the calling thread until the counter reaches zero.
+  void wait(Counter &counter);
+
+  // f(uint32_t begin, uint32_t end) over [0, count), split into batches of
+  // at least min_batch_size. Blocks (helping) until every batch is done.
+  template <typename F>
+  void parallel_for(uint32_t count, F &&f, uint32_t min_batch_size = 1);
+  // Non-blocking variant; f is copied into every batch job and the batches
+  // are tracked by `counter`.
+  template <typename F>
+  void parallel_for(uint32_t count, F f, Counter &counter,
+                    uint32_t min_batch_size = 1);
+
+  uint32_t batch_size(uint32_t count, uint32_t min_batch_size) const {
+    // A few batches per thread smooths out uneven batch costs.
+    const uint32_t batches = thread_count() * 4;
+    return std::max(min_batch_size, (count + batches - 1) / batches);
+  }
+
+private:
+  struct ThreadState {
+    ThreadState();
+
+    WorkStealingDeque<Job *> deque;
+    std::unique_ptr<Job[]> jobs;
+    uint32_t next_job = 0;
+  };
+
+  template <typename F> Job *make_job(F &&f, Counter *counter);
+  Job *allocate_job();
+  void submit(Job *job);
+  Job *find_job(uint32_t thread_index);
+  void execute(Job *job);
+  void finish(Counter &counter);
+  void worker_main(uint32_t thread_index);
+
+  std::vector<std::unique_ptr<ThreadState>> m_threads;
+  std::vector<std::thread> m_workers;
+
+  // Jobs from threads without a deque, or overflow from a full one.
+  std::mutex m_injection_mutex;
+  std::vector<Job *> m_injection_queue;
+  std::atomic<uint32_t> m_injection_size{0};
+
+  std::atomic<uint32_t> m_pending{0};
+  std::atomic<uint32_t> m_sleeping{0};
+  std::atomic<bool> m_stop{false};
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_wake;
+};
+
+template <typename F> Job *JobSystem::make_job(F &&f, Counter *counter) {
+  using Functor = std::decay_t<F>;
+  static_assert(sizeof(Functor) <= job_storage_size,
+                "Job callable too large, capture by reference or pointer");
+  static_assert(alignof(Functor) <= alignof(std::max_align_t));
+
+  Job *job = allocate_job();
+  new (job->storage) Functor(std::forward<F>(f));
+  job->invoke = [](void *storage) { (*static_cast<Functor *>(storage))(); };
+  job->destroy = [](void *storage) {
+    static_cast<Functor *>(storage)->~Functor();
+  };
+  job->counter = counter;
+  if (counter != nullptr)
+    counter->m_value.fetch_add(1, std::memory_order_relaxed);
+  return job;
+}
+
+template <typename F>
+void JobSystem::run_after(Counter &dependency, F &&f, Counter *counter) {
+  Job *job = make_job(std::forward<F>(f), counter);
+  {
+    std::lock_guard lock(dependency.m_mutex);
+    if (dependency.m_value.load(std::memory_order_acquire) != 0) {
+      dependency.m_continuations.push_back(job);
+      return;
+    }
+  }
+  submit(job);
+}
+
+template <typename F>
+void JobSystem::parallel_for(uint32_t count, F &&f, uint32_t min_batch_size) {
+  if (count == 0)
+    return;
+  const uint32_t batch = batch_size(count, min_batch_size);
+  if (batch >= count) {
+    f(0u, count);
+    return;
+  }
+  Counter counter;
+  for (uint32_t begin = batch; begin < count; begin += batch) {
+    const uint32_t end = std::min(begin + batch, count);
+    run([&f, begin, end]() { f(begin, end); }, &counter);
+  }
+  // The caller takes the first batch itself instead of queueing it.
+  f(0u, batch);
+  wait(counter);
+}
+
+template <typename F>
+void JobSystem::parallel_for(uint32_t count, F f, Counter &counter,
+                             uint32_t min_batch_size) {
+  const uint32_t batch = batch_size(count, min_batch_size);
+  for (uint32_t begin = 0; begin < count; begin += batch) {
+    const uint32_t end = std::min(begin + batch, count);
+    run([f, begin, end]() { f(begin, end); }, &counter);
+  }
+}
+} // namespace bs::engine::jobs
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace bs::engine::jobs {
+// Fixed-capacity Chase-Lev deque (Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models"). The owning thread pushes and pops
+// at the bottom, any other thread steals from the top.
+template <typename T> class WorkStealingDeque {
+public:
+  WorkStealingDeque(size_t capacity)
+      : m_mask(capacity - 1), m_items(std::make_unique<std::atomic<T>[]>(
+                                  capacity)) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    assert((capacity & m_mask) == 0 && "Capacity must be a power of two");
+  }
+  ~WorkStealingDeque() = default;
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque(WorkStealingDeque &&) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(WorkStealingDeque &&) = delete;
+
+  // Owner only. Returns false when the deque is full.
+  bool push(T item) {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+    if (bottom - top > static_cast<int64_t>(m_mask))
+      return false;
+    m_items[bottom & m_mask].store(item, std::memory_order_relaxed);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Owner only.
+  bool pop(T &out) {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+    out = m_items[bottom & m_mask].load(std::memory_order_relaxed);
+    if (top == bottom) {
+      // Last item: race the thieves for it.
+      const bool won = m_top.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread.
+  bool steal(T &out) {
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+      return false;
+    out = m_items[top & m_mask].load(std::memory_order_relaxed);
+    return m_top.compare_exchange_strong(top, top + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed);
+  }
+
+  bool empty() const {
+    return m_top.load(std::memory_order_relaxed) >=
+           m_bottom.load(std::memory_order_relaxed);
+  }
+
+private:
+  alignas(64) std::atomic<int64_t> m_top{0};
+  alignas(64) std::atomic<int64_t> m_bottom{0};
+  size_t m_mask;
+  std::unique_ptr<std::atomic<T>[]> m_items;
+};
+} // namespace bs::engine::jobs
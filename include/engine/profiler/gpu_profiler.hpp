@@ -0,0 +1,84 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+#include <engine/profiler/profiler.hpp>
+
+#include <array>
+#include <vector>
+
+namespace bs::engine::profiler {
+inline constexpr uint32_t max_gpu_zones_per_frame = 64;
+
+// Timestamp queries, one pool per frame slot. Results of a slot are read
+// back the next time the slot is used, after its fence has been waited on,
+// so reading them never stalls.
+class GpuProfiler {
+public:
+  GpuProfiler(context::Context &context, uint32_t frames_in_flight);
+  ~GpuProfiler();
+
+  GpuProfiler(const GpuProfiler &) = delete;
+  GpuProfiler(GpuProfiler &&) = delete;
+  GpuProfiler &operator=(const GpuProfiler &) = delete;
+  GpuProfiler &operator=(GpuProfiler &&) = delete;
+
+  bool enabled() const { return m_timestamp_valid_bits != 0; }
+
+  // Publishes the previous results of frame_slot and opens the frame zone.
+  void begin_frame(vk::CommandBuffer command_buffer, uint32_t frame_slot,
+                   uint64_t frame_index);
+  // Must be recorded right before the command buffer is ended and submitted.
+  void end_frame(vk::CommandBuffer command_buffer);
+
+  uint32_t begin_zone(vk::CommandBuffer command_buffer, const char *name);
+  void end_zone(vk::CommandBuffer command_buffer, uint32_t zone);
+
+private:
+  struct SlotData {
+    vk::QueryPool query_pool;
+    uint64_t frame_index = 0;
+    uint64_t submit_ns = 0;
+    uint32_t zone_count = 0;
+    std::array<const char *, max_gpu_zones_per_frame> names{};
+    bool pending = false;
+  };
+
+  void collect(SlotData &slot);
+
+  context::Context &m_context;
+  float m_timestamp_period = 0.f;
+  uint32_t m_timestamp_valid_bits = 0;
+  std::vector<SlotData> m_slots;
+  SlotData *m_current = nullptr;
+};
+
+class ScopedGpuZone {
+public:
+  ScopedGpuZone(GpuProfiler *profiler, vk::CommandBuffer command_buffer,
+                const char *name)
+      : m_profiler(profiler), m_command_buffer(command_buffer),
+        m_zone(profiler ? profiler->begin_zone(command_buffer, name) : 0) {}
+  ~ScopedGpuZone() {
+    if (m_profiler)
+      m_profiler->end_zone(m_command_buffer, m_zone);
+  }
+
+  ScopedGpuZone(const ScopedGpuZone &) = delete;
+  ScopedGpuZone(ScopedGpuZone &&) = delete;
+  ScopedGpuZone &operator=(const ScopedGpuZone &) = delete;
+  ScopedGpuZone &operator=(ScopedGpuZone &&) = delete;
+
+private:
+  GpuProfiler *m_profiler;
+  vk::CommandBuffer m_command_buffer;
+  uint32_t m_zone;
+};
+} // namespace bs::engine::profiler
+
+#ifdef BS_ENGINE_PROFILING
+#define BS_PROFILE_GPU_ZONE(profiler, command_buffer, name)                    \
+  ::bs::engine::profiler::ScopedGpuZone BS_PROFILE_CONCAT(                     \
+      bs_profile_gpu_zone_, __LINE__)(profiler, command_buffer, name)
+#else
+#define BS_PROFILE_GPU_ZONE(profiler, command_buffer, name) ((void)0)
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bs::engine::profiler {
+inline constexpr uint32_t max_zones_per_frame = 256;
+inline constexpr uint32_t frame_history = 64;
+
+uint64_t now_ns();
+uint32_t current_thread_id();
+
+struct Zone {
+  const char *name = nullptr;
+  uint64_t start_ns = 0;
+  uint64_t end_ns = 0;
+  uint32_t thread_id = 0;
+};
+
+struct FrameRecord {
+  uint64_t frame_index = 0;
+  uint64_t start_ns = 0;
+  uint64_t end_ns = 0;
+  uint32_t thread_id = 0;
+  uint32_t zone_count = 0;
+  std::array<Zone, max_zones_per_frame> zones{};
+};
+
+// Single writer, any number of readers. Readers retry a slot if the writer
+// lapped them mid-copy, so neither side ever blocks.
+class FrameRing {
+public:
+  FrameRing() = default;
+  ~FrameRing() = default;
+
+  FrameRing(const FrameRing &) = delete;
+  FrameRing(FrameRing &&) = delete;
+  FrameRing &operator=(const FrameRing &) = delete;
+  FrameRing &operator=(FrameRing &&) = delete;
+
+  void push(const FrameRecord &record);
+  // Oldest first, at most frame_history entries.
+  std::vector<FrameRecord> snapshot() const;
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    FrameRecord record;
+  };
+
+  std::array<Slot, frame_history> m_slots;
+  std::atomic<uint64_t> m_write_index{0};
+};
+
+class Profiler {
+public:
+  static Profiler &get();
+
+  Profiler(const Profiler &) = delete;
+  Profiler(Profiler &&) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+  Profiler &operator=(Profiler &&) = delete;
+
+  void begin_frame();
+  // Every zone of the frame must be closed by the time this is called.
+  void end_frame();
+  uint64_t frame_index() const { return m_current.frame_index; }
+
+  uint32_t begin_zone(const char *name);
+  void end_zone(uint32_t zone);
+
+  // GPU results arrive frames_in_flight frames late, so they are published
+  // separately with the CPU timestamp the frame was submitted at.
+  void publish_gpu_frame(const FrameRecord &record) {
+    m_gpu_frames.push(record);
+  }
+
+  FrameRing &cpu_frames() { return m_cpu_frames; }
+  FrameRing &gpu_frames() { return m_gpu_frames; }
+
+  // Chrome trace event format, loadable in chrome://tracing and Perfetto.
+  bool export_chrome_trace(const std::string &path) const;
+
+private:
+  Profiler() = default;
+  ~Profiler() = default;
+
+  FrameRecord m_current;
+  std::atomic<uint32_t> m_zone_count{0};
+  uint64_t m_next_frame_index = 0;
+
+  FrameRing m_cpu_frames;
+  FrameRing m_gpu_frames;
+};
+
+class ScopedZone {
+public:
+  ScopedZone(const char *name) : m_zone(Profiler::get().begin_zone(name)) {}
+  ~ScopedZone() { Profiler::get().end_zone(m_zone); }
+
+  ScopedZone(const ScopedZone &) = delete;
+  ScopedZone(ScopedZone &&) = delete;
+  ScopedZone &operator=(const ScopedZone &) = delete;
+  ScopedZone &operator=(ScopedZone &&) = delete;
+
+private:
+  uint32_t m_zone;
+};
+} // namespace bs::engine::profiler
+
+#define BS_PROFILE_CONCAT_INNER(a, b) a##b
+#define BS_PROFILE_CONCAT(a, b) BS_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef BS_ENGINE_PROFILING
+#define BS_PROFILE_ZONE(name)                                                  \
+  ::bs::engine::profiler::ScopedZone BS_PROFILE_CONCAT(bs_profile_zone_,       \
+                                                       __LINE__)(name)
+#define BS_PROFILE_FRAME_BEGIN()                                               \
+  ::bs::engine::profiler::Profiler::get().begin_frame()
+#define BS_PROFILE_FRAME_END()                                                 \
+  ::bs::engine::profiler::Profiler::get().end_frame()
+#else
+#define BS_PROFILE_ZONE(name) ((void)0)
+#define BS_PROFILE_FRAME_BEGIN() ((void)0)
+#define BS_PROFILE_FRAME_END() ((void)0)
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace bs::engine::renderer {
+struct BindlessHeapCreateInfo {
+  // Clamped to the device's update-after-bind limits, including the
+  // per-stage limit on all three together.
+  uint32_t storage_buffers = 4096;
+  uint32_t sampled_images = 4096;
+  uint32_t samplers = 256;
+};
+
+// Hands out indices [0, capacity), reusing freed ones first, so a
+// resource's index stays the same for as long as it's registered.
+class IndexAllocator {
+public:
+  explicit IndexAllocator(uint32_t capacity) : m_capacity(capacity) {}
+
+  // Throws std::runtime_error when every index is taken.
+  uint32_t allocate();
+  void free(uint32_t index) { m_free.push_back(index); }
+  uint32_t capacity() const { return m_capacity; }
+
+private:
+  uint32_t m_capacity;
+  uint32_t m_next = 0;
+  std::vector<uint32_t> m_free;
+};
+
+// One update-after-bind descriptor set holding every storage buffer,
+// sampled image and sampler the renderer's shaders read, each kind in its
+// own runtime-sized array. It is bound once per pass; shaders pick
+// resources by the indices they get in push constants, so switching
+// resources between draws never touches descriptors. Entries are partially
+// bound: indices nothing was added at may not be accessed, but needn't be
+// valid. Render thread only.
+class BindlessHeap {
+public:
+  static constexpr uint32_t storage_buffer_binding = 0;
+  static constexpr uint32_t sampled_image_binding = 1;
+  static constexpr uint32_t sampler_binding = 2;
+
+  BindlessHeap(context::Context &context,
+               const BindlessHeapCreateInfo &create_info);
+  ~BindlessHeap();
+
+  BindlessHeap(const BindlessHeap &) = delete;
+  BindlessHeap(BindlessHeap &&) = delete;
+  BindlessHeap &operator=(const BindlessHeap &) = delete;
+  BindlessHeap &operator=(BindlessHeap &&) = delete;
+
+  // Each returns the resource's index in its array.
+  uint32_t add_storage_buffer(vk::Buffer buffer, vk::DeviceSize offset = 0,
+                              vk::DeviceSize range = VK_WHOLE_SIZE);
+  uint32_t add_sampled_image(
+      vk::ImageView image_view,
+      vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+  uint32_t add_sampler(vk::Sampler sampler);
+  // The index is handed out again once the frame being recorded has
+  // completed, so in-flight draws never see it change.
+  void remove_storage_buffer(uint32_t index);
+  void remove_sampled_image(uint32_t index);
+  void remove_sampler(uint32_t index);
+  // Called by the renderer along with Context::begin_frame().
+  void begin_frame(uint64_t frame, uint64_t completed_frame);
+
+  vk::DescriptorSetLayout layout() const { return m_layout; }
+  vk::DescriptorSet set() const { return m_set; }
+
+private:
+  struct RetiredIndex {
+    uint32_t binding;
+    uint32_t index;
+    uint64_t frame;
+  };
+
+  IndexAllocator &allocator(uint32_t binding);
+  void retire(uint32_t binding, uint32_t index);
+
+  context::Context &m_context;
+  vk::DescriptorSetLayout m_layout;
+  vk::DescriptorPool m_pool;
+  vk::DescriptorSet m_set;
+  // Indexed by binding.
+  std::vector<IndexAllocator> m_allocators;
+  std::vector<RetiredIndex> m_retired;
+  uint64_t m_frame = 0;
+};
+} // namespace bs::engine::renderer
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <engine/types/mesh.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace bs::engine::renderer {
+// 64-bit draw sort key, most significant field first, so sorting the keys
+// groups draws by pipeline, then material, then mesh, and orders each
+// mesh's instances front to back:
+//   63..56 pipeline, 55..40 material, 39..20 mesh slot, 19..0 depth.
+namespace draw_key {
+inline constexpr uint32_t depth_bits = 20;
+inline constexpr uint32_t mesh_bits = 20;
+inline constexpr uint32_t material_bits = 16;
+inline constexpr uint32_t pipeline_bits = 8;
+inline constexpr uint32_t mesh_shift = depth_bits;
+inline constexpr uint32_t material_shift = mesh_shift + mesh_bits;
+inline constexpr uint32_t pipeline_shift = material_shift + material_bits;
+
+static_assert(mesh_bits == types::MeshHandle::index_bits);
+
+// Distance along the view direction, clamped to [0, inf). Non-negative
+// floats order like their bit patterns, so the top bits keep the order.
+uint32_t quantize_depth(float depth);
+
+inline uint64_t make(uint32_t pipeline, uint32_t material, uint32_t mesh,
+                     uint32_t depth) {
+  return uint64_t{pipeline} << pipeline_shift |
+         uint64_t{material} << material_shift | uint64_t{mesh} << mesh_shift |
+         depth;
+}
+// Everything but the depth: draws with equal batches can be instanced.
+inline uint64_t batch(uint64_t key) { return key >> depth_bits; }
+inline uint32_t pipeline(uint64_t key) {
+  return static_cast<uint32_t>(key >> pipeline_shift);
+}
+} // namespace draw_key
+
+struct DrawItem {
+  types::MeshHandle mesh;
+  // Reserved until the renderer has materials; only affects the order.
+  uint16_t material = 0;
+  glm::mat4 transform{1.f};
+};
+
+struct SortedDraw {
+  uint64_t key;
+  // Index into the draw list.
+  uint32_t item;
+};
+
+// Per-frame counters of the mesh pass.
+struct DrawStats {
+  // Items submitted, and those left after culling and upload checks.
+  uint32_t items = 0;
+  uint32_t visible = 0;
+  // Draw calls recorded, and how many instancing merged away.
+  uint32_t draws = 0;
+  uint32_t draws_saved = 0;
+  // Pipeline binds recorded, and how many drawing in submission order
+  // would have needed.
+  uint32_t pipeline_binds = 0;
+  uint32_t pipeline_binds_unsorted = 0;
+  // Secondary command buffers the draws were recorded into; zero when
+  // they were recorded inline.
+  uint32_t secondary_command_buffers = 0;
+};
+
+// Sorts by key with an LSD radix sort over 8-bit digits. Digits every key
+// shares are skipped, which with few pipelines and materials is most of
+// the high ones. Stable; `scratch` is resized as needed and reusable.
+void sort_draws(std::vector<SortedDraw> &draws,
+                std::vector<SortedDraw> &scratch);
+} // namespace bs::engine::renderer
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+#include <engine/types/buffer.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace bs::engine::renderer {
+struct FrameAllocation {
+  // Null when the frame's region is full.
+  void *mapped = nullptr;
+  // Offset into FrameAllocator::buffer().
+  uint32_t offset = 0;
+
+  explicit operator bool() const { return mapped != nullptr; }
+};
+
+// Linear allocator for data that lives for one frame: a single
+// persistently mapped, host-coherent buffer with a region per frame in
+// flight. Allocating bumps an offset through the current frame's region and
+// begin_frame() rewinds it once the slot's fence has signalled, so uniform
+// and per-draw data cost no buffer creation, no map/unmap and no flush.
+// Every allocation and region is aligned for use as a uniform or storage
+// buffer offset. Render thread only.
+class FrameAllocator {
+public:
+  FrameAllocator(context::Context &context, uint32_t frames_in_flight,
+                 vk::DeviceSize frame_size);
+  ~FrameAllocator();
+
+  FrameAllocator(const FrameAllocator &) = delete;
+  FrameAllocator(FrameAllocator &&) = delete;
+  FrameAllocator &operator=(const FrameAllocator &) = delete;
+  FrameAllocator &operator=(FrameAllocator &&) = delete;
+
+  // Rewinds the frame slot's region; its previous contents must no longer
+  // be in use by the GPU.
+  void begin_frame(uint32_t frame_index);
+  // Returns an empty allocation if the frame's region has no room left.
+  FrameAllocation allocate(vk::DeviceSize size);
+  // The same with a stricter alignment of up to 256 bytes, which then also
+  // holds relative to the region's start.
+  FrameAllocation allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+  template <typename T> FrameAllocation push(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const FrameAllocation allocation = allocate(sizeof(T));
+    if (allocation)
+      std::memcpy(allocation.mapped, &value, sizeof(T));
+    return allocation;
+  }
+
+  vk::Buffer buffer() const { return m_context.buffer(m_buffer)->buffer; }
+  vk::DeviceSize alignment() const { return m_alignment; }
+  vk::DeviceSize frame_size() const { return m_frame_size; }
+  // Start of the frame slot's region in buffer().
+  vk::DeviceSize frame_offset(uint32_t frame_index) const {
+    return m_frame_size * frame_index;
+  }
+  // Bytes handed out in the current frame, including alignment padding.
+  vk::DeviceSize used() const { return m_head - m_frame_begin; }
+
+private:
+  context::Context &m_context;
+  types::BufferHandle m_buffer;
+  uint8_t *m_mapped = nullptr;
+  vk::DeviceSize m_alignment;
+  vk::DeviceSize m_frame_size;
+  vk::DeviceSize m_frame_begin = 0;
+  vk::DeviceSize m_head = 0;
+};
+} // namespace bs::engine::renderer
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+#include <engine/culling/culling.hpp>
+#include <engine/renderer/pipeline_cache.hpp>
+#include <engine/renderer/shader_library.hpp>
+#include <engine/types/buffer.hpp>
+#include <engine/types/vertex.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace bs::engine::renderer {
+// One drawable, std430 as cull.comp.glsl and mesh.vert.glsl read it.
+struct GpuObject {
+  // Center in xyz and radius in w, in the space the frustum is in.
+  glm::vec4 sphere;
+  // types::MeshConstants of the mesh.
+  glm::vec4 position_scale;
+  glm::vec4 position_offset;
+  // Full-detail index range in the MeshArena.
+  uint32_t index_count;
+  uint32_t first_index;
+  int32_t vertex_offset;
+  uint32_t vertex_format;
+};
+static_assert(std::is_trivially_copyable_v<GpuObject> &&
+              sizeof(GpuObject) == 64);
+
+// Push constants of cull.comp.glsl.
+struct GpuCullConstants {
+  std::array<glm::vec4, 6> planes;
+  uint32_t object_count;
+  std::array<uint32_t, 2> command_base;
+};
+
+// Frustum culling on the GPU feeding multi-draw indirect. Each frame slot
+// has a host-written object buffer, a command buffer with one
+// VkDrawIndexedIndirectCommand slot per object and a draw count per vertex
+// format. The compute pass appends a command for every visible object to
+// its format's range and the draws consume them with
+// vkCmdDrawIndexedIndirectCount, so the CPU records one draw per format no
+// matter how many objects there are. Needs Context::draw_indirect_count().
+class GpuCulling {
+public:
+  // Throws std::runtime_error if the cull shader can't be loaded.
+  GpuCulling(context::Context &context, ShaderLibrary &shader_library,
+             PipelineCache &pipeline_cache, uint32_t frames_in_flight);
+  ~GpuCulling();
+
+  GpuCulling(const GpuCulling &) = delete;
+  GpuCulling(GpuCulling &&) = delete;
+  GpuCulling &operator=(const GpuCulling &) = delete;
+  GpuCulling &operator=(GpuCulling &&) = delete;
+
+  // Copies this frame's objects in, growing the slot's buffers if needed.
+  // The objects must be grouped by vertex format, `format_counts` of each
+  // in types::VertexFormat order. Returns true if object_buffer() was
+  // replaced, so descriptor sets referring to it need rewriting. Call once
+  // the slot's fence has signalled.
+  bool prepare(uint32_t frame_index, std::span<const GpuObject> objects,
+               const std::array<uint32_t, 2> &format_counts);
+  // Records the culling dispatch; outside dynamic rendering. The caller
+  // orders the draws, and any host read of the counts, after it: the
+  // dispatch writes draw_command_buffer() from the compute stage and
+  // draw_count_buffer() from the clear and compute stages.
+  void record_cull(vk::CommandBuffer command_buffer, uint32_t frame_index,
+                   const culling::Frustum &frustum);
+  // Queue family ownership transfer of the slot's command and count
+  // buffers, for culling on another family than the one that draws. The
+  // release goes after record_cull() on the culling queue and the acquire
+  // before the draws on the drawing queue, whose submission waits for the
+  // release's with a semaphore at eDrawIndirect. The acquire also makes the
+  // counts visible to the host. Culling discards what the buffers held, so
+  // they never need transferring back. The object buffer, which both
+  // families read every frame, is created concurrent instead.
+  void record_release(vk::CommandBuffer command_buffer, uint32_t frame_index,
+                      uint32_t src_family, uint32_t dst_family);
+  void record_acquire(vk::CommandBuffer command_buffer, uint32_t frame_index,
+                      uint32_t src_family, uint32_t dst_family);
+  // Records the format's indirect draw. The format's pipeline and the
+  // MeshArena's vertex and index buffers must be bound.
+  void record_draw(vk::CommandBuffer command_buffer, uint32_t frame_index,
+                   types::VertexFormat format);
+
+  // Objects of the format handed to the last prepare() of the slot.
+  uint32_t object_count(uint32_t frame_index,
+                        types::VertexFormat format) const {
+    return m_frames[frame_index].format_counts[static_cast<size_t>(format)];
+  }
+  // Never null, so it can always be bound.
+  vk::Buffer object_buffer(uint32_t frame_index) const;
+  vk::Buffer draw_command_buffer(uint32_t frame_index) const;
+  vk::Buffer draw_count_buffer(uint32_t frame_index) const;
+  // Objects found visible the last time the slot was culled, read back
+  // from the count buffer. Only meaningful once the slot's fence has
+  // signalled.
+  uint32_t visible_count(uint32_t frame_index) const;
+
+private:
+  struct Frame {
+    types::BufferHandle objects;
+    types::BufferHandle commands;
+    types::BufferHandle counts;
+    uint32_t capacity = 0;
+    uint32_t object_count = 0;
+    std::array<uint32_t, 2> format_counts{};
+    vk::DescriptorSet descriptor_set;
+  };
+
+  void allocate(Frame &frame, uint32_t capacity);
+  void write_descriptor_set(const Frame &frame);
+  // The release half of the transfer when `release`, else the acquire half.
+  void record_ownership_transfer(vk::CommandBuffer command_buffer,
+                                 uint32_t frame_index, uint32_t src_family,
+                                 uint32_t dst_family, bool release);
+
+  context::Context &m_context;
+  std::vector<Frame> m_frames;
+  vk::DescriptorSetLayout m_descriptor_set_layout;
+  vk::DescriptorPool m_descriptor_pool;
+  vk::PipelineLayout m_pipeline_layout;
+  vk::Pipeline m_pipeline;
+};
+} // namespace bs::engine::renderer
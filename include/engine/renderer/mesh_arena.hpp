@@ -0,0 +1,93 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+#include <engine/renderer/uploader.hpp>
+#include <engine/types/buffer.hpp>
+#include <engine/types/mesh.hpp>
+#include <engine/types/mesh_asset.hpp>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace bs::engine::renderer {
+struct MeshArenaCreateInfo {
+  // Per vertex format.
+  uint32_t vertex_capacity = 2 * 1024 * 1024;
+  uint32_t index_capacity = 8 * 1024 * 1024;
+};
+
+// First-fit allocator over [0, capacity) in arbitrary units. Freed ranges
+// merge with their free neighbours.
+class RangeAllocator {
+public:
+  explicit RangeAllocator(uint32_t capacity);
+
+  std::optional<uint32_t> allocate(uint32_t size);
+  void free(uint32_t offset, uint32_t size);
+
+private:
+  // Offset to size of every free range.
+  std::map<uint32_t, uint32_t> m_free;
+};
+
+// Shared geometry buffers for every mesh: one vertex buffer per vertex
+// format and one 32-bit index buffer. Meshes get a MeshRange of them
+// instead of buffers of their own, so any number of meshes of one format
+// draw from a single binding, which is what lets one indirect draw cover
+// them all. The buffers don't grow; uploads past the capacity throw
+// std::runtime_error. Render thread only.
+class MeshArena {
+public:
+  MeshArena(context::Context &context, Uploader &uploader,
+            const MeshArenaCreateInfo &create_info);
+  ~MeshArena();
+
+  MeshArena(const MeshArena &) = delete;
+  MeshArena(MeshArena &&) = delete;
+  MeshArena &operator=(const MeshArena &) = delete;
+  MeshArena &operator=(MeshArena &&) = delete;
+
+  // Allocates the mesh's range and queues its vertices, encoded in the
+  // mesh's vertex_format(), and indices.
+  void upload(types::Mesh &mesh);
+  // Same for a mesh of a mapped asset. The blobs are copied from the
+  // mapping straight into the staging ring, 16-bit indices being widened
+  // on the way, so the asset can be dropped once this returns.
+  void upload(types::Mesh &mesh, const types::MeshAssetView &asset);
+  // The range is reused once the frame being recorded and the mesh's
+  // upload have completed.
+  void free(const types::Mesh &mesh);
+  // Called by the renderer along with Context::begin_frame().
+  void begin_frame(uint64_t frame, uint64_t completed_frame,
+                   uint64_t completed_upload_value);
+
+  vk::Buffer vertex_buffer(types::VertexFormat format) const;
+  vk::Buffer index_buffer() const;
+
+private:
+  struct RetiredRange {
+    types::VertexFormat format;
+    types::MeshRange range;
+    uint64_t frame;
+    uint64_t upload_value;
+  };
+
+  // Throws std::runtime_error when either buffer is out of space.
+  types::MeshRange allocate(types::VertexFormat format, uint32_t vertex_count,
+                            uint32_t index_count);
+  void release(types::VertexFormat format, const types::MeshRange &range);
+
+  context::Context &m_context;
+  Uploader &m_uploader;
+  // Indexed by types::VertexFormat.
+  std::array<types::BufferHandle, 2> m_vertex_buffers;
+  std::array<RangeAllocator, 2> m_vertex_ranges;
+  types::BufferHandle m_index_buffer;
+  RangeAllocator m_index_ranges;
+  std::vector<RetiredRange> m_retired;
+  uint64_t m_frame = 0;
+};
+} // namespace bs::engine::renderer
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace bs::engine::renderer {
+struct PipelineCacheStats {
+  uint32_t hits = 0;
+  uint32_t misses = 0;
+  uint64_t creation_ns = 0;
+  size_t loaded_bytes = 0;
+};
+
+// vk::PipelineCache persisted between runs. The file is only used when it
+// was written by the same vendor, device and driver; anything else,
+// including a truncated or corrupt file, starts from an empty cache.
+class PipelineCache {
+public:
+  // An empty path keeps the cache in memory only.
+  PipelineCache(context::Context &context, std::string path);
+  ~PipelineCache();
+
+  PipelineCache(const PipelineCache &) = delete;
+  PipelineCache(PipelineCache &&) = delete;
+  PipelineCache &operator=(const PipelineCache &) = delete;
+  PipelineCache &operator=(PipelineCache &&) = delete;
+
+  vk::PipelineCache &cache() { return m_cache; }
+  const PipelineCacheStats &stats() const { return m_stats; }
+
+  // Creates the pipeline through the cache and records whether the driver
+  // could reuse a cached binary. Safe to call from several threads.
+  vk::Pipeline create_graphics_pipeline(vk::GraphicsPipelineCreateInfo info);
+  vk::Pipeline create_compute_pipeline(vk::ComputePipelineCreateInfo info);
+
+  void log_stats() const;
+  // Writes to a temporary file and renames it over the old one, so a crash
+  // mid-write never leaves a half-written cache behind.
+  bool save();
+
+private:
+  struct FileHeader {
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    std::array<uint8_t, VK_UUID_SIZE> pipeline_cache_uuid;
+    std::array<uint8_t, VK_UUID_SIZE> driver_uuid;
+    uint32_t reserved;
+    uint64_t data_size;
+    uint64_t data_hash;
+  };
+
+  FileHeader expected_header() const;
+  std::vector<uint8_t> load();
+  void record(const vk::PipelineCreationFeedback &feedback);
+
+  context::Context &m_context;
+  std::string m_path;
+  vk::PipelineCache m_cache;
+  mutable std::mutex m_stats_mutex;
+  PipelineCacheStats m_stats;
+};
+} // namespace bs::engine::renderer
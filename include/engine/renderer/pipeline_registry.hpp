@@ -0,0 +1,119 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+#include <engine/renderer/pipeline_cache.hpp>
+#include <engine/renderer/shader_library.hpp>
+#include <engine/types/vertex.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace bs::engine::renderer {
+inline constexpr uint32_t max_specialization_constants = 4;
+
+// Everything a graphics pipeline is built from. The rest is fixed:
+// triangle lists, a clockwise front face, LessOrEqual depth, no blending,
+// and dynamic viewport and scissor.
+struct GraphicsPipelineState {
+  const Shader *vertex_shader = nullptr;
+  const Shader *fragment_shader = nullptr;
+  vk::PipelineLayout layout;
+  // Constant ids 0 to specialization_count - 1, given to both stages; a
+  // stage ignores the ids it doesn't declare. Entries past the count must
+  // stay zero so equal states compare equal.
+  uint32_t specialization_count = 0;
+  std::array<uint32_t, max_specialization_constants> specialization{};
+  // Unset for pipelines that read no vertex buffers.
+  std::optional<types::VertexFormat> vertex_format;
+  vk::CullModeFlags cull_mode = vk::CullModeFlagBits::eBack;
+  bool depth_test = true;
+  bool depth_write = true;
+  vk::Format color_format = vk::Format::eUndefined;
+  vk::Format depth_format = vk::Format::eUndefined;
+
+  bool operator==(const GraphicsPipelineState &) const = default;
+};
+
+struct GraphicsPipelineStateHash {
+  size_t operator()(const GraphicsPipelineState &state) const;
+};
+
+// Index of a requested pipeline; the default is invalid.
+struct PipelineId {
+  uint32_t index = UINT32_MAX;
+  explicit operator bool() const { return index != UINT32_MAX; }
+};
+
+struct PipelineRegistryStats {
+  uint32_t requests = 0;
+  uint32_t unique_states = 0;
+  uint32_t compiled = 0;
+  uint32_t failed = 0;
+  uint64_t compile_ns = 0;
+};
+
+// Compiles graphics pipelines on threads of its own, so a compile never
+// lands on the render thread while it helps the job system, and requests
+// return right away. Identical states share one pipeline, which stays null
+// until it's ready; callers skip what they would draw with it until then.
+class PipelineRegistry {
+public:
+  // The cache, and the shaders and layouts of every requested state, must
+  // outlive the registry.
+  PipelineRegistry(context::Context &context, PipelineCache &pipeline_cache,
+                   uint32_t thread_count = 2);
+  // Drops the compiles that haven't started and waits for the rest.
+  ~PipelineRegistry();
+
+  PipelineRegistry(const PipelineRegistry &) = delete;
+  PipelineRegistry(PipelineRegistry &&) = delete;
+  PipelineRegistry &operator=(const PipelineRegistry &) = delete;
+  PipelineRegistry &operator=(PipelineRegistry &&) = delete;
+
+  PipelineId request(const GraphicsPipelineState &state);
+  // Null while compiling or if compiling failed. Safe from any thread.
+  vk::Pipeline get(PipelineId id) const;
+  bool ready(PipelineId id) const { return static_cast<bool>(get(id)); }
+  // Blocks until every request so far has compiled or failed.
+  void wait_idle();
+
+  PipelineRegistryStats stats() const;
+  void log_stats() const;
+
+private:
+  struct Entry {
+    GraphicsPipelineState state;
+    // Null until compiled.
+    vk::Pipeline pipeline;
+  };
+
+  void thread_main();
+  vk::Pipeline compile(const GraphicsPipelineState &state);
+
+  context::Context &m_context;
+  PipelineCache &m_pipeline_cache;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_idle;
+  // A deque, so entries stay put while compile threads read them.
+  std::deque<Entry> m_entries;
+  std::unordered_map<GraphicsPipelineState, uint32_t,
+                     GraphicsPipelineStateHash>
+      m_ids;
+  // Entries waiting for a thread, oldest first.
+  std::deque<uint32_t> m_queue;
+  uint32_t m_compiling = 0;
+  bool m_stop = false;
+  PipelineRegistryStats m_stats;
+  std::vector<std::thread> m_threads;
+};
+} // namespace bs::engine::renderer
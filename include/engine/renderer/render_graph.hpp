@@ -0,0 +1,258 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+#include <engine/profiler/gpu_profiler.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace bs::engine::renderer {
+// How a pass touches a resource. Reads and writes of a usage differ only in
+// their access flags.
+enum class ResourceUsage : uint8_t {
+  eColorAttachment,
+  eDepthAttachment,
+  // Sampled from any shader stage; read only.
+  eSampled,
+  // Storage image or buffer in any shader stage.
+  eStorage,
+  // Indirect draw or dispatch arguments; buffers only, read only.
+  eIndirect,
+  eTransfer,
+};
+
+// The stages and accesses that last used a resource before the graph runs,
+// or that will next use it after, and its image layout.
+struct ResourceState {
+  vk::PipelineStageFlags2 stages;
+  vk::AccessFlags2 access;
+  vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+};
+
+// Resources are referred to by index into the frame's graph, so these are
+// only valid until the next RenderGraph::begin_frame().
+struct GraphImage {
+  uint32_t index = UINT32_MAX;
+  explicit operator bool() const { return index != UINT32_MAX; }
+};
+struct GraphBuffer {
+  uint32_t index = UINT32_MAX;
+  explicit operator bool() const { return index != UINT32_MAX; }
+};
+
+struct TransientImageInfo {
+  vk::Format format = vk::Format::eUndefined;
+  vk::Extent2D extent;
+  vk::ImageUsageFlags usage;
+  vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor;
+
+  bool operator==(const TransientImageInfo &other) const {
+    return format == other.format && extent == other.extent &&
+           usage == other.usage && aspect == other.aspect;
+  }
+};
+
+// Of the last RenderGraph::compile().
+struct RenderGraphStats {
+  uint32_t passes = 0;
+  uint32_t culled_passes = 0;
+  // pipelineBarrier2 calls, and the barriers they carry. Buffer barriers
+  // of a batch are merged into one global memory barrier.
+  uint32_t barrier_batches = 0;
+  uint32_t image_barriers = 0;
+  uint32_t memory_barriers = 0;
+  uint32_t transient_images = 0;
+  // Memory backing the transient images, and what it would take without
+  // aliasing.
+  vk::DeviceSize transient_bytes = 0;
+  vk::DeviceSize unaliased_bytes = 0;
+};
+
+class RenderGraph;
+
+// Declares the resources a pass reads and writes. A pass may use a resource
+// several times, e.g. as a transfer and a storage write, but an image only
+// in one layout. A pass that keeps what an earlier one wrote, e.g. by
+// loading an attachment, has to read() it as well as write() it. Throws
+// std::runtime_error on uses that don't fit the resource.
+class PassBuilder {
+public:
+  PassBuilder &read(GraphImage image, ResourceUsage usage);
+  PassBuilder &write(GraphImage image, ResourceUsage usage);
+  PassBuilder &read(GraphBuffer buffer, ResourceUsage usage);
+  PassBuilder &write(GraphBuffer buffer, ResourceUsage usage);
+  // Keeps the pass even when nothing reads what it writes.
+  PassBuilder &side_effects();
+
+private:
+  friend class RenderGraph;
+  PassBuilder(RenderGraph &graph, uint32_t pass)
+      : m_graph(graph), m_pass(pass) {}
+
+  RenderGraph &m_graph;
+  uint32_t m_pass;
+};
+
+// The frame's passes and the resources they use, rebuilt every frame.
+// compile() drops passes whose writes nothing reads (imported resources
+// count as read), gives every transient image memory shared with the
+// transients whose lifetimes don't overlap its own, and works out the
+// synchronization2 barriers and layout transitions between passes: one
+// batch before each pass that needs any, and one after the last for the
+// imported resources' final states. execute() then records the passes in
+// declaration order. Transient images and the sync state of their memory
+// persist across frames, and are rebuilt only when the set of transients
+// or their lifetimes change. Render thread only.
+class RenderGraph {
+public:
+  using PassFunction = std::function<void(vk::CommandBuffer)>;
+
+  explicit RenderGraph(context::Context &context);
+  ~RenderGraph();
+
+  RenderGraph(const RenderGraph &) = delete;
+  RenderGraph(RenderGraph &&) = delete;
+  RenderGraph &operator=(const RenderGraph &) = delete;
+  RenderGraph &operator=(RenderGraph &&) = delete;
+
+  // Clears the graph for the frame and frees transient images retired by
+  // frames up to `completed_frame`.
+  void begin_frame(uint64_t frame, uint64_t completed_frame);
+
+  // `initial` is the state the image is in when the frame's commands run
+  // and `final` the one execute() leaves it in; an undefined final layout
+  // keeps the layout of the last pass. Names must outlive the frame.
+  GraphImage import_image(const char *name, vk::Image image,
+                          vk::ImageView image_view, vk::ImageAspectFlags aspect,
+                          const ResourceState &initial,
+                          const ResourceState &final);
+  GraphBuffer import_buffer(const char *name, vk::Buffer buffer,
+                            const ResourceState &initial = {},
+                            const ResourceState &final = {});
+  // Owned by the graph; its contents don't survive the frame.
+  GraphImage create_image(const char *name, const TransientImageInfo &info);
+  // Passes run in the order they're added.
+  PassBuilder add_pass(const char *name, PassFunction record);
+
+  // Once every pass is added.
+  void compile();
+  // Once per compile(), outside dynamic rendering. Each pass gets a GPU
+  // zone named after it when `profiler` isn't null.
+  void execute(vk::CommandBuffer command_buffer,
+               profiler::GpuProfiler *profiler = nullptr);
+
+  // Transient images are valid from compile() on.
+  vk::Image image(GraphImage image) const;
+  vk::ImageView image_view(GraphImage image) const;
+
+  const RenderGraphStats &stats() const { return m_stats; }
+
+private:
+  friend class PassBuilder;
+
+  // What a pass does with one resource.
+  struct Use {
+    uint32_t resource;
+    vk::PipelineStageFlags2 stages;
+    vk::AccessFlags2 access;
+    vk::ImageLayout layout;
+    bool read;
+    bool write;
+  };
+  struct Pass {
+    const char *name;
+    PassFunction record;
+    std::vector<Use> uses;
+    bool side_effects = false;
+    bool live = false;
+    // Ranges of m_image_barriers and m_memory_barriers recorded before the
+    // pass.
+    uint32_t image_barrier_begin = 0;
+    uint32_t image_barrier_count = 0;
+    uint32_t memory_barrier = UINT32_MAX;
+  };
+  struct Resource {
+    const char *name;
+    bool is_image;
+    bool imported;
+    vk::Image image;
+    vk::ImageView image_view;
+    vk::ImageAspectFlags aspect;
+    vk::Buffer buffer;
+    ResourceState initial;
+    ResourceState final;
+    TransientImageInfo info;
+    // Index into m_transients, for transient images.
+    uint32_t transient = UINT32_MAX;
+    // Live passes, in execution order, that first and last use it.
+    uint32_t first_use = UINT32_MAX;
+    uint32_t last_use = 0;
+  };
+  // Who must be waited for before a resource, or a block of transient
+  // memory, is next used.
+  struct SyncState {
+    // The last write, or the layout transition that replaced it.
+    vk::PipelineStageFlags2 write_stages;
+    vk::AccessFlags2 write_access;
+    // Stages that read since then.
+    vk::PipelineStageFlags2 read_stages;
+    // Where the last write has already been made visible.
+    vk::PipelineStageFlags2 visible_stages;
+    vk::AccessFlags2 visible_access;
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+    // The transient image the block's layout belongs to.
+    uint32_t owner = UINT32_MAX;
+  };
+  // A transient image of the current placement.
+  struct Transient {
+    TransientImageInfo info;
+    uint32_t first_use;
+    uint32_t last_use;
+    vk::Image image;
+    vk::ImageView image_view;
+    vk::DeviceSize size = 0;
+    uint32_t block = 0;
+  };
+  struct Block {
+    vma::Allocation allocation;
+    SyncState state;
+    vk::DeviceSize size = 0;
+  };
+  struct Retired {
+    std::vector<Transient> transients;
+    std::vector<Block> blocks;
+    uint64_t frame;
+  };
+
+  void use(uint32_t pass, uint32_t resource, ResourceUsage usage, bool write);
+  void cull_passes();
+  // Creates and places the transient images, reusing the previous frame's
+  // when nothing about them changed.
+  void place_transients();
+  void retire_transients();
+  void destroy(std::vector<Transient> &transients, std::vector<Block> &blocks);
+  // Adds the barrier `use` needs, if any, and advances `state` past it.
+  void sync(const Resource &resource, const Use &use, SyncState &state,
+            vk::MemoryBarrier2 &memory_barrier);
+  void record_barriers(vk::CommandBuffer command_buffer,
+                       uint32_t image_barrier_begin,
+                       uint32_t image_barrier_count, uint32_t memory_barrier);
+
+  context::Context &m_context;
+  uint64_t m_frame = 0;
+  std::vector<Pass> m_passes;
+  std::vector<Resource> m_resources;
+  std::vector<Transient> m_transients;
+  std::vector<Block> m_blocks;
+  std::vector<Retired> m_retired;
+
+  std::vector<vk::ImageMemoryBarrier2> m_image_barriers;
+  std::vector<vk::MemoryBarrier2> m_memory_barriers;
+  // Barriers recorded after the last pass.
+  uint32_t m_final_image_barrier_begin = 0;
+  uint32_t m_final_image_barrier_count = 0;
+  uint32_t m_final_memory_barrier = UINT32_MAX;
+  RenderGraphStats m_stats;
+};
+} // namespace bs::engine::renderer
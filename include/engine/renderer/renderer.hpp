@@ -2,13 +2,93 @@
 
 #include <engine/camera/camera.hpp>
 #include <engine/context/context.hpp>
+#include <engine/culling/culling.hpp>
+#include <engine/jobs/job_system.hpp>
+#include <engine/profiler/gpu_profiler.hpp>
+#include <engine/renderer/bindless_heap.hpp>
+#include <engine/renderer/draw_list.hpp>
+#include <engine/renderer/frame_allocator.hpp>
+#include <engine/renderer/gpu_culling.hpp>
+#include <engine/renderer/mesh_arena.hpp>
+#include <engine/renderer/pipeline_cache.hpp>
+#include <engine/renderer/pipeline_registry.hpp>
+#include <engine/renderer/render_graph.hpp>
+#include <engine/renderer/shader_library.hpp>
+#include <engine/renderer/thread_command_pools.hpp>
+#include <engine/renderer/uploader.hpp>
 #include <engine/types/camera_ubo.hpp>
+#include <engine/types/handle.hpp>
+#include <engine/types/mesh.hpp>
+#include <engine/types/model.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string>
 
 namespace bs::engine::renderer {
+struct RendererCreateInfo {
+  uint32_t frames_in_flight = 2;
+  // Empty keeps the pipeline cache in memory only.
+  std::string pipeline_cache_path = "pipeline_cache.bin";
+  // Threads compiling pipelines in the background. Draws whose pipeline is
+  // still compiling are skipped.
+  uint32_t pipeline_compile_threads = 2;
+  UploaderCreateInfo uploader{};
+  MeshArenaCreateInfo mesh_arena{};
+  BindlessHeapCreateInfo bindless_heap{};
+  // Per frame in flight, for the camera and the instance transforms.
+  vk::DeviceSize frame_allocator_size = 8 * 1024 * 1024;
+  // Cull on the GPU and draw every mesh of a vertex format with one
+  // indirect draw. Falls back to CPU culling and a draw per mesh when the
+  // device lacks drawIndirectCount or drawIndirectFirstInstance, or the
+  // cull shader is missing.
+  bool gpu_driven = true;
+  // Cull on the device's async compute queue, if it has one, so a frame's
+  // culling overlaps the previous frame's rendering.
+  bool async_compute = true;
+  // With at least this many instanced draws on the CPU-culled path, they
+  // are recorded on the job system's threads into secondary command
+  // buffers of at least draws_per_recording_job draws each. Zero always
+  // records them inline.
+  uint32_t parallel_recording_threshold = 2048;
+  uint32_t draws_per_recording_job = 512;
+};
+
+struct FrameData {
+  vk::CommandPool command_pool;
+  vk::CommandBuffer command_buffer;
+  vk::Fence fence;
+  vk::Semaphore image_available_semaphore;
+  // Null unless culling runs on the compute queue.
+  vk::CommandPool compute_command_pool;
+  vk::CommandBuffer compute_command_buffer;
+  // BindlessHeap indices of the slot's FrameAllocator region and GPU
+  // culling object buffer.
+  uint32_t frame_data_index = 0;
+  uint32_t object_buffer_index = 0;
+};
+
+// Time from the input a frame was built from to the frame reaching the
+// screen, over every frame measured.
+struct LatencyStats {
+  uint64_t frames = 0;
+  double total_ms = 0.0;
+  double min_ms = 0.0;
+  double max_ms = 0.0;
+  // Whether frames were timed until visible (VK_KHR_present_wait) rather
+  // than until vkQueuePresentKHR returned.
+  bool present_wait = false;
+};
+
 class Renderer {
 public:
-  Renderer();
+  Renderer(jobs::JobSystem &job_system,
+           const context::ContextCreateInfo &context_create_info = {},
+           const RendererCreateInfo &create_info = {});
   ~Renderer();
 
   Renderer(const Renderer &) = delete;
@@ -18,30 +98,208 @@ public:
 
   std::unique_ptr<camera::Camera> &camera() { return m_camera; }
   std::unique_ptr<context::Context> &context() { return m_context; }
+  jobs::JobSystem &job_system() { return m_job_system; }
+  ShaderLibrary &shader_library() { return *m_shader_library; }
+  PipelineRegistry &pipeline_registry() { return *m_pipeline_registry; }
+  Uploader &uploader() { return *m_uploader; }
+  MeshArena &mesh_arena() { return *m_mesh_arena; }
+  BindlessHeap &bindless_heap() { return *m_bindless_heap; }
+
+  // Uploads the mesh and takes ownership of it and its buffers.
+  types::MeshHandle add_mesh(types::Mesh mesh);
+  // Maps a mesh asset file and uploads every mesh in it.
+  types::Model load_model(const std::string &path);
+  types::Mesh *mesh(types::MeshHandle handle) { return m_meshes.get(handle); }
+  // The handle is invalid right away; the geometry is freed once no frame
+  // in flight can still be drawing it. Null and stale handles are ignored.
+  void destroy(types::MeshHandle handle);
+  void destroy(const types::Model &model);
 
+  // Queues the mesh for the next render(). Meshes outside the camera
+  // frustum, whose upload hasn't completed yet or whose pipeline is still
+  // compiling are skipped for that frame. Queued draws are sorted by
+  // pipeline, material and mesh, and draws of the same mesh become one
+  // instanced draw.
+  void draw(types::MeshHandle mesh,
+            const glm::mat4 &transform = glm::mat4(1.f)) {
+    m_draw_list.push_back(DrawItem{.mesh = mesh, .transform = transform});
+  }
+  void draw(const types::Model &model,
+            const glm::mat4 &transform = glm::mat4(1.f)) {
+    for (types::MeshHandle mesh : model.meshes()) {
+      draw(mesh, transform);
+    }
+  }
+  // Recreates the swapchain first when the window was resized or the old
+  // one went out of date, and skips the frame while the window is
+  // minimized. Must run on the thread that constructed the job system;
+  // throws std::runtime_error before touching the frame otherwise.
   void render();
+  // When the input the next render() is built from was read; defaults to
+  // the start of render().
+  void set_input_time(std::chrono::steady_clock::time_point time) {
+    m_input_time = time;
+  }
+
+  // Blocks until every pipeline requested so far has compiled, for tools
+  // that need their first frames complete.
+  void wait_for_pipelines() { m_pipeline_registry->wait_idle(); }
+
+  // Headless only: copies the most recently rendered image to host memory
+  // as tightly packed RGBA8 rows.
+  std::vector<uint8_t> read_back();
+  uint64_t frame_checksum();
+
+  uint32_t frames_in_flight() const {
+    return static_cast<uint32_t>(m_frames.size());
+  }
+  bool gpu_driven() const { return m_gpu_culling != nullptr; }
+  // Of the most recently recorded frame. On the GPU-driven path `visible`
+  // counts the objects handed to the cull pass.
+  const DrawStats &draw_stats() const { return m_draw_stats; }
+  // Per-frame averages since startup.
+  void log_draw_stats() const;
+  const LatencyStats &latency_stats() const { return m_latency_stats; }
+  void log_latency_stats() const;
+  // Meshes the GPU culling pass kept in the most recently submitted frame.
+  // Only valid once that frame has completed, e.g. after read_back().
+  uint32_t gpu_visible_count() const;
 
 private:
+  void create_frames(uint32_t frames_in_flight);
+  void create_render_finished_semaphores();
+  void destroy_render_finished_semaphores();
+  // Waits for the graphics queue to go idle first. Returns false while the
+  // window is minimized.
+  bool recreate_swapchain();
+  // Records the latency of every present that has become visible since the
+  // last call.
+  void poll_presents();
+  void record_latency(std::chrono::steady_clock::time_point input_time);
+  // Everything but the shaders, vertex format and layout is shared.
+  GraphicsPipelineState pipeline_state(const Shader &vertex_shader,
+                                       const Shader &fragment_shader,
+                                       vk::PipelineLayout layout) const;
+  void request_mesh_pipelines();
+  // Copies the sorted draws' transforms into the frame allocator. Drops
+  // every mesh draw of the frame if they don't fit.
+  void write_instances();
+  void bind_bindless_heap(vk::CommandBuffer command_buffer);
+  // With the mesh constants left at the identity.
+  types::DrawConstants draw_constants() const;
+  // Culls the draw list into m_visible_draws.
+  void cull_meshes();
+  // Culls, sorts and writes the instances of the draw list, and turns it
+  // into m_draw_runs.
+  void prepare_draws(uint64_t upload_value);
+  static void set_viewport(vk::CommandBuffer command_buffer,
+                           vk::Extent2D extent);
+  // The fullscreen triangle behind the meshes.
+  void record_background(vk::CommandBuffer command_buffer);
+  // Draw runs [begin, end), binding everything they use. Safe to call from
+  // several threads at once on different command buffers.
+  void record_draws(vk::CommandBuffer command_buffer, uint32_t begin,
+                    uint32_t end, DrawStats &stats);
+  // Batch `index` of record_draws_parallel(), runs [begin, end), into a
+  // secondary from the calling thread's pool. Null if the thread has none.
+  vk::CommandBuffer
+  record_secondary(const vk::CommandBufferInheritanceRenderingInfo &inheritance,
+                   vk::Extent2D extent, uint32_t index, uint32_t begin,
+                   uint32_t end);
+  // Records the draw runs into secondary command buffers on the job
+  // system's threads and executes them in order. Inside dynamic rendering
+  // begun with eContentsSecondaryCommandBuffers.
+  void record_draws_parallel(vk::CommandBuffer command_buffer,
+                             vk::Extent2D extent);
+  // Fills the GPU culling pass's object buffer from the draw list.
+  void prepare_gpu_objects(uint64_t upload_value);
+  void draw_meshes_indirect(vk::CommandBuffer command_buffer);
+  // Submits the frame's culling to the compute queue, signalling
+  // m_compute_timeline with the frame number.
+  void submit_async_cull(const culling::Frustum &frustum);
+
+  jobs::JobSystem &m_job_system;
   std::unique_ptr<context::Context> m_context;
   std::unique_ptr<camera::Camera> m_camera;
-  vk::Buffer m_camera_ubo;
-  vma::Allocation m_camera_ubo_allocation;
-
-  vk::CommandPool m_command_pool;
-  vk::CommandBuffer m_command_buffer;
+  // Only created when built with profiling enabled.
+  std::unique_ptr<profiler::GpuProfiler> m_gpu_profiler;
+  std::unique_ptr<PipelineCache> m_pipeline_cache;
+  std::unique_ptr<PipelineRegistry> m_pipeline_registry;
+  std::unique_ptr<ShaderLibrary> m_shader_library;
+  std::unique_ptr<Uploader> m_uploader;
+  std::unique_ptr<MeshArena> m_mesh_arena;
+  std::unique_ptr<FrameAllocator> m_frame_allocator;
+  std::unique_ptr<BindlessHeap> m_bindless_heap;
+  // Null unless GPU-driven rendering is enabled and supported.
+  std::unique_ptr<GpuCulling> m_gpu_culling;
+  // Null unless GPU culling runs on the compute queue.
+  vk::Semaphore m_compute_timeline;
+  std::unique_ptr<RenderGraph> m_render_graph;
+  std::unique_ptr<ThreadCommandPools> m_thread_command_pools;
 
-  std::vector<vk::ShaderModule> m_shader_modules;
+  std::vector<FrameData> m_frames;
+  uint32_t m_frame_index = 0;
+  std::vector<vk::Semaphore> m_render_finished_semaphores;
 
-  std::vector<vk::DescriptorSetLayoutBinding> m_descriptor_set_layout_bindings;
-  std::vector<vk::DescriptorSetLayout> m_descriptor_set_layout;
-  std::vector<vk::DescriptorSet> m_descriptor_sets;
   std::vector<vk::PipelineLayout> m_pipeline_layouts;
-  std::vector<vk::Pipeline> m_pipelines;
+  // The fullscreen triangle behind the meshes.
+  PipelineId m_background_pipeline;
+  // Indexed by types::VertexFormat; invalid if the mesh shaders are
+  // missing.
+  std::array<PipelineId, 2> m_mesh_pipelines{};
+  // The same with the gpu_driven specialization, for indirect draws.
+  std::array<PipelineId, 2> m_indirect_mesh_pipelines{};
+  // m_mesh_pipelines as of this frame's prepare_draws(), null while
+  // compiling, so every recording thread sees the same ones.
+  std::array<vk::Pipeline, 2> m_ready_mesh_pipelines{};
+  vk::ShaderStageFlags m_mesh_push_constant_stages;
+
+  types::Pool<types::Mesh> m_meshes;
+  std::vector<DrawItem> m_draw_list;
+  // Per draw list entry, in the space the frustum is in; rebuilt every
+  // frame.
+  culling::SphereSoA m_draw_spheres;
+  std::vector<uint32_t> m_visible_draws;
+  std::vector<SortedDraw> m_sorted_draws;
+  std::vector<SortedDraw> m_sort_scratch;
+  // One instanced draw: a run of equal batch keys in m_sorted_draws.
+  struct DrawRun {
+    const types::Mesh *mesh;
+    uint32_t format;
+    uint32_t first_instance;
+    uint32_t instance_count;
+  };
+  std::vector<DrawRun> m_draw_runs;
+  uint32_t m_parallel_recording_threshold = 0;
+  uint32_t m_draws_per_recording_job = 0;
+  // Per recording job, in draw order.
+  std::vector<vk::CommandBuffer> m_secondary_command_buffers;
+  std::vector<DrawStats> m_batch_stats;
+  DrawStats m_draw_stats;
+  DrawStats m_draw_stats_total;
+  uint64_t m_draw_stats_frames = 0;
+  // This frame's first instance transform, in mat4s from the start of its
+  // FrameAllocator region.
+  uint32_t m_instance_base = 0;
+  std::vector<GpuObject> m_gpu_objects;
+  // Frames are numbered from 1 in submission order.
+  uint64_t m_frame_number = 0;
 
-  vk::Semaphore m_render_semaphore;
-  vk::Semaphore m_present_semaphore;
-  vk::Fence m_fence;
+  uint32_t m_swapchain_image_index = 0;
+  // Set when acquire or present report the swapchain out of date or
+  // suboptimal.
+  bool m_swapchain_dirty = false;
+  // The window's size when the swapchain was last created; a change means
+  // it was resized.
+  vk::Extent2D m_framebuffer_extent;
 
-  uint32_t m_swapchain_image_index;
+  std::optional<std::chrono::steady_clock::time_point> m_input_time;
+  // Presents submitted with a present id and not yet seen to be visible.
+  struct PendingPresent {
+    uint64_t present_id;
+    std::chrono::steady_clock::time_point input_time;
+  };
+  std::deque<PendingPresent> m_pending_presents;
+  LatencyStats m_latency_stats;
 };
 } // namespace bs::engine::renderer
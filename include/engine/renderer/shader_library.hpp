@@ -0,0 +1,85 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+#include <engine/io/mapped_file.hpp>
+#include <engine/jobs/job_system.hpp>
+#include <engine/renderer/shader_reflection.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bs::engine::renderer {
+struct Shader {
+  // Hash of the SPIR-V words; identical binaries share one Shader, but
+  // different binaries may share a hash.
+  uint64_t hash = 0;
+  vk::ShaderModule module;
+  ShaderReflection reflection;
+};
+
+struct ShaderLibraryStats {
+  uint32_t files = 0;
+  uint32_t modules = 0;
+  size_t mapped_bytes = 0;
+  uint64_t load_ns = 0;
+};
+
+// Owns every vk::ShaderModule the renderer uses. SPIR-V files are
+// memory-mapped rather than read, and modules are keyed by content so
+// variants that compile to the same binary are only created once.
+class ShaderLibrary {
+public:
+  ShaderLibrary(context::Context &context, jobs::JobSystem &job_system);
+  ~ShaderLibrary();
+
+  ShaderLibrary(const ShaderLibrary &) = delete;
+  ShaderLibrary(ShaderLibrary &&) = delete;
+  ShaderLibrary &operator=(const ShaderLibrary &) = delete;
+  ShaderLibrary &operator=(ShaderLibrary &&) = delete;
+
+  // Maps, hashes, reflects and creates modules for every path not loaded
+  // yet, spread over the job system. Throws std::runtime_error naming the
+  // first file that failed once every job has finished.
+  void load(std::span<const std::string> paths);
+  const Shader &load(const std::string &path);
+
+  // Throws std::out_of_range if the path was never loaded.
+  const Shader &get(const std::string &path) const;
+  // The first finished shader with this hash, or null.
+  const Shader *find(uint64_t hash) const;
+
+  const ShaderLibraryStats &stats() const { return m_stats; }
+  void log_stats() const;
+
+private:
+  struct Entry {
+    Shader shader;
+    // The binary stays mapped and is compared on a hash hit, so a
+    // collision never shares a module. Clean file pages cost no memory
+    // the OS can't reclaim.
+    io::MappedFile file;
+    // Set by the job creating the module once it succeeds; a failed
+    // entry is erased instead.
+    bool ready = false;
+  };
+
+  // Returns an error message, or an empty string on success.
+  std::string load_file(const std::string &path);
+
+  context::Context &m_context;
+  jobs::JobSystem &m_job_system;
+
+  mutable std::mutex m_mutex;
+  // Signalled whenever a pending entry becomes ready or is erased.
+  std::condition_variable m_created;
+  // Entries never move, so paths can point into them.
+  std::unordered_multimap<uint64_t, Entry> m_shaders;
+  std::unordered_map<std::string, const Shader *> m_paths;
+  ShaderLibraryStats m_stats;
+};
+} // namespace bs::engine::renderer
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace bs::engine::renderer {
+struct DescriptorBinding {
+  uint32_t set = 0;
+  uint32_t binding = 0;
+  vk::DescriptorType type = vk::DescriptorType::eUniformBuffer;
+  // Zero for runtime-sized arrays.
+  uint32_t count = 1;
+  vk::ShaderStageFlags stages;
+};
+
+struct VertexInput {
+  uint32_t location = 0;
+  vk::Format format = vk::Format::eUndefined;
+};
+
+// What a pipeline layout and vertex input state need to know about a
+// module, read straight from the SPIR-V.
+struct ShaderReflection {
+  vk::ShaderStageFlagBits stage = vk::ShaderStageFlagBits::eVertex;
+  std::string entry_point;
+  // Sorted by set, then binding.
+  std::vector<DescriptorBinding> bindings;
+  std::vector<vk::PushConstantRange> push_constant_ranges;
+  // Vertex shaders only, sorted by location; built-ins are skipped.
+  std::vector<VertexInput> vertex_inputs;
+};
+
+// Throws std::runtime_error on malformed SPIR-V. Only the first entry point
+// is reflected.
+ShaderReflection reflect_spirv(std::span<const uint32_t> code);
+
+// Bindings of several stages merged into one list, with the stage flags of
+// bindings shared between stages combined.
+std::vector<DescriptorBinding>
+merge_bindings(std::span<const ShaderReflection *const> reflections);
+} // namespace bs::engine::renderer
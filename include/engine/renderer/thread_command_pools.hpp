@@ -0,0 +1,50 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+#include <engine/jobs/job_system.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace bs::engine::renderer {
+// Secondary command buffers for recording in jobs: a transient command pool
+// per job system thread and frame slot, so recording threads never share a
+// pool and never lock. Each thread's buffers are reused from frame to
+// frame; begin_frame() resets the slot's pools, which recycles them all.
+// The render thread records through thread 0's pools, so render() must run
+// on the thread that constructed the JobSystem.
+class ThreadCommandPools {
+public:
+  ThreadCommandPools(context::Context &context, jobs::JobSystem &job_system,
+                     uint32_t frames_in_flight);
+  ~ThreadCommandPools();
+
+  ThreadCommandPools(const ThreadCommandPools &) = delete;
+  ThreadCommandPools(ThreadCommandPools &&) = delete;
+  ThreadCommandPools &operator=(const ThreadCommandPools &) = delete;
+  ThreadCommandPools &operator=(ThreadCommandPools &&) = delete;
+
+  // On the render thread, once the slot's fence has signalled.
+  void begin_frame(uint32_t frame_index);
+  // On any of the job system's threads: a secondary command buffer from the
+  // calling thread's pool, begun to continue the dynamic rendering
+  // described by `inheritance`. The caller ends it. Null on a foreign
+  // thread, which has no pool.
+  vk::CommandBuffer
+  begin(const vk::CommandBufferInheritanceRenderingInfo &inheritance);
+
+private:
+  struct ThreadPool {
+    vk::CommandPool pool;
+    std::vector<vk::CommandBuffer> command_buffers;
+    // Buffers handed out this frame.
+    uint32_t used = 0;
+  };
+
+  context::Context &m_context;
+  jobs::JobSystem &m_job_system;
+  // thread_count() per frame slot, slot-major.
+  std::vector<ThreadPool> m_pools;
+  uint32_t m_frame_index = 0;
+};
+} // namespace bs::engine::renderer
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <engine/context/context.hpp>
+#include <engine/types/buffer.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace bs::engine::renderer {
+struct UploaderCreateInfo {
+  vk::DeviceSize staging_size = 32 * 1024 * 1024;
+};
+
+struct UploaderStats {
+  uint64_t bytes = 0;
+  uint32_t copies = 0;
+  uint32_t batches = 0;
+  // Times an upload had to wait for the ring to drain.
+  uint32_t stalls = 0;
+};
+
+// Streams data into device-local buffers through a persistently mapped
+// staging ring. Uploads only record a copy; flush() submits everything
+// recorded since the last flush as one batch on the transfer queue, and
+// each batch signals the next value of a timeline semaphore. Callers poll
+// is_complete() instead of waiting, so the render loop never stalls on a
+// transfer. upload() may be called from any thread.
+class Uploader {
+public:
+  Uploader(context::Context &context, const UploaderCreateInfo &create_info);
+  ~Uploader();
+
+  Uploader(const Uploader &) = delete;
+  Uploader(Uploader &&) = delete;
+  Uploader &operator=(const Uploader &) = delete;
+  Uploader &operator=(Uploader &&) = delete;
+
+  // Copies `size` bytes into `buffer` at `offset`. Returns the timeline
+  // value that signals once the copy has landed. Data larger than the ring
+  // is split across several batches.
+  uint64_t upload(vk::Buffer buffer, vk::DeviceSize offset, const void *data,
+                  vk::DeviceSize size);
+  // Same, but `write(destination, offset, size)` fills each chunk of the
+  // ring in place, for data that is converted on its way to the GPU.
+  // `offset` is relative to the start of the upload and every chunk but
+  // the last is a multiple of 16 bytes. Called with the uploader locked.
+  using Writer = std::function<void(void *destination, vk::DeviceSize offset,
+                                    vk::DeviceSize size)>;
+  uint64_t upload(vk::Buffer buffer, vk::DeviceSize offset,
+                  vk::DeviceSize size, const Writer &write);
+  // Device-local buffer that can be a copy destination on the transfer
+  // queue and used on the graphics queue.
+  types::BufferHandle create_buffer(vk::DeviceSize size,
+                                    vk::BufferUsageFlags usage);
+
+  // Submits the recorded copies. Returns the value the batch signals, or
+  // the last submitted value if nothing was recorded.
+  uint64_t flush();
+
+  vk::Semaphore timeline_semaphore() const { return m_timeline; }
+  // Cached; refreshed by is_complete() misses and flush().
+  uint64_t completed_value() const {
+    return m_completed_value.load(std::memory_order_acquire);
+  }
+  bool is_complete(uint64_t value);
+  // Blocks until `value` has signalled; only for loading screens and
+  // shutdown.
+  void wait(uint64_t value);
+
+  // Buffers shared between the graphics and transfer families are created
+  // concurrent, so no ownership transfer is needed.
+  vk::SharingMode sharing_mode() const;
+  std::vector<uint32_t> queue_families() const;
+
+  UploaderStats stats();
+
+private:
+  struct Copy {
+    vk::Buffer buffer;
+    vk::BufferCopy region;
+  };
+  struct Batch {
+    vk::CommandPool command_pool;
+    vk::CommandBuffer command_buffer;
+    uint64_t value = 0;
+    // Ring position just past this batch's data.
+    uint64_t ring_end = 0;
+  };
+
+  // Returns the ring offset of `size` contiguous bytes.
+  vk::DeviceSize reserve(std::unique_lock<std::mutex> &lock,
+                         vk::DeviceSize size);
+  uint64_t flush_locked();
+  // Reads the semaphore and raises the cached completed value.
+  uint64_t poll_completed_value();
+  void retire_batches();
+  Batch acquire_batch();
+
+  context::Context &m_context;
+
+  vk::Buffer m_staging_buffer;
+  vma::Allocation m_staging_allocation;
+  uint8_t *m_staging_mapped = nullptr;
+  vk::DeviceSize m_staging_size;
+  // Monotonic byte counters; the ring offset is the value modulo the size.
+  uint64_t m_ring_head = 0;
+  uint64_t m_ring_tail = 0;
+
+  vk::Semaphore m_timeline;
+  uint64_t m_submitted_value = 0;
+  std::atomic<uint64_t> m_completed_value{0};
+
+  std::mutex m_mutex;
+  std::vector<Copy> m_pending;
+  std::deque<Batch> m_in_flight;
+  std::vector<Batch> m_free_batches;
+  UploaderStats m_stats;
+};
+} // namespace bs::engine::renderer
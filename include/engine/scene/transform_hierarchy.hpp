@@ -0,0 +1,126 @@
+#pragma once
+
+#include <engine/culling/culling.hpp>
+#include <engine/types/handle.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace bs::engine::scene {
+// A TransformHierarchy node's links; its transforms live in the
+// hierarchy's dense arrays.
+struct TransformNode {
+  types::Handle<TransformNode> parent;
+  types::Handle<TransformNode> first_child;
+  types::Handle<TransformNode> next_sibling;
+  // Index into the dense arrays.
+  uint32_t slot = UINT32_MAX;
+};
+
+enum class TransformKernel : uint8_t {
+  eScalar,
+  // One matrix per iteration, a column per register; baseline on x86-64.
+  eSse2,
+};
+
+// Widest kernel this CPU runs.
+TransformKernel best_transform_kernel();
+const char *transform_kernel_name(TransformKernel kernel);
+
+// Parent/child transforms with local-to-world matrices and world-space
+// bounding spheres. The dense arrays are kept in breadth-first order, so
+// every parent comes before its children, a node's children are
+// contiguous and each depth is one range. update() only recomputes nodes
+// whose local transform changed and their descendants, walking down one
+// depth at a time so each depth's queue is composed in one batch against
+// parents that are already final. Structural changes (creating,
+// destroying or reparenting nodes) re-sort the arrays on the next
+// update(). Not thread-safe.
+class TransformHierarchy {
+public:
+  using Handle = types::Handle<TransformNode>;
+  // Bounds of nodes that have none; no frustum accepts them.
+  static inline const glm::vec4 no_bounds{
+      0.f, 0.f, 0.f, -std::numeric_limits<float>::infinity()};
+
+  // A null parent makes a root.
+  Handle create(Handle parent = {}, const glm::mat4 &local = glm::mat4(1.f),
+                const glm::vec4 &bounds = no_bounds);
+  // Destroys the node and all of its descendants.
+  void destroy(Handle node);
+  // A null parent makes the node a root. The parent may not be the node
+  // or one of its descendants.
+  void set_parent(Handle node, Handle parent);
+  void set_local(Handle node, const glm::mat4 &local);
+  // Bounding sphere (center in xyz, radius in w) in the node's space.
+  void set_bounds(Handle node, const glm::vec4 &bounds);
+
+  bool contains(Handle node) const { return m_nodes.contains(node); }
+  Handle parent(Handle node) const { return m_nodes.get(node)->parent; }
+  const glm::mat4 &local(Handle node) const {
+    return m_local[m_nodes.get(node)->slot];
+  }
+  // As of the last update().
+  const glm::mat4 &world(Handle node) const {
+    return m_world[m_nodes.get(node)->slot];
+  }
+  glm::vec4 world_bounds(Handle node) const;
+
+  // Recomputes the world matrices and bounds of every changed node and
+  // its descendants, and returns how many it recomputed.
+  uint32_t update(TransformKernel kernel = best_transform_kernel());
+  // Marks every node changed, so the next update() recomputes them all.
+  void mark_all_dirty();
+
+  uint32_t size() const { return m_nodes.size(); }
+  // Number of depths, as of the last update().
+  uint32_t depth_count() const {
+    return static_cast<uint32_t>(m_depth_begin.size()) - 1;
+  }
+  // Index of the node in world_matrices() and world_spheres(), as of the
+  // last update(). Slots change whenever the structure does.
+  uint32_t slot(Handle node) const { return m_nodes.get(node)->slot; }
+  Handle handle(uint32_t slot) const { return m_handles[slot]; }
+  std::span<const glm::mat4> world_matrices() const {
+    return {m_world.data(), m_depth_begin.back()};
+  }
+  const culling::SphereSoA &world_spheres() const { return m_world_spheres; }
+
+private:
+  Handle &first_child(Handle parent) {
+    return parent ? m_nodes.get(parent)->first_child : m_first_root;
+  }
+  void link(Handle node, Handle parent);
+  void unlink(Handle node);
+  void mark_dirty(uint32_t slot);
+  // Re-sorts the dense arrays breadth-first and requeues the dirty nodes.
+  void rebuild();
+
+  types::Pool<TransformNode> m_nodes;
+  // Roots are siblings of each other, with no parent.
+  Handle m_first_root;
+  bool m_structure_changed = false;
+
+  // Dense arrays indexed by slot. Created nodes are appended and
+  // destroyed ones leave a hole until rebuild().
+  std::vector<Handle> m_handles;
+  std::vector<uint32_t> m_parent_slot;
+  std::vector<uint32_t> m_first_child_slot;
+  std::vector<uint32_t> m_child_count;
+  std::vector<uint32_t> m_depth;
+  std::vector<glm::mat4> m_local;
+  std::vector<glm::mat4> m_world;
+  std::vector<glm::vec4> m_bounds;
+  // Set while a node is queued, so nothing is queued twice.
+  std::vector<uint8_t> m_dirty;
+  culling::SphereSoA m_world_spheres;
+  // Slots of depth d are [m_depth_begin[d], m_depth_begin[d + 1]).
+  std::vector<uint32_t> m_depth_begin{0};
+  // Changed slots per depth, waiting for update().
+  std::vector<std::vector<uint32_t>> m_queues;
+};
+} // namespace bs::engine::scene
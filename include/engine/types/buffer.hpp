@@ -0,0 +1,18 @@
+#pragma once
+
+#include <engine/types/handle.hpp>
+
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan.hpp>
+
+namespace bs::engine::types {
+// GPU buffer owned by the Context's buffer pool.
+struct Buffer {
+  vk::Buffer buffer;
+  vma::Allocation allocation;
+  vk::DeviceSize size = 0;
+  // Non-null for persistently mapped host-visible buffers.
+  void *mapped = nullptr;
+};
+using BufferHandle = Handle<Buffer>;
+} // namespace bs::engine::types
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace bs::engine::types {
+// 32-bit reference into a Pool<T>: 20 bits of slot index and 12 bits of
+// generation. The generation is bumped every time a slot is freed, so a
+// handle to a destroyed resource stops matching instead of aliasing the
+// slot's next owner. Generation 0 is never handed out, which makes the
+// zero value a null handle.
+template <typename T> class Handle {
+public:
+  static constexpr uint32_t index_bits = 20;
+  static constexpr uint32_t max_index = (1u << index_bits) - 1;
+  static constexpr uint32_t max_generation = (1u << (32 - index_bits)) - 1;
+
+  Handle() = default;
+  Handle(uint32_t index, uint32_t generation)
+      : m_value((generation << index_bits) | index) {}
+
+  uint32_t index() const { return m_value & max_index; }
+  uint32_t generation() const { return m_value >> index_bits; }
+  uint32_t value() const { return m_value; }
+  explicit operator bool() const { return m_value != 0; }
+
+  bool operator==(const Handle &other) const {
+    return m_value == other.m_value;
+  }
+  bool operator!=(const Handle &other) const { return !(*this == other); }
+
+private:
+  uint32_t m_value = 0;
+};
+
+// Dense slot array addressed by Handle<T>. Items live in one contiguous
+// vector and freed slots are reused, so lookup is a bounds check plus a
+// generation compare. get() returns null and destroy() returns nothing
+// for stale and null handles. Not thread-safe.
+template <typename T> class Pool {
+public:
+  template <typename... Args> Handle<T> create(Args &&...args) {
+    uint32_t index;
+    if (!m_free_indices.empty()) {
+      index = m_free_indices.back();
+      m_free_indices.pop_back();
+      m_items[index] = T{std::forward<Args>(args)...};
+    } else {
+      index = static_cast<uint32_t>(m_items.size());
+      // Past this the index would spill into the generation bits.
+      if (index > Handle<T>::max_index)
+        throw std::runtime_error("Pool is full");
+      m_items.push_back(T{std::forward<Args>(args)...});
+      m_generations.push_back(1);
+      m_live.push_back(false);
+    }
+    m_live[index] = true;
+    m_size++;
+    return Handle<T>(index, m_generations[index]);
+  }
+
+  // Moves the item out so the caller can release whatever it owns. A stale
+  // handle leaves the pool untouched and returns an empty optional.
+  std::optional<T> destroy(Handle<T> handle) {
+    if (!contains(handle))
+      return std::nullopt;
+    const uint32_t index = handle.index();
+    T item = std::exchange(m_items[index], T{});
+    m_live[index] = false;
+    m_generations[index] = m_generations[index] == Handle<T>::max_generation
+                               ? 1
+                               : m_generations[index] + 1;
+    m_free_indices.push_back(index);
+    m_size--;
+    return item;
+  }
+
+  T *get(Handle<T> handle) {
+    const uint32_t index = handle.index();
+    if (index >= m_items.size() || !m_live[index] ||
+        m_generations[index] != handle.generation())
+      return nullptr;
+    return &m_items[index];
+  }
+  const T *get(Handle<T> handle) const {
+    return const_cast<Pool *>(this)->get(handle);
+  }
+  bool contains(Handle<T> handle) const {
+    const uint32_t index = handle.index();
+    return index < m_items.size() && m_live[index] &&
+           m_generations[index] == handle.generation();
+  }
+
+  uint32_t size() const { return m_size; }
+  // f(Handle<T>, T &) for every live item.
+  template <typename F> void each(F &&f) {
+    for (uint32_t index = 0; index < m_items.size(); index++) {
+      if (m_live[index])
+        f(Handle<T>(index, m_generations[index]), m_items[index]);
+    }
+  }
+
+private:
+  std::vector<T> m_items;
+  std::vector<uint32_t> m_generations;
+  std::vector<bool> m_live;
+  std::vector<uint32_t> m_free_indices;
+  uint32_t m_size = 0;
+};
+} // namespace bs::engine::types
+
+template <typename T> struct std::hash<bs::engine::types::Handle<T>> {
+  size_t operator()(const bs::engine::types::Handle<T> &handle) const {
+    return std::hash<uint32_t>{}(handle.value());
+  }
+};
@@ -5,41 +5,117 @@
 
 #include <vk_mem_alloc.hpp>
 
+#include <engine/types/handle.hpp>
+#include <engine/types/mesh_constants.hpp>
+#include <engine/types/mesh_optimizer.hpp>
+#include <engine/types/quantized_vertex.hpp>
 #include <engine/types/vertex.hpp>
 
 namespace bs::engine::types {
+struct MeshLod {
+  uint32_t first_index = 0;
+  uint32_t index_count = 0;
+  // Geometric error in object space units.
+  float error = 0.f;
+};
+
+// Where an uploaded mesh lives in the renderer's shared geometry buffers:
+// its vertices start at first_vertex of its vertex format's buffer and its
+// indices, relative to first_vertex, at first_index of the index buffer.
+struct MeshRange {
+  uint32_t first_vertex = 0;
+  uint32_t vertex_count = 0;
+  uint32_t first_index = 0;
+  // Over every level of detail.
+  uint32_t index_count = 0;
+};
+
+// Geometry plus its range of the GPU buffers. The ranges belong to the
+// renderer's MeshArena, not to the Mesh, so a copy refers to the same
+// geometry and never frees it; Renderer::destroy() does.
 class Mesh {
 public:
   Mesh();
   ~Mesh();
 
-  Mesh(const Mesh &other)
-      : m_vertices(other.m_vertices), m_allocation(other.m_allocation),
-        m_vertex_buffer(other.m_vertex_buffer) {}
-  Mesh(Mesh &&other)
-      : m_vertices(std::move(other.m_vertices)),
-        m_allocation(std::move(other.m_allocation)),
-        m_vertex_buffer(std::move(other.m_vertex_buffer)) {}
-  Mesh &operator=(const Mesh &other) {
-    m_vertices = other.m_vertices;
-    m_allocation = other.m_allocation;
-    m_vertex_buffer = other.m_vertex_buffer;
-    return *this;
+  Mesh(const Mesh &other) = default;
+  Mesh(Mesh &&other) = default;
+  Mesh &operator=(const Mesh &other) = default;
+  Mesh &operator=(Mesh &&other) = default;
+
+  // CPU-side geometry. Meshes loaded from an asset file go straight to the
+  // GPU and leave these empty.
+  std::vector<Vertex> &vertices() { return m_vertices; }
+  // Empty for unindexed meshes, which draw consecutive vertex triples.
+  std::vector<uint32_t> &indices() { return m_indices; }
+
+  // Counts of the uploaded geometry. Every uploaded mesh is indexed;
+  // unindexed ones get a sequential index range.
+  bool uploaded() const { return m_range.vertex_count != 0; }
+  uint32_t vertex_count() const { return m_range.vertex_count; }
+  // Indices of the full-detail level.
+  uint32_t index_count() const {
+    return m_lods.empty() ? m_range.index_count : m_lods.front().index_count;
   }
-  Mesh &operator=(Mesh &&other) {
-    m_vertices = std::move(other.m_vertices);
-    m_allocation = std::move(other.m_allocation);
-    m_vertex_buffer = std::move(other.m_vertex_buffer);
-    return *this;
+  // Start of the full-detail level in the index buffer.
+  uint32_t first_index() const {
+    return m_range.first_index +
+           (m_lods.empty() ? 0 : m_lods.front().first_index);
   }
+  // Index ranges relative to range().first_index, most detailed first;
+  // empty for meshes without levels of detail.
+  const std::vector<MeshLod> &lods() const { return m_lods; }
+  void set_lods(std::vector<MeshLod> lods) { m_lods = std::move(lods); }
 
-  std::vector<Vertex> &vertices() { return m_vertices; }
-  vma::Allocation allocation() { return m_allocation; }
-  vk::Buffer vertex_buffer() { return m_vertex_buffer; }
+  // Welds the vertices into an index buffer and reorders both for the
+  // post-transform cache, overdraw and vertex fetch. Call before upload.
+  MeshOptimizationReport optimize(float overdraw_threshold = 1.05f) {
+    return optimize_mesh(m_vertices, m_indices, overdraw_threshold);
+  }
+
+  const MeshRange &range() const { return m_range; }
+  // Uploader timeline value that signals once the range holds the
+  // vertices and indices; zero if the mesh was never uploaded.
+  uint64_t upload_value() const { return m_upload_value; }
+
+  // Format of the uploaded vertex buffer; vertices() always stays full
+  // precision. Takes effect on the next upload.
+  VertexFormat vertex_format() const { return m_vertex_format; }
+  void set_vertex_format(VertexFormat format) { m_vertex_format = format; }
+  // Object-space box of the uploaded vertices; also what quantized
+  // positions are decoded against.
+  const VertexBounds &bounds() const { return m_bounds; }
+  // Center in xyz and radius in w, enclosing bounds().
+  glm::vec4 bounding_sphere() const {
+    return glm::vec4(m_bounds.offset + m_bounds.scale * 0.5f,
+                     glm::length(m_bounds.scale) * 0.5f);
+  }
+  void set_bounds(const VertexBounds &bounds) { m_bounds = bounds; }
+  MeshConstants constants() const {
+    return m_vertex_format == VertexFormat::eQuantized
+               ? MeshConstants::from_bounds(m_bounds)
+               : MeshConstants{};
+  }
+
+  void set_range(const MeshRange &range, uint64_t upload_value) {
+    m_range = range;
+    m_upload_value = upload_value;
+  }
 
 private:
   std::vector<Vertex> m_vertices;
-  vma::Allocation m_allocation;
-  vk::Buffer m_vertex_buffer;
+  std::vector<uint32_t> m_indices;
+  MeshRange m_range;
+  uint64_t m_upload_value = 0;
+  VertexFormat m_vertex_format = VertexFormat::eFull;
+  VertexBounds m_bounds;
+  std::vector<MeshLod> m_lods;
 };
+using MeshHandle = Handle<Mesh>;
+
+uint32_t vertex_stride(VertexFormat format);
+// Binding 0, per-vertex, laid out for mesh.vert.glsl's inputs.
+vk::VertexInputBindingDescription vertex_binding(VertexFormat format);
+std::vector<vk::VertexInputAttributeDescription>
+vertex_attributes(VertexFormat format);
 } // namespace bs::engine::types
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <engine/io/mapped_file.hpp>
+#include <engine/types/mesh.hpp>
+#include <engine/types/mesh_optimizer.hpp>
+#include <engine/types/quantized_vertex.hpp>
+#include <engine/types/vertex.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace bs::engine::types {
+// Binary container for the meshes of a model, written by the mesh_converter
+// tool. The file is a header, a table of entries and then the blobs, all
+// little-endian. Vertices and indices are stored exactly as the GPU reads
+// them and every blob starts on a mesh_asset_alignment boundary, so loading
+// is mapping the file and copying the blobs into the staging ring.
+inline constexpr std::array<char, 4> mesh_asset_magic{'B', 'S', 'M', 'A'};
+inline constexpr uint32_t mesh_asset_version = 1;
+inline constexpr uint64_t mesh_asset_alignment = 16;
+
+// Byte range of the file.
+struct MeshAssetBlob {
+  uint64_t offset = 0;
+  uint64_t size = 0;
+};
+
+struct MeshAssetHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  uint32_t mesh_count;
+  uint32_t reserved;
+  uint64_t file_size;
+  // mesh_count MeshAssetEntry records.
+  uint64_t entries_offset;
+};
+
+struct MeshAssetEntry {
+  uint32_t vertex_format;
+  uint32_t vertex_count;
+  // Over every level of detail.
+  uint32_t index_count;
+  // 2 or 4 bytes; 0 for unindexed meshes.
+  uint32_t index_size;
+  // Object-space box; quantized positions are relative to it.
+  VertexBounds bounds;
+  uint32_t lod_count;
+  uint32_t meshlet_count;
+  MeshAssetBlob vertices;
+  MeshAssetBlob indices;
+  // MeshLod records.
+  MeshAssetBlob lods;
+  // Meshlet records, their uint32_t vertex lists and uint8_t triangles.
+  MeshAssetBlob meshlets;
+  MeshAssetBlob meshlet_vertices;
+  MeshAssetBlob meshlet_triangles;
+};
+
+static_assert(std::is_trivially_copyable_v<MeshAssetHeader> &&
+              sizeof(MeshAssetHeader) == 32);
+static_assert(std::is_trivially_copyable_v<MeshAssetEntry> &&
+              sizeof(MeshAssetEntry) == 144);
+static_assert(std::is_trivially_copyable_v<MeshLod> && sizeof(MeshLod) == 12);
+static_assert(std::is_trivially_copyable_v<Meshlet> && sizeof(Meshlet) == 32);
+
+// One mesh of a loaded asset. Every span points into the mapping.
+struct MeshAssetView {
+  VertexFormat vertex_format = VertexFormat::eFull;
+  uint32_t vertex_count = 0;
+  uint32_t index_count = 0;
+  uint32_t index_size = 0;
+  VertexBounds bounds;
+  std::span<const uint8_t> vertices;
+  std::span<const uint8_t> indices;
+  std::span<const MeshLod> lods;
+  std::span<const Meshlet> meshlets;
+  std::span<const uint32_t> meshlet_vertices;
+  std::span<const uint8_t> meshlet_triangles;
+};
+
+// Mapped asset file. The constructor validates the header and entry table
+// against the file size, and every index and meshlet against its mesh, so
+// no span handed out reaches past the mesh's vertices. Vertex blobs aren't
+// read or copied until they are uploaded. Throws std::runtime_error for
+// files that aren't a valid asset of this version.
+class MeshAsset {
+public:
+  explicit MeshAsset(const std::string &path);
+
+  MeshAsset(const MeshAsset &) = delete;
+  MeshAsset(MeshAsset &&) = default;
+  MeshAsset &operator=(const MeshAsset &) = delete;
+  MeshAsset &operator=(MeshAsset &&) = default;
+
+  std::span<const MeshAssetView> meshes() const { return m_meshes; }
+  size_t size() const { return m_file.size(); }
+
+private:
+  io::MappedFile m_file;
+  std::vector<MeshAssetView> m_meshes;
+};
+
+struct MeshAssetSource {
+  std::span<const Vertex> vertices;
+  // Every level of detail back to back, as described by `lods`.
+  std::span<const uint32_t> indices;
+  std::span<const MeshLod> lods;
+  const Meshlets *meshlets = nullptr;
+  // Vertices are encoded in this format when written.
+  VertexFormat vertex_format = VertexFormat::eFull;
+};
+
+// Writes to a temporary file and renames it over `path`. Throws
+// std::runtime_error if the file can't be written.
+void write_mesh_asset(const std::string &path,
+                      std::span<const MeshAssetSource> meshes);
+} // namespace bs::engine::types
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <engine/types/quantized_vertex.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+namespace bs::engine::types {
+// Positions are decoded as position_offset + position * position_scale,
+// which is the identity for full-precision vertices.
+struct MeshConstants {
+  glm::vec4 position_scale{1.f};
+  glm::vec4 position_offset{0.f};
+
+  static MeshConstants from_bounds(const VertexBounds &bounds) {
+    return MeshConstants{
+        .position_scale = glm::vec4(bounds.scale, 1.f),
+        .position_offset = glm::vec4(bounds.offset, 0.f),
+    };
+  }
+};
+
+// Push constants of mesh.vert.glsl. Buffers are picked by their index in
+// the renderer's BindlessHeap.
+struct DrawConstants {
+  glm::vec4 position_scale{1.f};
+  glm::vec4 position_offset{0.f};
+  // The frame's FrameAllocator region: the camera's matrices, then the
+  // instance transforms.
+  uint32_t frame_data = 0;
+  // In mat4s from the region's start; draws add their firstInstance.
+  uint32_t instance_base = 0;
+  // GpuCulling's object buffer, read instead of the mesh constants on the
+  // GPU-driven path.
+  uint32_t object_buffer = 0;
+  uint32_t reserved = 0;
+
+  void set_mesh(const MeshConstants &constants) {
+    position_scale = constants.position_scale;
+    position_offset = constants.position_offset;
+  }
+};
+} // namespace bs::engine::types
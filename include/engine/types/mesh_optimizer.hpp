@@ -0,0 +1,101 @@
+#pragma once
+
+#include <engine/types/vertex.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace bs::engine::types {
+inline constexpr uint32_t default_vertex_cache_size = 16;
+
+struct VertexCacheStats {
+  // Average cache miss ratio: transformed vertices per triangle, 0.5 at
+  // best for large regular meshes and 3 for a triangle soup.
+  float acmr = 0.f;
+  // Average transform to vertex ratio: transformed vertices per unique
+  // vertex, 1 at best.
+  float atvr = 0.f;
+};
+
+// Meshlet limits matching common mesh shader hardware sweet spots.
+inline constexpr uint32_t max_meshlet_vertices = 64;
+inline constexpr uint32_t max_meshlet_triangles = 124;
+
+struct Meshlet {
+  // Into the meshlet vertex list, which indexes the mesh's vertices.
+  uint32_t vertex_offset = 0;
+  // Into the meshlet triangle list, three local uint8_t indices each.
+  uint32_t triangle_offset = 0;
+  uint32_t vertex_count = 0;
+  uint32_t triangle_count = 0;
+  glm::vec3 center{0.f};
+  float radius = 0.f;
+};
+
+struct Meshlets {
+  std::vector<Meshlet> meshlets;
+  std::vector<uint32_t> vertices;
+  std::vector<uint8_t> triangles;
+};
+
+struct MeshOptimizationReport {
+  uint32_t input_vertices = 0;
+  uint32_t output_vertices = 0;
+  uint32_t triangles = 0;
+  VertexCacheStats before;
+  VertexCacheStats after;
+};
+
+// Simulates a FIFO post-transform cache of `cache_size` entries. Zeros for
+// fewer than three indices.
+VertexCacheStats analyze_vertex_cache(std::span<const uint32_t> indices,
+                                      uint32_t vertex_count,
+                                      uint32_t cache_size =
+                                          default_vertex_cache_size);
+
+// Merges bitwise identical vertices. `vertices` is compacted in place and
+// the returned index buffer references the survivors.
+std::vector<uint32_t> weld_vertices(std::vector<Vertex> &vertices);
+
+// Tipsify (Sander et al. 2007): reorders triangles so consecutive
+// triangles share vertices still in a FIFO cache of `cache_size`.
+void optimize_vertex_cache(std::span<uint32_t> indices, uint32_t vertex_count,
+                           uint32_t cache_size = default_vertex_cache_size);
+
+// Reorders clusters of a cache-optimised index buffer so outward-facing
+// surfaces are drawn first, reducing overdraw. Clusters are only split
+// where the ACMR so far is within `threshold` times the whole cluster's,
+// so a higher threshold makes more, smaller clusters.
+void optimize_overdraw(std::span<uint32_t> indices,
+                       std::span<const Vertex> vertices,
+                       float threshold = 1.05f,
+                       uint32_t cache_size = default_vertex_cache_size);
+
+// Orders vertices by first use so vertex fetches stream through memory.
+// Unreferenced vertices are dropped.
+void optimize_vertex_fetch(std::vector<Vertex> &vertices,
+                           std::span<uint32_t> indices);
+
+// Lower detail index buffer over the same vertices, made by snapping
+// vertices to a grid of `grid_size` cells along the longest axis and
+// dropping the triangles that collapse. The representative of each cell is
+// its first vertex, so no new vertices are needed. Returns the cell size as
+// the geometric error.
+float simplify_clustered(std::span<const uint32_t> indices,
+                         std::span<const Vertex> vertices, uint32_t grid_size,
+                         std::vector<uint32_t> &output);
+
+// Splits an index buffer into meshlets in index order, so it should already
+// be optimised for the vertex cache.
+Meshlets build_meshlets(std::span<const uint32_t> indices,
+                        std::span<const Vertex> vertices);
+
+// All of the above: welds a triangle soup (or keeps existing indices), then
+// optimises for the vertex cache, overdraw and vertex fetch in that order.
+// An empty mesh is left alone and gets an all-zero report.
+MeshOptimizationReport optimize_mesh(std::vector<Vertex> &vertices,
+                                     std::vector<uint32_t> &indices,
+                                     float overdraw_threshold = 1.05f);
+void log_report(const MeshOptimizationReport &report);
+} // namespace bs::engine::types
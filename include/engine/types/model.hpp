@@ -1,27 +1,25 @@
 #pragma once
 
 #include <engine/types/mesh.hpp>
-#include <memory>
+#include <vector>
 
 namespace bs::engine::types {
+// Meshes of a model, held by handle into the renderer's mesh pool.
 class Model {
 public:
   Model();
-  Model(const Mesh &mesh);
+  Model(MeshHandle mesh);
+  Model(std::vector<MeshHandle> meshes);
   ~Model();
 
-  Model(const Model &other) : m_mesh(other.m_mesh) {}
-  Model(Model &&other) : m_mesh(std::move(other.m_mesh)) {}
-  Model &operator=(const Model &other) {
-    m_mesh = other.m_mesh;
-    return *this;
-  }
-  Model &operator=(Model &&other) {
-    m_mesh = std::move(other.m_mesh);
-    return *this;
-  }
+  Model(const Model &other) = default;
+  Model(Model &&other) = default;
+  Model &operator=(const Model &other) = default;
+  Model &operator=(Model &&other) = default;
+
+  const std::vector<MeshHandle> &meshes() const { return m_meshes; }
 
 private:
-  std::shared_ptr<Mesh> m_mesh;
+  std::vector<MeshHandle> m_meshes;
 };
 } // namespace bs::engine::types
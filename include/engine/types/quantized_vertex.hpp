@@ -0,0 +1,50 @@
+#pragma once
+
+#include <engine/types/vertex.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace bs::engine::types {
+// 12-byte encoding of types::Vertex.
+//
+// position: R16G16B16A16_UNORM relative to the mesh bounds (w is padding).
+//   Each axis is off by at most half a step (1 / 131070 of the mesh extent
+//   along that axis) plus float rounding, under 7.8e-6 of the extent.
+// normal: R16G16_SNORM octahedral. The decoded direction is within 0.004
+//   degrees of the normalised input.
+struct QuantizedVertex {
+  std::array<uint16_t, 4> position;
+  std::array<int16_t, 2> normal;
+};
+static_assert(sizeof(QuantizedVertex) == 12);
+
+// Axis-aligned box the positions are quantized against. Decoding is
+// offset + unorm * scale, which is what mesh.vert.glsl does.
+struct VertexBounds {
+  glm::vec3 offset{0.f};
+  glm::vec3 scale{1.f};
+};
+
+VertexBounds compute_bounds(std::span<const Vertex> vertices);
+
+std::array<uint16_t, 4> quantize_position(const glm::vec3 &position,
+                                          const VertexBounds &bounds);
+glm::vec3 dequantize_position(const std::array<uint16_t, 4> &position,
+                              const VertexBounds &bounds);
+
+std::array<int16_t, 2> encode_octahedral(const glm::vec3 &normal);
+glm::vec3 decode_octahedral(const std::array<int16_t, 2> &encoded);
+
+QuantizedVertex quantize_vertex(const Vertex &vertex,
+                                const VertexBounds &bounds);
+Vertex dequantize_vertex(const QuantizedVertex &vertex,
+                         const VertexBounds &bounds);
+
+std::vector<QuantizedVertex> quantize_vertices(std::span<const Vertex> vertices,
+                                               const VertexBounds &bounds);
+} // namespace bs::engine::types
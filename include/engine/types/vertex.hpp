@@ -2,9 +2,18 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
+
 namespace bs::engine::types {
 struct Vertex {
   glm::vec3 position;
   glm::vec3 normal;
 };
+
+enum class VertexFormat : uint8_t {
+  // types::Vertex, 24 bytes.
+  eFull,
+  // types::QuantizedVertex, 12 bytes.
+  eQuantized,
+};
 } // namespace bs::engine::types
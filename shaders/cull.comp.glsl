@@ -0,0 +1,62 @@
+#version 460
+
+layout(local_size_x = 64) in;
+
+// renderer::GpuObject
+struct Object {
+  vec4 sphere;
+  vec4 position_scale;
+  vec4 position_offset;
+  uint index_count;
+  uint first_index;
+  int vertex_offset;
+  uint vertex_format;
+};
+
+// VkDrawIndexedIndirectCommand
+struct DrawCommand {
+  uint index_count;
+  uint instance_count;
+  uint first_index;
+  int vertex_offset;
+  uint first_instance;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+  Object objects[];
+};
+layout(std430, set = 0, binding = 1) writeonly buffer Commands {
+  DrawCommand commands[];
+};
+// One draw count per vertex format, zeroed before the dispatch.
+layout(std430, set = 0, binding = 2) buffer Counts {
+  uint counts[];
+};
+
+// renderer::GpuCullConstants
+layout(push_constant) uniform CullConstants {
+  vec4 planes[6];
+  uint object_count;
+  // First command of each vertex format's range.
+  uint command_base[2];
+} cull;
+
+void main() {
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= cull.object_count)
+    return;
+
+  Object object = objects[index];
+  // Same test as culling::Frustum::visible().
+  for (int p = 0; p < 6; p++) {
+    if (dot(cull.planes[p].xyz, object.sphere.xyz) + cull.planes[p].w <
+        -object.sphere.w)
+      return;
+  }
+
+  uint slot = atomicAdd(counts[object.vertex_format], 1);
+  // first_instance carries the object index to mesh.vert.glsl.
+  commands[cull.command_base[object.vertex_format] + slot] =
+      DrawCommand(object.index_count, 1, object.first_index,
+                  object.vertex_offset, index);
+}
@@ -1,3 +1,11 @@
 #version 460
 
-void main() {}
+layout(location = 0) in vec3 in_normal;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+  vec3 light = normalize(vec3(0.3, 1.0, 0.5));
+  float diffuse = max(dot(normalize(in_normal), light), 0.0);
+  out_color = vec4(vec3(0.1 + 0.9 * diffuse), 1.0);
+}
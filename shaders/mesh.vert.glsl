@@ -1,3 +1,85 @@
 #version 460
+// Runtime-sized descriptor arrays.
+#extension GL_EXT_nonuniform_qualifier : require
 
-void main() {}
+// Selects the types::QuantizedVertex decode; set per pipeline.
+layout(constant_id = 0) const bool quantized_vertices = false;
+// Draws come from cull.comp.glsl, with the object index as the instance
+// index, and read their constants from the object buffer instead of the
+// push constants.
+layout(constant_id = 1) const bool gpu_driven = false;
+
+// renderer::BindlessHeap's storage buffers; every buffer the shader reads
+// is picked from it by an index in the push constants, so it's declared
+// once per block type the buffers are read as.
+layout(std430, set = 0, binding = 0) readonly buffer FrameData {
+  // The frame's types::CameraUBO (model, view, proj), then the instance
+  // transforms.
+  mat4 matrices[];
+} frame_data[];
+
+// renderer::GpuObject
+struct Object {
+  vec4 sphere;
+  vec4 position_scale;
+  vec4 position_offset;
+  uint index_count;
+  uint first_index;
+  int vertex_offset;
+  uint vertex_format;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+  Object objects[];
+} object_buffers[];
+
+// types::DrawConstants
+layout(push_constant) uniform DrawConstants {
+  vec4 position_scale;
+  vec4 position_offset;
+  uint frame_data;
+  uint instance_base;
+  uint object_buffer;
+  uint reserved;
+} draw;
+
+// Full: R32G32B32_SFLOAT position and normal.
+// Quantized: R16G16B16A16_UNORM position against the mesh bounds and
+// R16G16_SNORM octahedral normal.
+layout(location = 0) in vec4 in_position;
+layout(location = 1) in vec4 in_normal;
+
+layout(location = 0) out vec3 out_normal;
+
+// Inverse of types::encode_octahedral.
+vec3 decode_octahedral(vec2 encoded) {
+  vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+  float t = max(-normal.z, 0.0);
+  normal.xy += mix(vec2(t), vec2(-t), greaterThanEqual(normal.xy, vec2(0.0)));
+  return normalize(normal);
+}
+
+void main() {
+  vec4 position_scale = draw.position_scale;
+  vec4 position_offset = draw.position_offset;
+  if (gpu_driven) {
+    Object object =
+        object_buffers[draw.object_buffer].objects[gl_InstanceIndex];
+    position_scale = object.position_scale;
+    position_offset = object.position_offset;
+  }
+  vec3 position = position_offset.xyz + in_position.xyz * position_scale.xyz;
+  vec3 normal =
+      quantized_vertices ? decode_octahedral(in_normal.xy) : in_normal.xyz;
+
+  // gl_InstanceIndex includes the draw's firstInstance, its first index in
+  // the sorted draws.
+  mat4 camera_model = frame_data[draw.frame_data].matrices[0];
+  mat4 view = frame_data[draw.frame_data].matrices[1];
+  mat4 proj = frame_data[draw.frame_data].matrices[2];
+  mat4 model = camera_model *
+               frame_data[draw.frame_data]
+                   .matrices[draw.instance_base + gl_InstanceIndex];
+  gl_Position = proj * view * model * vec4(position, 1.0);
+  out_normal = mat3(model) * normal;
+}
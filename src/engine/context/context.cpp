@@ -9,24 +9,179 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
 #include <fmt/format.h>
-#include <fstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 
 namespace bs::engine::context {
-Context::Context() {
+namespace {
+constexpr const char *validation_layer_name = "VK_LAYER_KHRONOS_validation";
+
+bool validation_layer_available() {
+  for (const auto &layer : vk::enumerateInstanceLayerProperties()) {
+    if (std::string_view(layer.layerName.data()) == validation_layer_name)
+      return true;
+  }
+  return false;
+}
+
+// The first family that can both render and compute, and present unless
+// headless. Vulkan guarantees such a family on any device that has graphics.
+uint32_t find_graphics_queue_family(vk::Instance instance,
+                                    vk::PhysicalDevice physical_device,
+                                    bool present) {
+  const auto families = physical_device.getQueueFamilyProperties();
+  const vk::QueueFlags render_flags =
+      vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute;
+  for (uint32_t i = 0; i < families.size(); i++) {
+    if ((families[i].queueFlags & render_flags) != render_flags)
+      continue;
+    if (present && !glfwGetPhysicalDevicePresentationSupport(
+                       static_cast<VkInstance>(instance),
+                       static_cast<VkPhysicalDevice>(physical_device), i))
+      continue;
+    return i;
+  }
+  throw std::runtime_error(fmt::format(
+      "{0} has no queue family for graphics, compute{1}",
+      physical_device.getProperties().deviceName.data(),
+      present ? " and present" : ""));
+}
+
+// A compute family without graphics, whose queues run beside the graphics
+// queue. Falls back to the graphics family.
+uint32_t find_compute_queue_family(vk::PhysicalDevice physical_device,
+                                   uint32_t graphics_family) {
+  const auto families = physical_device.getQueueFamilyProperties();
+  for (uint32_t i = 0; i < families.size(); i++) {
+    if ((families[i].queueFlags & vk::QueueFlagBits::eCompute) &&
+        !(families[i].queueFlags & vk::QueueFlagBits::eGraphics))
+      return i;
+  }
+  return graphics_family;
+}
+
+// Prefers a family that can only transfer (a DMA engine on discrete GPUs),
+// then one without graphics. Falls back to the graphics family.
+uint32_t find_transfer_queue_family(vk::PhysicalDevice physical_device,
+                                    uint32_t graphics_family) {
+  const auto families = physical_device.getQueueFamilyProperties();
+  const vk::QueueFlags render_flags =
+      vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute;
+  for (uint32_t i = 0; i < families.size(); i++) {
+    if ((families[i].queueFlags & vk::QueueFlagBits::eTransfer) &&
+        !(families[i].queueFlags & render_flags))
+      return i;
+  }
+  for (uint32_t i = 0; i < families.size(); i++) {
+    if ((families[i].queueFlags & vk::QueueFlagBits::eTransfer) &&
+        !(families[i].queueFlags & vk::QueueFlagBits::eGraphics))
+      return i;
+  }
+  return graphics_family;
+}
+
+bool device_extension_available(vk::PhysicalDevice physical_device,
+                                std::string_view name) {
+  for (const auto &extension :
+       physical_device.enumerateDeviceExtensionProperties()) {
+    if (std::string_view(extension.extensionName.data()) == name)
+      return true;
+  }
+  return false;
+}
+
+// In the policy's order of preference; FIFO always comes last.
+std::vector<vk::PresentModeKHR> preferred_present_modes(PresentPolicy policy) {
+  switch (policy) {
+  case PresentPolicy::eAdaptive:
+    return {vk::PresentModeKHR::eFifoRelaxed, vk::PresentModeKHR::eFifo};
+  case PresentPolicy::eLowLatency:
+    return {vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate,
+            vk::PresentModeKHR::eFifo};
+  case PresentPolicy::eUncapped:
+    return {vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox,
+            vk::PresentModeKHR::eFifo};
+  case PresentPolicy::eThroughput:
+  default:
+    return {vk::PresentModeKHR::eFifo};
+  }
+}
+
+// Mailbox needs a third image to replace queued frames without blocking,
+// and the throughput policy wants one to render ahead into; everything
+// else stays double buffered for latency.
+uint32_t swapchain_image_count(PresentPolicy policy, vk::PresentModeKHR mode,
+                               const vk::SurfaceCapabilitiesKHR &caps) {
+  const uint32_t wanted = mode == vk::PresentModeKHR::eMailbox ||
+                                  policy == PresentPolicy::eThroughput
+                              ? 3
+                              : 2;
+  const uint32_t count = std::max(wanted, caps.minImageCount);
+  // Zero means no limit.
+  return caps.maxImageCount == 0 ? count
+                                 : std::min(count, caps.maxImageCount);
+}
+} // namespace
+
+const char *present_policy_name(PresentPolicy policy) {
+  switch (policy) {
+  case PresentPolicy::eThroughput:
+    return "throughput";
+  case PresentPolicy::eAdaptive:
+    return "adaptive";
+  case PresentPolicy::eLowLatency:
+    return "low latency";
+  case PresentPolicy::eUncapped:
+    return "uncapped";
+  }
+  return "unknown";
+}
+
+Context::Context(const ContextCreateInfo &create_info)
+    : m_headless(create_info.headless),
+      m_present_policy(create_info.present_policy),
+      m_extent(create_info.extent) {
   try {
-    vkfw::init();
-    vkfw::Monitor monitor = vkfw::getPrimaryMonitor();
-    m_video_mode = *monitor.getVideoMode();
-    vkfw::WindowHints window_hints;
-    window_hints.clientAPI = vkfw::ClientAPI::eNone;
-    window_hints.floating = true;
-    m_window = vkfw::createWindow(m_video_mode.width, m_video_mode.height,
-                                  "BS Engine", window_hints, monitor);
-
-    auto instance_extensions = vkfw::getRequiredInstanceExtensions();
+    std::vector<const char *> instance_extensions;
+    if (!m_headless) {
+      vkfw::init();
+      vkfw::Monitor monitor = vkfw::getPrimaryMonitor();
+      m_video_mode = *monitor.getVideoMode();
+      if (m_extent.width == 0 || m_extent.height == 0) {
+        m_extent = create_info.fullscreen
+                       ? vk::Extent2D{static_cast<uint32_t>(m_video_mode.width),
+                                      static_cast<uint32_t>(
+                                          m_video_mode.height)}
+                       : vk::Extent2D{1280, 720};
+      }
+      vkfw::WindowHints window_hints;
+      window_hints.clientAPI = vkfw::ClientAPI::eNone;
+      window_hints.floating = true;
+      window_hints.resizable = !create_info.fullscreen;
+      m_window = vkfw::createWindow(
+          m_extent.width, m_extent.height, "BS Engine", window_hints,
+          create_info.fullscreen ? monitor : vkfw::Monitor{});
+
+      auto required_extensions = vkfw::getRequiredInstanceExtensions();
+      instance_extensions.assign(required_extensions.begin(),
+                                 required_extensions.end());
+    } else if (m_extent.width == 0 || m_extent.height == 0) {
+      m_extent = vk::Extent2D{1280, 720};
+    }
+
+    // Build machines and software drivers usually don't ship the layers.
     std::vector<const char *> instance_layers;
-    instance_layers.emplace_back("VK_LAYER_KHRONOS_validation");
+    if (validation_layer_available()) {
+      instance_layers.emplace_back(validation_layer_name);
+    } else {
+      spdlog::warn("{0} not available, running without validation",
+                   validation_layer_name);
+    }
     // instance_layers.emplace_back("VK_LAYER_LUNARG_api_dump");
     vk::ApplicationInfo app_info{.apiVersion = VK_API_VERSION_1_3};
     vk::InstanceCreateInfo instance_create_info{
@@ -39,35 +194,207 @@ Context::Context() {
     };
     m_instance = vk::createInstance(instance_create_info);
 
-    m_physical_device = m_instance.enumeratePhysicalDevices().front();
+    const auto physical_devices = m_instance.enumeratePhysicalDevices();
+    if (physical_devices.empty())
+      throw std::runtime_error("No Vulkan device found");
+    m_physical_device = physical_devices.front();
+    if (create_info.device_type) {
+      const auto found = std::find_if(
+          physical_devices.begin(), physical_devices.end(),
+          [&](vk::PhysicalDevice physical_device) {
+            return physical_device.getProperties().deviceType ==
+                   *create_info.device_type;
+          });
+      if (found == physical_devices.end())
+        throw std::runtime_error(
+            fmt::format("No Vulkan device of type {0} found",
+                        vk::to_string(*create_info.device_type)));
+      m_physical_device = *found;
+    }
+    spdlog::info("Using physical device: {0}",
+                 m_physical_device.getProperties().deviceName.data());
 
-    float queue_priority = 0.f;
-    vk::DeviceQueueCreateInfo queue_create_info{
-        .queueFamilyIndex = 0,
-        .queueCount = 1,
-        .pQueuePriorities = &queue_priority,
-    };
+    m_graphics_queue_family = find_graphics_queue_family(
+        m_instance, m_physical_device, !m_headless);
+    m_compute_queue_family =
+        find_compute_queue_family(m_physical_device, m_graphics_queue_family);
+    m_transfer_queue_family =
+        find_transfer_queue_family(m_physical_device, m_graphics_queue_family);
+    // The compute queue is only worth having on a family of its own; on the
+    // graphics family it's the graphics queue. The transfer queue takes the
+    // next free queue of its family, so without a family of its own it
+    // still submits without contending on the other queue's lock, and
+    // shares the family's last queue when there are no more.
+    const auto families = m_physical_device.getQueueFamilyProperties();
+    std::vector<uint32_t> queues_taken(families.size(), 0);
+    queues_taken[m_graphics_queue_family] = 1;
+    if (m_compute_queue_family != m_graphics_queue_family)
+      queues_taken[m_compute_queue_family] = 1;
+    const uint32_t transfer_queue_index =
+        std::min(queues_taken[m_transfer_queue_family],
+                 families[m_transfer_queue_family].queueCount - 1);
+    queues_taken[m_transfer_queue_family] = transfer_queue_index + 1;
+
+    const std::array<float, 2> queue_priorities{0.f, 0.f};
+    std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
+    for (uint32_t i = 0; i < families.size(); i++) {
+      if (queues_taken[i] == 0)
+        continue;
+      queue_create_infos.push_back(vk::DeviceQueueCreateInfo{
+          .queueFamilyIndex = i,
+          .queueCount = queues_taken[i],
+          .pQueuePriorities = queue_priorities.data(),
+      });
+    }
     std::vector<const char *> device_extensions;
-    device_extensions.push_back("VK_KHR_swapchain");
+    if (!m_headless) {
+      device_extensions.push_back("VK_KHR_swapchain");
+    }
     device_extensions.push_back("VK_KHR_dynamic_rendering");
+    // Lets the renderer measure when frames actually reach the screen.
+    bool present_wait = false;
+    if (!m_headless &&
+        device_extension_available(m_physical_device,
+                                   VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+        device_extension_available(m_physical_device,
+                                   VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+      const auto present_features =
+          m_physical_device
+              .getFeatures2<vk::PhysicalDeviceFeatures2,
+                            vk::PhysicalDevicePresentIdFeaturesKHR,
+                            vk::PhysicalDevicePresentWaitFeaturesKHR>();
+      present_wait =
+          present_features.get<vk::PhysicalDevicePresentIdFeaturesKHR>()
+              .presentId &&
+          present_features.get<vk::PhysicalDevicePresentWaitFeaturesKHR>()
+              .presentWait;
+    }
+    if (present_wait) {
+      device_extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+      device_extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
+    // GPU-driven rendering needs all three, since the cull shader hands
+    // each draw its object index as firstInstance; the renderer falls back
+    // to recording one draw per mesh without them.
+    const auto supported_features =
+        m_physical_device
+            .getFeatures2<vk::PhysicalDeviceFeatures2,
+                          vk::PhysicalDeviceVulkan12Features>();
+    const vk::PhysicalDeviceFeatures &core_features =
+        supported_features.get<vk::PhysicalDeviceFeatures2>().features;
+    m_draw_indirect_count =
+        core_features.multiDrawIndirect &&
+        core_features.drawIndirectFirstInstance &&
+        supported_features.get<vk::PhysicalDeviceVulkan12Features>()
+            .drawIndirectCount;
+    // The renderer's bindless heap indexes descriptor arrays with push
+    // constants and updates them after binding. Descriptor indexing is
+    // optional even in Vulkan 1.3, so every feature it uses is checked.
+    const auto &vulkan_12_supported =
+        supported_features.get<vk::PhysicalDeviceVulkan12Features>();
+    const std::array<std::pair<const char *, vk::Bool32>, 10>
+        bindless_features{{
+            {"shaderSampledImageArrayDynamicIndexing",
+             core_features.shaderSampledImageArrayDynamicIndexing},
+            {"shaderStorageBufferArrayDynamicIndexing",
+             core_features.shaderStorageBufferArrayDynamicIndexing},
+            {"descriptorIndexing", vulkan_12_supported.descriptorIndexing},
+            {"shaderSampledImageArrayNonUniformIndexing",
+             vulkan_12_supported.shaderSampledImageArrayNonUniformIndexing},
+            {"shaderStorageBufferArrayNonUniformIndexing",
+             vulkan_12_supported.shaderStorageBufferArrayNonUniformIndexing},
+            {"descriptorBindingSampledImageUpdateAfterBind",
+             vulkan_12_supported.descriptorBindingSampledImageUpdateAfterBind},
+            {"descriptorBindingStorageBufferUpdateAfterBind",
+             vulkan_12_supported
+                 .descriptorBindingStorageBufferUpdateAfterBind},
+            {"descriptorBindingUpdateUnusedWhilePending",
+             vulkan_12_supported.descriptorBindingUpdateUnusedWhilePending},
+            {"descriptorBindingPartiallyBound",
+             vulkan_12_supported.descriptorBindingPartiallyBound},
+            {"runtimeDescriptorArray",
+             vulkan_12_supported.runtimeDescriptorArray},
+        }};
+    std::string missing;
+    for (const auto &[name, supported] : bindless_features) {
+      if (!supported)
+        missing += fmt::format("{0}{1}", missing.empty() ? "" : ", ", name);
+    }
+    if (!missing.empty())
+      throw std::runtime_error(fmt::format(
+          "{0} lacks descriptor indexing features the renderer needs: {1}",
+          m_physical_device.getProperties().deviceName.data(), missing));
+    const vk::PhysicalDeviceFeatures device_features{
+        .multiDrawIndirect = m_draw_indirect_count,
+        .drawIndirectFirstInstance = m_draw_indirect_count,
+        .shaderSampledImageArrayDynamicIndexing = true,
+        .shaderStorageBufferArrayDynamicIndexing = true,
+    };
+    vk::PhysicalDeviceVulkan12Features vulkan_12_features{
+        .drawIndirectCount = m_draw_indirect_count,
+        .descriptorIndexing = true,
+        .shaderSampledImageArrayNonUniformIndexing = true,
+        .shaderStorageBufferArrayNonUniformIndexing = true,
+        .descriptorBindingSampledImageUpdateAfterBind = true,
+        .descriptorBindingStorageBufferUpdateAfterBind = true,
+        .descriptorBindingUpdateUnusedWhilePending = true,
+        .descriptorBindingPartiallyBound = true,
+        .runtimeDescriptorArray = true,
+        .timelineSemaphore = true,
+    };
     vk::PhysicalDeviceVulkan13Features vulkan_13_features{
         .synchronization2 = true,
         .dynamicRendering = true,
     };
     vk::DeviceCreateInfo device_create_info{
-        .queueCreateInfoCount = 1,
-        .pQueueCreateInfos = &queue_create_info,
+        .queueCreateInfoCount =
+            static_cast<uint32_t>(queue_create_infos.size()),
+        .pQueueCreateInfos = queue_create_infos.data(),
         .enabledExtensionCount =
             static_cast<uint32_t>(device_extensions.size()),
         .ppEnabledExtensionNames = device_extensions.data(),
+        .pEnabledFeatures = &device_features,
     };
-    m_device = m_physical_device.createDevice(
-        vk::StructureChain<vk::DeviceCreateInfo,
-                           vk::PhysicalDeviceVulkan13Features>(
-            device_create_info, vulkan_13_features)
-            .get());
-    m_queues.reserve(1);
-    m_device.getQueue(0, 0, &m_queues[0]);
+    vk::StructureChain<vk::DeviceCreateInfo, vk::PhysicalDeviceVulkan12Features,
+                       vk::PhysicalDeviceVulkan13Features,
+                       vk::PhysicalDevicePresentIdFeaturesKHR,
+                       vk::PhysicalDevicePresentWaitFeaturesKHR>
+        device_create_chain(device_create_info, vulkan_12_features,
+                            vulkan_13_features,
+                            vk::PhysicalDevicePresentIdFeaturesKHR{
+                                .presentId = true,
+                            },
+                            vk::PhysicalDevicePresentWaitFeaturesKHR{
+                                .presentWait = true,
+                            });
+    if (!present_wait) {
+      device_create_chain.unlink<vk::PhysicalDevicePresentIdFeaturesKHR>();
+      device_create_chain.unlink<vk::PhysicalDevicePresentWaitFeaturesKHR>();
+    }
+    m_device = m_physical_device.createDevice(device_create_chain.get());
+    if (present_wait) {
+      m_wait_for_present = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+          m_device.getProcAddr("vkWaitForPresentKHR"));
+    }
+    m_queues.resize(1);
+    m_device.getQueue(m_graphics_queue_family, 0, &m_queues[0]);
+    m_device.getQueue(m_compute_queue_family, 0, &m_compute_queue);
+    m_device.getQueue(m_transfer_queue_family, transfer_queue_index,
+                      &m_transfer_queue);
+    // Queues that turned out to be the same share a lock.
+    m_compute_queue_mutex = m_compute_queue == m_queues[0]
+                                ? &m_queue_mutexes[0]
+                                : &m_queue_mutexes[1];
+    m_transfer_queue_mutex = m_transfer_queue == m_queues[0]
+                                 ? &m_queue_mutexes[0]
+                             : m_transfer_queue == m_compute_queue
+                                 ? m_compute_queue_mutex
+                                 : &m_queue_mutexes[2];
+    spdlog::info("Using queue family {0} for graphics, {1} for compute{2} "
+                 "and {3} (queue {4}) for transfers",
+                 m_graphics_queue_family, m_compute_queue_family,
+                 async_compute() ? "" : " (not async)",
+                 m_transfer_queue_family, transfer_queue_index);
 
     m_allocator = vma::createAllocator(vma::AllocatorCreateInfo{
         .physicalDevice = m_physical_device,
@@ -76,117 +403,12 @@ Context::Context() {
         .vulkanApiVersion = VK_API_VERSION_1_3,
     });
 
-    m_surface = vkfw::createWindowSurface(m_instance, m_window);
-    std::vector<vk::SurfaceFormatKHR> surface_formats =
-        m_physical_device.getSurfaceFormatsKHR(m_surface);
-    assert(!surface_formats.empty());
-    m_color_attachment_format =
-        (surface_formats[0].format == vk::Format::eUndefined)
-            ? vk::Format::eB8G8R8A8Unorm
-            : surface_formats[0].format;
-    vk::SurfaceCapabilitiesKHR surface_capabilities =
-        m_physical_device.getSurfaceCapabilitiesKHR(m_surface);
-    vk::SurfaceTransformFlagBitsKHR pre_transform =
-        (surface_capabilities.supportedTransforms &
-         vk::SurfaceTransformFlagBitsKHR::eIdentity)
-            ? vk::SurfaceTransformFlagBitsKHR::eIdentity
-            : surface_capabilities.currentTransform;
-
-    vk::CompositeAlphaFlagBitsKHR composite_alpha =
-        (surface_capabilities.supportedCompositeAlpha &
-         vk::CompositeAlphaFlagBitsKHR::ePreMultiplied)
-            ? vk::CompositeAlphaFlagBitsKHR::ePreMultiplied
-        : (surface_capabilities.supportedCompositeAlpha &
-           vk::CompositeAlphaFlagBitsKHR::ePostMultiplied)
-            ? vk::CompositeAlphaFlagBitsKHR::ePostMultiplied
-        : (surface_capabilities.supportedCompositeAlpha &
-           vk::CompositeAlphaFlagBitsKHR::eInherit)
-            ? vk::CompositeAlphaFlagBitsKHR::eInherit
-            : vk::CompositeAlphaFlagBitsKHR::eOpaque;
-
-    m_swapchain = m_device.createSwapchainKHR(vk::SwapchainCreateInfoKHR{
-        .surface = m_surface,
-        .minImageCount = surface_capabilities.minImageCount,
-        .imageFormat = m_color_attachment_format,
-        .imageColorSpace = vk::ColorSpaceKHR::eSrgbNonlinear,
-        .imageExtent =
-            {
-                static_cast<uint32_t>(m_video_mode.width),
-                static_cast<uint32_t>(m_video_mode.height),
-            },
-        .imageArrayLayers = 1,
-        .imageUsage = vk::ImageUsageFlagBits::eColorAttachment,
-        .imageSharingMode = vk::SharingMode::eExclusive,
-        .preTransform = pre_transform,
-        .compositeAlpha = composite_alpha,
-        .presentMode = vk::PresentModeKHR::eFifo,
-        .clipped = true,
-        .oldSwapchain = nullptr,
-    });
-
-    m_swapchain_images = m_device.getSwapchainImagesKHR(m_swapchain);
-    m_swapchain_image_views.reserve(m_swapchain_images.size());
-    for (auto image : m_swapchain_images) {
-      vk::ImageViewCreateInfo image_view_create_info{
-          .image = image,
-          .viewType = vk::ImageViewType::e2D,
-          .format = m_color_attachment_format,
-          .components = {},
-          .subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1}};
-      m_swapchain_image_views.push_back(
-          m_device.createImageView(image_view_create_info));
-    }
-
-    const vk::Format depth_format = vk::Format::eD16Unorm;
-    vk::FormatProperties format_properties =
-        m_physical_device.getFormatProperties(depth_format);
-
-    vk::ImageTiling tiling;
-    if (format_properties.linearTilingFeatures &
-        vk::FormatFeatureFlagBits::eDepthStencilAttachment) {
-      tiling = vk::ImageTiling::eLinear;
-    } else if (format_properties.optimalTilingFeatures &
-               vk::FormatFeatureFlagBits::eDepthStencilAttachment) {
-      tiling = vk::ImageTiling::eOptimal;
+    if (m_headless) {
+      create_offscreen_images(create_info.offscreen_image_count);
     } else {
-      throw std::runtime_error(
-          "DepthStencilAttachment is not supported for D16Unorm depth format.");
+      create_surface();
+      create_swapchain();
     }
-    vk::ImageCreateInfo depth_image_create_info{
-        .imageType = vk::ImageType::e2D,
-        .format = depth_format,
-        .extent =
-            vk::Extent3D{.width = static_cast<uint32_t>(m_video_mode.width),
-                         .height = static_cast<uint32_t>(m_video_mode.height),
-                         .depth = 1},
-        .mipLevels = 1,
-        .arrayLayers = 1,
-        .samples = vk::SampleCountFlagBits::e1,
-        .tiling = tiling,
-        .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment,
-    };
-
-    vma::AllocationCreateInfo depth_image_allocation_info{
-        .flags = vma::AllocationCreateFlagBits::eDedicatedMemory,
-        .usage = vma::MemoryUsage::eAuto,
-        .priority = 1.f,
-    };
-    auto [m_depth_image, m_depth_image_allocation] = m_allocator.createImage(
-        depth_image_create_info, depth_image_allocation_info);
-
-    m_depth_image_view = m_device.createImageView(vk::ImageViewCreateInfo{
-        .image = m_depth_image,
-        .viewType = vk::ImageViewType::e2D,
-        .format = depth_format,
-        .subresourceRange =
-            {
-                .aspectMask = vk::ImageAspectFlagBits::eDepth,
-                .baseMipLevel = 0,
-                .levelCount = 1,
-                .baseArrayLayer = 0,
-                .layerCount = 1,
-            },
-    });
   } catch (vk::SystemError &err) {
     spdlog::error("Caught vulkan system error: {0}", err.what());
     exit(-1);
@@ -199,54 +421,238 @@ Context::Context() {
   }
 }
 Context::~Context() {
-  m_allocator.destroyImage(m_depth_image, m_depth_image_allocation);
-  m_allocator.freeMemory(m_depth_image_allocation);
-  for (int i = 0; i < m_buffers.size(); i++) {
-    m_allocator.destroyBuffer(m_buffers[i], m_buffer_allocations[i]);
-    m_allocator.freeMemory(m_buffer_allocations[i]);
+  // The owner of the context has waited for the device to go idle.
+  for (auto &retired : m_retired_buffers) {
+    m_allocator.destroyBuffer(retired.buffer.buffer,
+                              retired.buffer.allocation);
   }
-  m_allocator.destroy();
+  m_buffers.each([&](types::BufferHandle, types::Buffer &buffer) {
+    m_allocator.destroyBuffer(buffer.buffer, buffer.allocation);
+  });
   for (auto &i : m_swapchain_image_views) {
     m_device.destroyImageView(i);
   }
-  for (auto &i : m_swapchain_images) {
-    m_device.destroyImage(i);
+  if (m_headless) {
+    for (size_t i = 0; i < m_swapchain_images.size(); i++) {
+      m_allocator.destroyImage(m_swapchain_images[i],
+                               m_offscreen_image_allocations[i]);
+    }
+  }
+  m_allocator.destroy();
+  if (!m_headless) {
+    m_device.destroySwapchainKHR(m_swapchain);
+    m_instance.destroySurfaceKHR(m_surface);
   }
-  m_device.destroySwapchainKHR(m_swapchain);
-  m_instance.destroySurfaceKHR(m_surface);
   m_device.destroy();
   m_instance.destroy();
 }
 
-vk::ShaderModule Context::load_shader(std::string shader_path) {
-  vk::ShaderModule out;
-  try {
+types::BufferHandle Context::create_buffer(
+    const vk::BufferCreateInfo &buffer_create_info,
+    const vma::AllocationCreateInfo &allocation_create_info) {
+  vma::AllocationInfo allocation_info;
+  auto [buffer, allocation] = m_allocator.createBuffer(
+      buffer_create_info, allocation_create_info, &allocation_info);
+  return m_buffers.create(types::Buffer{
+      .buffer = buffer,
+      .allocation = allocation,
+      .size = buffer_create_info.size,
+      .mapped = allocation_info.pMappedData,
+  });
+}
 
-    std::ifstream shader_file(shader_path, std::ios::ate | std::ios::binary);
-    if (!shader_file.is_open())
-      throw std::runtime_error(
-          fmt::format("Failed to open shader file: {0}", shader_path));
+void Context::destroy_buffer(types::BufferHandle handle,
+                             uint64_t upload_value) {
+  std::optional<types::Buffer> buffer = m_buffers.destroy(handle);
+  if (!buffer) {
+    if (handle)
+      spdlog::warn("Ignoring destroy of stale buffer handle {0:#x}",
+                   handle.value());
+    return;
+  }
+  m_retired_buffers.push_back(RetiredBuffer{
+      .buffer = *buffer,
+      .frame = m_frame,
+      .upload_value = upload_value,
+  });
+}
 
-    auto shader_file_size = shader_file.tellg();
-    shader_file.seekg(0);
-    std::vector<uint32_t> buffer(shader_file_size / sizeof(uint32_t));
-    shader_file.read(reinterpret_cast<char *>(buffer.data()), shader_file_size);
-    shader_file.close();
+void Context::begin_frame(uint64_t frame, uint64_t completed_frame,
+                          uint64_t completed_upload_value) {
+  m_frame = frame;
+  std::erase_if(m_retired_buffers, [&](const RetiredBuffer &retired) {
+    if (retired.frame > completed_frame ||
+        retired.upload_value > completed_upload_value)
+      return false;
+    m_allocator.destroyBuffer(retired.buffer.buffer,
+                              retired.buffer.allocation);
+    return true;
+  });
+}
 
-    out = m_device.createShaderModule(vk::ShaderModuleCreateInfo{
-        .codeSize = static_cast<size_t>(shader_file_size),
-        .pCode = buffer.data(),
-    });
-  } catch (std::exception &err) {
-    spdlog::error("Encountered a system error: {0}", err.what());
-    exit(-1);
-  } catch (vk::SystemError &err) {
-    spdlog::error("Encountered a vulkan error: {0}", err.what());
-    exit(-1);
-  } catch (...) {
-    spdlog::error("Encountered an unknown error");
-    exit(-1);
+void Context::create_surface() {
+  m_surface = vkfw::createWindowSurface(m_instance, m_window);
+  if (!m_physical_device.getSurfaceSupportKHR(m_graphics_queue_family,
+                                              m_surface))
+    throw std::runtime_error(
+        fmt::format("Queue family {0} can't present to the window",
+                    m_graphics_queue_family));
+  std::vector<vk::SurfaceFormatKHR> surface_formats =
+      m_physical_device.getSurfaceFormatsKHR(m_surface);
+  assert(!surface_formats.empty());
+  // Kept across recreation, so pipelines built against it stay valid.
+  m_color_attachment_format =
+      (surface_formats[0].format == vk::Format::eUndefined)
+          ? vk::Format::eB8G8R8A8Unorm
+          : surface_formats[0].format;
+}
+
+void Context::create_swapchain(vk::SwapchainKHR old_swapchain) {
+  vk::SurfaceCapabilitiesKHR surface_capabilities =
+      m_physical_device.getSurfaceCapabilitiesKHR(m_surface);
+  vk::SurfaceTransformFlagBitsKHR pre_transform =
+      (surface_capabilities.supportedTransforms &
+       vk::SurfaceTransformFlagBitsKHR::eIdentity)
+          ? vk::SurfaceTransformFlagBitsKHR::eIdentity
+          : surface_capabilities.currentTransform;
+
+  vk::CompositeAlphaFlagBitsKHR composite_alpha =
+      (surface_capabilities.supportedCompositeAlpha &
+       vk::CompositeAlphaFlagBitsKHR::ePreMultiplied)
+          ? vk::CompositeAlphaFlagBitsKHR::ePreMultiplied
+      : (surface_capabilities.supportedCompositeAlpha &
+         vk::CompositeAlphaFlagBitsKHR::ePostMultiplied)
+          ? vk::CompositeAlphaFlagBitsKHR::ePostMultiplied
+      : (surface_capabilities.supportedCompositeAlpha &
+         vk::CompositeAlphaFlagBitsKHR::eInherit)
+          ? vk::CompositeAlphaFlagBitsKHR::eInherit
+          : vk::CompositeAlphaFlagBitsKHR::eOpaque;
+
+  // The surface's size when it dictates one, otherwise the window's.
+  if (surface_capabilities.currentExtent.width != UINT32_MAX) {
+    m_extent = surface_capabilities.currentExtent;
+  } else {
+    const vk::Extent2D framebuffer = framebuffer_extent();
+    m_extent = vk::Extent2D{
+        std::clamp(framebuffer.width, surface_capabilities.minImageExtent.width,
+                   surface_capabilities.maxImageExtent.width),
+        std::clamp(framebuffer.height,
+                   surface_capabilities.minImageExtent.height,
+                   surface_capabilities.maxImageExtent.height),
+    };
+  }
+
+  const std::vector<vk::PresentModeKHR> supported_modes =
+      m_physical_device.getSurfacePresentModesKHR(m_surface);
+  for (vk::PresentModeKHR mode : preferred_present_modes(m_present_policy)) {
+    if (std::find(supported_modes.begin(), supported_modes.end(), mode) !=
+        supported_modes.end()) {
+      m_present_mode = mode;
+      break;
+    }
+  }
+  const uint32_t image_count = swapchain_image_count(
+      m_present_policy, m_present_mode, surface_capabilities);
+
+  m_swapchain = m_device.createSwapchainKHR(vk::SwapchainCreateInfoKHR{
+      .surface = m_surface,
+      .minImageCount = image_count,
+      .imageFormat = m_color_attachment_format,
+      .imageColorSpace = vk::ColorSpaceKHR::eSrgbNonlinear,
+      .imageExtent = m_extent,
+      .imageArrayLayers = 1,
+      .imageUsage = vk::ImageUsageFlagBits::eColorAttachment,
+      .imageSharingMode = vk::SharingMode::eExclusive,
+      .preTransform = pre_transform,
+      .compositeAlpha = composite_alpha,
+      .presentMode = m_present_mode,
+      .clipped = true,
+      .oldSwapchain = old_swapchain,
+  });
+
+  m_swapchain_images = m_device.getSwapchainImagesKHR(m_swapchain);
+  m_swapchain_image_views.reserve(m_swapchain_images.size());
+  for (auto image : m_swapchain_images) {
+    vk::ImageViewCreateInfo image_view_create_info{
+        .image = image,
+        .viewType = vk::ImageViewType::e2D,
+        .format = m_color_attachment_format,
+        .components = {},
+        .subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1}};
+    m_swapchain_image_views.push_back(
+        m_device.createImageView(image_view_create_info));
+  }
+  spdlog::info("Swapchain: {0}x{1}, {2} images, {3} ({4} policy)",
+               m_extent.width, m_extent.height, m_swapchain_images.size(),
+               vk::to_string(m_present_mode),
+               present_policy_name(m_present_policy));
+}
+
+vk::Extent2D Context::framebuffer_extent() {
+  if (m_headless)
+    return m_extent;
+  const auto [width, height] = m_window.getFramebufferSize();
+  return vk::Extent2D{static_cast<uint32_t>(width),
+                      static_cast<uint32_t>(height)};
+}
+
+bool Context::recreate_swapchain() {
+  if (m_headless)
+    return true;
+  const vk::Extent2D framebuffer = framebuffer_extent();
+  if (framebuffer.width == 0 || framebuffer.height == 0)
+    return false;
+
+  for (auto &view : m_swapchain_image_views) {
+    m_device.destroyImageView(view);
+  }
+  m_swapchain_image_views.clear();
+  const vk::SwapchainKHR old_swapchain = m_swapchain;
+  create_swapchain(old_swapchain);
+  m_device.destroySwapchainKHR(old_swapchain);
+  return true;
+}
+
+vk::Result Context::wait_for_present(uint64_t present_id, uint64_t timeout) {
+  return static_cast<vk::Result>(m_wait_for_present(
+      m_device, m_swapchain, present_id, timeout));
+}
+
+void Context::create_offscreen_images(uint32_t image_count) {
+  m_color_attachment_format = vk::Format::eR8G8B8A8Unorm;
+  m_swapchain_images.reserve(image_count);
+  m_swapchain_image_views.reserve(image_count);
+  m_offscreen_image_allocations.reserve(image_count);
+  for (uint32_t i = 0; i < image_count; i++) {
+    auto [image, allocation] = m_allocator.createImage(
+        vk::ImageCreateInfo{
+            .imageType = vk::ImageType::e2D,
+            .format = m_color_attachment_format,
+            .extent = vk::Extent3D{.width = m_extent.width,
+                                   .height = m_extent.height,
+                                   .depth = 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = vk::SampleCountFlagBits::e1,
+            .tiling = vk::ImageTiling::eOptimal,
+            .usage = vk::ImageUsageFlagBits::eColorAttachment |
+                     vk::ImageUsageFlagBits::eTransferSrc,
+        },
+        vma::AllocationCreateInfo{
+            .flags = vma::AllocationCreateFlagBits::eDedicatedMemory,
+            .usage = vma::MemoryUsage::eAuto,
+            .priority = 1.f,
+        });
+    m_swapchain_images.push_back(image);
+    m_offscreen_image_allocations.push_back(allocation);
+    m_swapchain_image_views.push_back(
+        m_device.createImageView(vk::ImageViewCreateInfo{
+            .image = image,
+            .viewType = vk::ImageViewType::e2D,
+            .format = m_color_attachment_format,
+            .components = {},
+            .subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0,
+                                 1}}));
   }
-  return out;
 }
 } // namespace bs::engine::context
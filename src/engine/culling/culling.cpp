@@ -0,0 +1,305 @@
+#include <engine/culling/culling.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BS_CULLING_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BS_TARGET_AVX2
+#else
+#define BS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace bs::engine::culling {
+namespace {
+// Spheres per parallel job; a multiple of the batch width so every job
+// starts on a batch boundary.
+constexpr uint32_t job_chunk_size = 4096;
+
+glm::vec4 row(const glm::mat4 &matrix, int index) {
+  return glm::vec4(matrix[0][index], matrix[1][index], matrix[2][index],
+                   matrix[3][index]);
+}
+
+// A degenerate matrix (the camera before it's set up) gives zero planes,
+// which accept everything rather than dividing by zero.
+glm::vec4 normalize_plane(const glm::vec4 &plane) {
+  const float length = glm::length(glm::vec3(plane));
+  return length > 0.f ? plane / length : glm::vec4(0.f);
+}
+
+// Lane indices of the set bits of each 8-bit mask, packed to the front, so
+// a compare mask turns into a visible-index store without branching.
+struct CompactTable {
+  alignas(32) std::array<std::array<uint32_t, 8>, 256> lanes{};
+
+  constexpr CompactTable() {
+    for (uint32_t mask = 0; mask < 256; mask++) {
+      uint32_t count = 0;
+      for (uint32_t lane = 0; lane < 8; lane++) {
+        if (mask & (1u << lane))
+          lanes[mask][count++] = lane;
+      }
+    }
+  }
+};
+constexpr CompactTable compact_table;
+
+// Lanes at or past `end` belong to another range or to the padding.
+uint32_t tail_mask(uint32_t index, uint32_t end, uint32_t width) {
+  return end - index >= width ? (1u << width) - 1
+                              : (1u << (end - index)) - 1;
+}
+
+uint32_t cull_scalar(const Frustum &frustum, const SphereSoA &spheres,
+                     uint32_t begin, uint32_t end, uint32_t *visible) {
+  uint32_t count = 0;
+  for (uint32_t i = begin; i < end; i++) {
+    const glm::vec3 center(spheres.x()[i], spheres.y()[i], spheres.z()[i]);
+    if (frustum.visible(center, spheres.radius()[i]))
+      visible[count++] = i;
+  }
+  return count;
+}
+
+#ifdef BS_CULLING_X86
+uint32_t cull_sse2(const Frustum &frustum, const SphereSoA &spheres,
+                   uint32_t begin, uint32_t end, uint32_t *visible) {
+  __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+  for (size_t p = 0; p < 6; p++) {
+    plane_x[p] = _mm_set1_ps(frustum.planes[p].x);
+    plane_y[p] = _mm_set1_ps(frustum.planes[p].y);
+    plane_z[p] = _mm_set1_ps(frustum.planes[p].z);
+    plane_w[p] = _mm_set1_ps(frustum.planes[p].w);
+  }
+  const __m128 sign = _mm_set1_ps(-0.f);
+
+  uint32_t count = 0;
+  for (uint32_t i = begin; i < end; i += 4) {
+    const __m128 x = _mm_loadu_ps(spheres.x() + i);
+    const __m128 y = _mm_loadu_ps(spheres.y() + i);
+    const __m128 z = _mm_loadu_ps(spheres.z() + i);
+    const __m128 negative_radius =
+        _mm_xor_ps(_mm_loadu_ps(spheres.radius() + i), sign);
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (size_t p = 0; p < 6; p++) {
+      const __m128 distance = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(plane_x[p], x), _mm_mul_ps(plane_y[p], y)),
+          _mm_add_ps(_mm_mul_ps(plane_z[p], z), plane_w[p]));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+    }
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside)) &
+                          tail_mask(i, end, 4);
+    const __m128i lanes = _mm_load_si128(
+        reinterpret_cast<const __m128i *>(compact_table.lanes[mask].data()));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(visible + count),
+                     _mm_add_epi32(lanes, _mm_set1_epi32(i)));
+    count += std::popcount(mask);
+  }
+  return count;
+}
+
+BS_TARGET_AVX2
+uint32_t cull_avx2(const Frustum &frustum, const SphereSoA &spheres,
+                   uint32_t begin, uint32_t end, uint32_t *visible) {
+  __m256 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+  for (size_t p = 0; p < 6; p++) {
+    plane_x[p] = _mm256_set1_ps(frustum.planes[p].x);
+    plane_y[p] = _mm256_set1_ps(frustum.planes[p].y);
+    plane_z[p] = _mm256_set1_ps(frustum.planes[p].z);
+    plane_w[p] = _mm256_set1_ps(frustum.planes[p].w);
+  }
+  const __m256 sign = _mm256_set1_ps(-0.f);
+
+  uint32_t count = 0;
+  for (uint32_t i = begin; i < end; i += 8) {
+    const __m256 x = _mm256_loadu_ps(spheres.x() + i);
+    const __m256 y = _mm256_loadu_ps(spheres.y() + i);
+    const __m256 z = _mm256_loadu_ps(spheres.z() + i);
+    const __m256 negative_radius =
+        _mm256_xor_ps(_mm256_loadu_ps(spheres.radius() + i), sign);
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (size_t p = 0; p < 6; p++) {
+      const __m256 distance =
+          _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_x[p], x),
+                                      _mm256_mul_ps(plane_y[p], y)),
+                        _mm256_add_ps(_mm256_mul_ps(plane_z[p], z),
+                                      plane_w[p]));
+      inside = _mm256_and_ps(
+          inside, _mm256_cmp_ps(distance, negative_radius, _CMP_GE_OQ));
+    }
+    const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside)) &
+                          tail_mask(i, end, 8);
+    const __m256i lanes = _mm256_load_si256(
+        reinterpret_cast<const __m256i *>(compact_table.lanes[mask].data()));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(visible + count),
+                        _mm256_add_epi32(lanes, _mm256_set1_epi32(i)));
+    count += std::popcount(mask);
+  }
+  return count;
+}
+
+bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int registers[4];
+  __cpuid(registers, 1);
+  // The OS has to save the YMM registers too.
+  const bool os_saves_ymm = (registers[2] & (1 << 27)) &&
+                            (_xgetbv(0) & 0x6) == 0x6;
+  __cpuidex(registers, 7, 0);
+  return os_saves_ymm && (registers[1] & (1 << 5));
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+} // namespace
+
+Frustum Frustum::from_matrix(const glm::mat4 &view_projection) {
+  const glm::vec4 x = row(view_projection, 0);
+  const glm::vec4 y = row(view_projection, 1);
+  const glm::vec4 z = row(view_projection, 2);
+  const glm::vec4 w = row(view_projection, 3);
+  return Frustum{
+      .planes =
+          {
+              normalize_plane(w + x),
+              normalize_plane(w - x),
+              normalize_plane(w + y),
+              normalize_plane(w - y),
+              // Vulkan clips depth to 0 <= z <= w.
+              normalize_plane(z),
+              normalize_plane(w - z),
+          },
+  };
+}
+
+Frustum Frustum::from_camera(const types::CameraUBO &camera) {
+  return from_matrix(camera.proj * camera.view * camera.model);
+}
+
+bool Frustum::visible(const glm::vec3 &center, float radius) const {
+  for (const glm::vec4 &plane : planes) {
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+      return false;
+  }
+  return true;
+}
+
+glm::vec4 transform_sphere(const glm::mat4 &transform,
+                           const glm::vec4 &sphere) {
+  const glm::vec4 center = transform * glm::vec4(glm::vec3(sphere), 1.f);
+  const float scale = std::sqrt(std::max(
+      {glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+       glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+       glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))}));
+  return glm::vec4(glm::vec3(center), sphere.w * scale);
+}
+
+void SphereSoA::clear() {
+  m_x.clear();
+  m_y.clear();
+  m_z.clear();
+  m_radius.clear();
+  m_size = 0;
+}
+
+void SphereSoA::reserve(uint32_t count) {
+  const uint32_t padded = (count + batch_width - 1) / batch_width * batch_width;
+  m_x.reserve(padded);
+  m_y.reserve(padded);
+  m_z.reserve(padded);
+  m_radius.reserve(padded);
+}
+
+uint32_t SphereSoA::push_back(const glm::vec3 &center, float radius) {
+  if (m_size == m_x.size()) {
+    // Grow by a batch of padding, then overwrite its first element.
+    m_x.resize(m_size + batch_width, 0.f);
+    m_y.resize(m_size + batch_width, 0.f);
+    m_z.resize(m_size + batch_width, 0.f);
+    m_radius.resize(m_size + batch_width,
+                    -std::numeric_limits<float>::infinity());
+  }
+  set(m_size, center, radius);
+  return m_size++;
+}
+
+void SphereSoA::set(uint32_t index, const glm::vec3 &center, float radius) {
+  m_x[index] = center.x;
+  m_y[index] = center.y;
+  m_z[index] = center.z;
+  m_radius[index] = radius;
+}
+
+CullKernel best_cull_kernel() {
+#ifdef BS_CULLING_X86
+  static const CullKernel kernel =
+      cpu_has_avx2() ? CullKernel::eAvx2 : CullKernel::eSse2;
+  return kernel;
+#else
+  return CullKernel::eScalar;
+#endif
+}
+
+const char *cull_kernel_name(CullKernel kernel) {
+  switch (kernel) {
+  case CullKernel::eScalar:
+    return "scalar";
+  case CullKernel::eSse2:
+    return "sse2";
+  case CullKernel::eAvx2:
+    return "avx2";
+  }
+  return "unknown";
+}
+
+uint32_t cull_spheres(const Frustum &frustum, const SphereSoA &spheres,
+                      uint32_t begin, uint32_t end, uint32_t *visible,
+                      CullKernel kernel) {
+  switch (kernel) {
+#ifdef BS_CULLING_X86
+  case CullKernel::eAvx2:
+    return cull_avx2(frustum, spheres, begin, end, visible);
+  case CullKernel::eSse2:
+    return cull_sse2(frustum, spheres, begin, end, visible);
+#endif
+  default:
+    return cull_scalar(frustum, spheres, begin, end, visible);
+  }
+}
+
+void cull_spheres(jobs::JobSystem &job_system, const Frustum &frustum,
+                  const SphereSoA &spheres, std::vector<uint32_t> &visible,
+                  CullKernel kernel) {
+  const uint32_t size = spheres.size();
+  const uint32_t chunk_count = (size + job_chunk_size - 1) / job_chunk_size;
+  // Each chunk writes to its own slice, then the slices are packed
+  // together.
+  visible.resize(spheres.padded_size());
+  std::vector<uint32_t> counts(chunk_count);
+  job_system.parallel_for(chunk_count, [&](uint32_t first, uint32_t last) {
+    for (uint32_t chunk = first; chunk < last; chunk++) {
+      const uint32_t begin = chunk * job_chunk_size;
+      const uint32_t end = std::min(begin + job_chunk_size, size);
+      counts[chunk] = cull_spheres(frustum, spheres, begin, end,
+                                   visible.data() + begin, kernel);
+    }
+  });
+  uint32_t count = chunk_count > 0 ? counts[0] : 0;
+  for (uint32_t chunk = 1; chunk < chunk_count; chunk++) {
+    std::memmove(visible.data() + count,
+                 visible.data() + chunk * job_chunk_size,
+                 counts[chunk] * sizeof(uint32_t));
+    count += counts[chunk];
+  }
+  visible.resize(count);
+}
+} // namespace bs::engine::culling
@@ -0,0 +1,88 @@
+#include <engine/ecs/archetype.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace bs::engine::ecs {
+namespace {
+size_t align_up(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+Archetype::Archetype(ComponentMask mask) : m_mask(mask) {
+  for (ComponentId id = 0; id < max_components; id++) {
+    if (has(id))
+      m_components.push_back(id);
+  }
+
+  std::vector<size_t> alignments;
+  m_column_sizes.push_back(sizeof(Entity));
+  alignments.push_back(alignof(Entity));
+  for (ComponentId id : m_components) {
+    m_columns[id] = static_cast<uint8_t>(m_column_sizes.size());
+    m_column_sizes.push_back(component_info(id).size);
+    alignments.push_back(component_info(id).alignment);
+  }
+
+  size_t row_bytes = 0;
+  for (size_t size : m_column_sizes)
+    row_bytes += size;
+  // Start from the unpadded estimate and shrink until the padded layout
+  // fits into one chunk.
+  m_offsets.resize(m_column_sizes.size());
+  m_chunk_capacity =
+      std::max<uint32_t>(static_cast<uint32_t>(chunk_bytes / row_bytes), 1);
+  for (;; m_chunk_capacity--) {
+    size_t offset = 0;
+    for (size_t column = 0; column < m_column_sizes.size(); column++) {
+      offset = align_up(offset, std::max(cache_line_size, alignments[column]));
+      m_offsets[column] = offset;
+      offset += m_column_sizes[column] * m_chunk_capacity;
+    }
+    if (offset <= chunk_bytes || m_chunk_capacity == 1) {
+      assert(offset <= chunk_bytes && "Archetype row does not fit a chunk");
+      break;
+    }
+  }
+}
+Archetype::~Archetype() {
+  for (uint32_t row = 0; row < m_count; row++) {
+    for (ComponentId id : m_components)
+      component_info(id).destroy(component(id, row));
+  }
+  for (std::byte *chunk : m_chunks)
+    ::operator delete(chunk, std::align_val_t{cache_line_size});
+}
+
+uint32_t Archetype::allocate_row(Entity entity) {
+  const uint32_t row = m_count++;
+  if (row / m_chunk_capacity >= m_chunks.size()) {
+    m_chunks.push_back(static_cast<std::byte *>(
+        ::operator new(chunk_bytes, std::align_val_t{cache_line_size})));
+  }
+  entities(row / m_chunk_capacity)[row % m_chunk_capacity] = entity;
+  return row;
+}
+
+Entity Archetype::remove_row(uint32_t row) {
+  assert(row < m_count);
+  const uint32_t last = --m_count;
+  for (ComponentId id : m_components) {
+    const ComponentInfo &info = component_info(id);
+    void *removed = component(id, row);
+    info.destroy(removed);
+    if (row != last) {
+      void *moved = component(id, last);
+      info.move_construct(removed, moved);
+      info.destroy(moved);
+    }
+  }
+  if (row == last)
+    return Entity{};
+
+  const Entity moved = entity(last);
+  entities(row / m_chunk_capacity)[row % m_chunk_capacity] = moved;
+  return moved;
+}
+} // namespace bs::engine::ecs
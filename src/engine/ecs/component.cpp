@@ -0,0 +1,36 @@
+#include <engine/ecs/component.hpp>
+
+#include <mutex>
+#include <stdexcept>
+
+namespace bs::engine::ecs {
+namespace {
+std::mutex &registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+std::vector<ComponentInfo> &registry() {
+  // Reserved up front so registering never reallocates under a reader.
+  static std::vector<ComponentInfo> components = [] {
+    std::vector<ComponentInfo> out;
+    out.reserve(max_components);
+    return out;
+  }();
+  return components;
+}
+} // namespace
+
+ComponentId register_component(const ComponentInfo &info) {
+  std::lock_guard lock(registry_mutex());
+  if (registry().size() >= max_components)
+    throw std::runtime_error("Too many component types for ComponentMask");
+  registry().push_back(info);
+  return static_cast<ComponentId>(registry().size() - 1);
+}
+
+const ComponentInfo &component_info(ComponentId id) {
+  // Entries are never removed, and ids are only handed out after their entry
+  // exists, so reads don't need the lock.
+  return registry()[id];
+}
+} // namespace bs::engine::ecs
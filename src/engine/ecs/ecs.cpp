@@ -1,6 +1,113 @@
 #include <engine/ecs/ecs.hpp>
 
 namespace bs::engine::ecs {
-ECS::ECS() {}
+ECS::ECS() : m_root(find_or_create_archetype(0)) {}
 ECS::~ECS() {}
+
+Entity ECS::create() {
+  uint32_t index;
+  if (!m_free_indices.empty()) {
+    index = m_free_indices.back();
+    m_free_indices.pop_back();
+  } else {
+    index = static_cast<uint32_t>(m_records.size());
+    m_records.emplace_back();
+  }
+
+  EntityRecord &record = m_records[index];
+  const Entity entity{.index = index, .generation = record.generation};
+  record.archetype = m_root;
+  record.row = m_root->allocate_row(entity);
+  m_alive_count++;
+  return entity;
+}
+
+void ECS::destroy(Entity entity) {
+  if (!alive(entity))
+    return;
+  EntityRecord &record = m_records[entity.index];
+  remove_row(record.archetype, record.row);
+  record.archetype = nullptr;
+  record.generation++;
+  m_free_indices.push_back(entity.index);
+  m_alive_count--;
+}
+
+const std::vector<Archetype *> &ECS::query(ComponentMask mask) {
+  {
+    std::shared_lock lock(m_queries_mutex);
+    auto it = m_queries.find(mask);
+    if (it != m_queries.end())
+      return it->second;
+  }
+
+  // unordered_map never moves its values, so the returned reference stays
+  // valid after the lock is released.
+  std::unique_lock lock(m_queries_mutex);
+  auto [it, inserted] = m_queries.try_emplace(mask);
+  if (inserted) {
+    for (auto &[archetype_mask, archetype] : m_archetypes) {
+      if ((archetype_mask & mask) == mask)
+        it->second.push_back(archetype.get());
+    }
+  }
+  return it->second;
+}
+
+Archetype *ECS::find_or_create_archetype(ComponentMask mask) {
+  auto [it, inserted] = m_archetypes.try_emplace(mask);
+  if (!inserted)
+    return it->second.get();
+
+  it->second = std::make_unique<Archetype>(mask);
+  std::unique_lock lock(m_queries_mutex);
+  for (auto &[query_mask, archetypes] : m_queries) {
+    if ((mask & query_mask) == query_mask)
+      archetypes.push_back(it->second.get());
+  }
+  return it->second.get();
+}
+
+Archetype *ECS::archetype_with(Archetype *archetype, ComponentId id) {
+  Archetype *&edge = archetype->add_edge(id);
+  if (edge == nullptr) {
+    edge = find_or_create_archetype(archetype->mask() | ComponentMask{1} << id);
+    edge->remove_edge(id) = archetype;
+  }
+  return edge;
+}
+
+Archetype *ECS::archetype_without(Archetype *archetype, ComponentId id) {
+  Archetype *&edge = archetype->remove_edge(id);
+  if (edge == nullptr) {
+    edge =
+        find_or_create_archetype(archetype->mask() & ~(ComponentMask{1} << id));
+    edge->add_edge(id) = archetype;
+  }
+  return edge;
+}
+
+void ECS::move_entity(Entity entity, Archetype *target) {
+  EntityRecord &record = m_records[entity.index];
+  Archetype *source = record.archetype;
+  const uint32_t source_row = record.row;
+  const uint32_t target_row = target->allocate_row(entity);
+  for (ComponentId id : source->components()) {
+    if (target->has(id)) {
+      component_info(id).move_construct(target->component(id, target_row),
+                                        source->component(id, source_row));
+    }
+  }
+  // Moved-from components are destroyed along with the ones the target
+  // doesn't have.
+  remove_row(source, source_row);
+  record.archetype = target;
+  record.row = target_row;
+}
+
+void ECS::remove_row(Archetype *archetype, uint32_t row) {
+  const Entity moved = archetype->remove_row(row);
+  if (moved.valid())
+    m_records[moved.index].row = row;
+}
 } // namespace bs::engine::ecs
@@ -0,0 +1,122 @@
+#include <engine/ecs/scheduler.hpp>
+#include <engine/profiler/profiler.hpp>
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace bs::engine::ecs {
+namespace {
+constexpr double stats_smoothing = 0.1;
+} // namespace
+
+Scheduler::Scheduler(ECS &ecs, jobs::JobSystem &job_system)
+    : m_ecs(ecs), m_job_system(job_system) {}
+Scheduler::~Scheduler() {}
+
+uint32_t Scheduler::add_system(std::string name, ComponentMask reads,
+                               ComponentMask writes, SystemFunction function) {
+  auto system = std::make_unique<System>();
+  system->name = name;
+  // Writing implies reading for conflict purposes.
+  system->reads = reads | writes;
+  system->writes = writes;
+  system->function = std::move(function);
+  system->stats.name = std::move(name);
+  m_systems.push_back(std::move(system));
+  return static_cast<uint32_t>(m_systems.size() - 1);
+}
+
+bool Scheduler::conflicts(const System &a, const System &b) {
+  return (a.writes & b.reads) != 0 || (b.writes & a.reads) != 0;
+}
+
+void Scheduler::build_graph() {
+  for (auto &system : m_systems) {
+    system->successors.clear();
+    system->dependency_count = 0;
+  }
+  for (uint32_t later = 0; later < m_systems.size(); later++) {
+    System &system = *m_systems[later];
+    if (!system.enabled)
+      continue;
+    for (uint32_t earlier = 0; earlier < later; earlier++) {
+      System &dependency = *m_systems[earlier];
+      if (dependency.enabled && conflicts(dependency, system)) {
+        dependency.successors.push_back(later);
+        system.dependency_count++;
+      }
+    }
+  }
+  for (auto &system : m_systems) {
+    system->remaining_dependencies.store(system->dependency_count,
+                                         std::memory_order_relaxed);
+  }
+}
+
+void Scheduler::run() {
+  BS_PROFILE_ZONE("Scheduler::run");
+  build_graph();
+
+  jobs::Counter counter;
+  for (uint32_t i = 0; i < m_systems.size(); i++) {
+    if (m_systems[i]->enabled && m_systems[i]->dependency_count == 0)
+      launch(i, counter);
+  }
+  m_job_system.wait(counter);
+}
+
+void Scheduler::launch(uint32_t system, jobs::Counter &counter) {
+  m_job_system.run([this, system, &counter]() { execute(system, counter); },
+                   &counter);
+}
+
+void Scheduler::execute(uint32_t index, jobs::Counter &counter) {
+  System &system = *m_systems[index];
+  const uint64_t start = profiler::now_ns();
+  {
+    BS_PROFILE_ZONE(system.name.c_str());
+    system.function(m_ecs, m_job_system);
+  }
+  const uint64_t elapsed = profiler::now_ns() - start;
+
+  SystemStats &stats = system.stats;
+  stats.last_ns = elapsed;
+  stats.max_ns = std::max(stats.max_ns, elapsed);
+  stats.average_ns =
+      stats.runs == 0 ? static_cast<double>(elapsed)
+                      : stats.average_ns +
+                            stats_smoothing * (elapsed - stats.average_ns);
+  stats.runs++;
+
+  // Successors are launched before this job completes, so the counter can't
+  // reach zero while work is still outstanding.
+  for (uint32_t successor : system.successors) {
+    if (m_systems[successor]->remaining_dependencies.fetch_sub(
+            1, std::memory_order_acq_rel) == 1)
+      launch(successor, counter);
+  }
+}
+
+std::vector<SystemStats> Scheduler::stats() const {
+  std::vector<SystemStats> out;
+  out.reserve(m_systems.size());
+  for (const auto &system : m_systems) {
+    out.push_back(system->stats);
+  }
+  return out;
+}
+
+void Scheduler::log_stats(uint32_t count) const {
+  std::vector<SystemStats> sorted = stats();
+  std::sort(sorted.begin(), sorted.end(),
+            [](const SystemStats &a, const SystemStats &b) {
+              return a.average_ns > b.average_ns;
+            });
+  sorted.resize(std::min<size_t>(sorted.size(), count));
+  for (const auto &system : sorted) {
+    spdlog::info("System {0}: avg {1:.3f}ms, last {2:.3f}ms, max {3:.3f}ms",
+                 system.name, system.average_ns / 1e6, system.last_ns / 1e6,
+                 system.max_ns / 1e6);
+  }
+}
+} // namespace bs::engine::ecs
@@ -3,18 +3,64 @@
 #include <engine/engine.hpp>
 #include <memory>
 
+#include <engine/profiler/profiler.hpp>
+
+#include <chrono>
+#include <spdlog/spdlog.h>
+
 namespace bs::engine {
-Engine::Engine()
-    : m_renderer(std::make_unique<renderer::Renderer>()),
-      m_context(m_renderer->context()) {
-  main_loop();
-}
+Engine::Engine(const EngineCreateInfo &create_info)
+    : m_job_system(
+          std::make_unique<jobs::JobSystem>(create_info.worker_threads)),
+      m_ecs(std::make_unique<ecs::ECS>()),
+      m_scheduler(std::make_unique<ecs::Scheduler>(*m_ecs, *m_job_system)),
+      m_renderer(std::make_unique<renderer::Renderer>(
+          *m_job_system, create_info.context, create_info.renderer)),
+      m_context(m_renderer->context()), m_max_frames(create_info.max_frames),
+      m_profile_trace_path(create_info.profile_trace_path) {}
 Engine::~Engine() {}
 
-void Engine::main_loop() {
-  while (!m_context->window().shouldClose()) {
-    vkfw::pollEvents();
+bool Engine::should_close() {
+  if (m_max_frames != 0 && m_frame_count >= m_max_frames)
+    return true;
+  return !m_context->headless() && m_context->window().shouldClose();
+}
+
+void Engine::run() {
+  // Headless runs are compared by checksum, which mustn't depend on how far
+  // pipelines got compiling before the first frames.
+  if (m_context->headless())
+    m_renderer->wait_for_pipelines();
+  const auto start = std::chrono::steady_clock::now();
+  while (!should_close()) {
+    BS_PROFILE_FRAME_BEGIN();
+    if (!m_context->headless()) {
+      BS_PROFILE_ZONE("poll_events");
+      const vk::Extent2D extent = m_context->framebuffer_extent();
+      // Nothing is rendered while minimized, so don't spin.
+      if (extent.width == 0 || extent.height == 0) {
+        vkfw::waitEvents();
+      } else {
+        vkfw::pollEvents();
+      }
+      m_renderer->set_input_time(std::chrono::steady_clock::now());
+    }
+    m_scheduler->run();
     m_renderer->render();
+    m_frame_count++;
+    BS_PROFILE_FRAME_END();
   }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  spdlog::info("Rendered {0} frames in {1:.3f}s ({2:.1f} fps)", m_frame_count,
+               elapsed.count(),
+               elapsed.count() > 0.0 ? m_frame_count / elapsed.count() : 0.0);
+  m_scheduler->log_stats();
+  m_renderer->log_draw_stats();
+  m_renderer->log_latency_stats();
+#ifdef BS_ENGINE_PROFILING
+  if (!m_profile_trace_path.empty())
+    profiler::Profiler::get().export_chrome_trace(m_profile_trace_path);
+#endif
 }
 } // namespace bs::engine
@@ -0,0 +1,134 @@
+#include <engine/io/mapped_file.hpp>
+
+#include <fmt/format.h>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bs::engine::io {
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string &path) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw std::runtime_error(fmt::format("Failed to open file: {0}", path));
+  m_file = file;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    close();
+    throw std::runtime_error(fmt::format("Failed to stat file: {0}", path));
+  }
+  m_size = static_cast<size_t>(size.QuadPart);
+  if (m_size == 0)
+    return;
+
+  m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping != nullptr)
+    m_data = static_cast<const uint8_t *>(
+        MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (m_data == nullptr) {
+    close();
+    throw std::runtime_error(fmt::format("Failed to map file: {0}", path));
+  }
+}
+
+void MappedFile::close() {
+  if (m_data != nullptr)
+    UnmapViewOfFile(m_data);
+  if (m_mapping != nullptr)
+    CloseHandle(m_mapping);
+  if (m_file != nullptr)
+    CloseHandle(m_file);
+  m_data = nullptr;
+  m_mapping = nullptr;
+  m_file = nullptr;
+  m_size = 0;
+}
+
+void MappedFile::will_need() const {
+  if (m_data == nullptr)
+    return;
+  WIN32_MEMORY_RANGE_ENTRY range{
+      .VirtualAddress = const_cast<uint8_t *>(m_data),
+      .NumberOfBytes = m_size,
+  };
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+#else
+MappedFile::MappedFile(const std::string &path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error(fmt::format("Failed to open file: {0}", path));
+
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0) {
+    ::close(fd);
+    throw std::runtime_error(fmt::format("Failed to stat file: {0}", path));
+  }
+  m_size = static_cast<size_t>(file_stat.st_size);
+  if (m_size == 0) {
+    ::close(fd);
+    return;
+  }
+
+  void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    m_size = 0;
+    throw std::runtime_error(fmt::format("Failed to map file: {0}", path));
+  }
+  m_data = static_cast<const uint8_t *>(data);
+}
+
+void MappedFile::close() {
+  if (m_data != nullptr)
+    ::munmap(const_cast<uint8_t *>(m_data), m_size);
+  m_data = nullptr;
+  m_size = 0;
+}
+
+void MappedFile::will_need() const {
+  if (m_data != nullptr)
+    ::madvise(const_cast<uint8_t *>(m_data), m_size, MADV_WILLNEED);
+}
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0))
+#ifdef _WIN32
+      ,
+      m_file(std::exchange(other.m_file, nullptr)),
+      m_mapping(std::exchange(other.m_mapping, nullptr))
+#endif
+{
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+    m_file = std::exchange(other.m_file, nullptr);
+    m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+  }
+  return *this;
+}
+} // namespace bs::engine::io
@@ -0,0 +1,177 @@
+#include <engine/jobs/job_system.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace bs::engine::jobs {
+namespace {
+constexpr size_t deque_capacity = 4096;
+constexpr uint32_t spins_before_sleep = 64;
+
+thread_local const JobSystem *tls_job_system = nullptr;
+thread_local uint32_t tls_thread_index = 0;
+} // namespace
+
+JobSystem::ThreadState::ThreadState()
+    : deque(deque_capacity), jobs(std::make_unique<Job[]>(jobs_per_thread)) {}
+
+JobSystem::JobSystem(uint32_t worker_count) {
+  if (worker_count == 0) {
+    worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  }
+  m_threads.reserve(worker_count + 1);
+  for (uint32_t i = 0; i < worker_count + 1; i++) {
+    m_threads.push_back(std::make_unique<ThreadState>());
+  }
+
+  tls_job_system = this;
+  tls_thread_index = 0;
+  m_workers.reserve(worker_count);
+  for (uint32_t i = 1; i <= worker_count; i++) {
+    m_workers.emplace_back([this, i]() { worker_main(i); });
+  }
+  spdlog::info("Job system started with {0} worker threads", worker_count);
+}
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard lock(m_sleep_mutex);
+    m_stop.store(true);
+  }
+  m_wake.notify_all();
+  for (auto &worker : m_workers) {
+    worker.join();
+  }
+  if (tls_job_system == this)
+    tls_job_system = nullptr;
+}
+
+uint32_t JobSystem::thread_index() const {
+  return tls_job_system == this ? tls_thread_index : thread_count();
+}
+
+void JobSystem::wait(Counter &counter) {
+  const uint32_t index = thread_index();
+  while (counter.value() != 0) {
+    if (Job *job = find_job(index)) {
+      execute(job);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  // finish() may still be inside the counter's lock after the value it
+  // published hit zero; don't let the caller destroy the counter under it.
+  std::lock_guard lock(counter.m_mutex);
+}
+
+Job *JobSystem::allocate_job() {
+  const uint32_t index = thread_index();
+  if (index < thread_count()) {
+    ThreadState &thread = *m_threads[index];
+    Job &job = thread.jobs[thread.next_job];
+    if (!job.in_use.load(std::memory_order_acquire)) {
+      thread.next_job = (thread.next_job + 1) % jobs_per_thread;
+      job.in_use.store(true, std::memory_order_relaxed);
+      job.heap_allocated = false;
+      return &job;
+    }
+  }
+  // Foreign thread, or the ring wrapped onto a job that is still queued.
+  Job *job = new Job;
+  job->heap_allocated = true;
+  return job;
+}
+
+void JobSystem::submit(Job *job) {
+  const uint32_t index = thread_index();
+  m_pending.fetch_add(1, std::memory_order_seq_cst);
+  if (index >= thread_count() || !m_threads[index]->deque.push(job)) {
+    std::lock_guard lock(m_injection_mutex);
+    m_injection_queue.push_back(job);
+    m_injection_size.fetch_add(1, std::memory_order_release);
+  }
+  if (m_sleeping.load(std::memory_order_seq_cst) > 0) {
+    std::lock_guard lock(m_sleep_mutex);
+    m_wake.notify_one();
+  }
+}
+
+Job *JobSystem::find_job(uint32_t thread_index) {
+  Job *job = nullptr;
+  if (thread_index < thread_count() &&
+      m_threads[thread_index]->deque.pop(job)) {
+    m_pending.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+  }
+
+  if (m_injection_size.load(std::memory_order_acquire) > 0) {
+    std::lock_guard lock(m_injection_mutex);
+    if (!m_injection_queue.empty()) {
+      job = m_injection_queue.back();
+      m_injection_queue.pop_back();
+      m_injection_size.fetch_sub(1, std::memory_order_relaxed);
+      m_pending.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+
+  const uint32_t count = thread_count();
+  for (uint32_t i = 1; i <= count; i++) {
+    const uint32_t victim = (thread_index + i) % count;
+    if (victim != thread_index && m_threads[victim]->deque.steal(job)) {
+      m_pending.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+void JobSystem::execute(Job *job) {
+  job->invoke(job->storage);
+  job->destroy(job->storage);
+  Counter *counter = job->counter;
+  if (job->heap_allocated) {
+    delete job;
+  } else {
+    job->in_use.store(false, std::memory_order_release);
+  }
+  if (counter != nullptr)
+    finish(*counter);
+}
+
+void JobSystem::finish(Counter &counter) {
+  std::vector<Job *> continuations;
+  {
+    std::lock_guard lock(counter.m_mutex);
+    if (counter.m_value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      continuations.swap(counter.m_continuations);
+  }
+  for (Job *job : continuations) {
+    submit(job);
+  }
+}
+
+void JobSystem::worker_main(uint32_t thread_index) {
+  tls_job_system = this;
+  tls_thread_index = thread_index;
+  uint32_t idle_spins = 0;
+  while (!m_stop.load(std::memory_order_relaxed)) {
+    if (Job *job = find_job(thread_index)) {
+      execute(job);
+      idle_spins = 0;
+      continue;
+    }
+    if (++idle_spins < spins_before_sleep) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock lock(m_sleep_mutex);
+    m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+    m_wake.wait(lock, [this]() {
+      return m_pending.load(std::memory_order_seq_cst) > 0 ||
+             m_stop.load(std::memory_order_relaxed);
+    });
+    m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+    idle_spins = 0;
+  }
+}
+} // namespace bs::engine::jobs
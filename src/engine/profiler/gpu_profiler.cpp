@@ -0,0 +1,116 @@
+#include <engine/profiler/gpu_profiler.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace bs::engine::profiler {
+GpuProfiler::GpuProfiler(context::Context &context, uint32_t frames_in_flight)
+    : m_context(context) {
+  m_timestamp_period =
+      m_context.physical_device().getProperties().limits.timestampPeriod;
+  // Zones are recorded on the graphics queue, whichever family it is.
+  const uint32_t queue_family = m_context.graphics_queue_family();
+  m_timestamp_valid_bits =
+      m_context.physical_device().getQueueFamilyProperties()[queue_family]
+          .timestampValidBits;
+  if (!enabled()) {
+    spdlog::warn("Queue family {0} has no timestamp support, GPU zones are "
+                 "disabled",
+                 queue_family);
+    return;
+  }
+
+  m_slots.resize(frames_in_flight);
+  for (auto &slot : m_slots) {
+    slot.query_pool =
+        m_context.device().createQueryPool(vk::QueryPoolCreateInfo{
+            .queryType = vk::QueryType::eTimestamp,
+            .queryCount = max_gpu_zones_per_frame * 2,
+        });
+  }
+}
+GpuProfiler::~GpuProfiler() {
+  for (auto &slot : m_slots) {
+    m_context.device().destroyQueryPool(slot.query_pool);
+  }
+}
+
+void GpuProfiler::begin_frame(vk::CommandBuffer command_buffer,
+                              uint32_t frame_slot, uint64_t frame_index) {
+  if (!enabled())
+    return;
+  m_current = &m_slots[frame_slot];
+  if (m_current->pending)
+    collect(*m_current);
+
+  m_current->frame_index = frame_index;
+  m_current->zone_count = 0;
+  m_current->pending = false;
+  command_buffer.resetQueryPool(m_current->query_pool, 0,
+                                max_gpu_zones_per_frame * 2);
+  begin_zone(command_buffer, "gpu_frame");
+}
+
+void GpuProfiler::end_frame(vk::CommandBuffer command_buffer) {
+  if (!enabled())
+    return;
+  end_zone(command_buffer, 0);
+  m_current->submit_ns = now_ns();
+  m_current->pending = true;
+}
+
+uint32_t GpuProfiler::begin_zone(vk::CommandBuffer command_buffer,
+                                 const char *name) {
+  if (!enabled() || m_current->zone_count >= max_gpu_zones_per_frame)
+    return max_gpu_zones_per_frame;
+  const uint32_t zone = m_current->zone_count++;
+  m_current->names[zone] = name;
+  command_buffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe,
+                                 m_current->query_pool, zone * 2);
+  return zone;
+}
+
+void GpuProfiler::end_zone(vk::CommandBuffer command_buffer, uint32_t zone) {
+  if (!enabled() || zone >= max_gpu_zones_per_frame)
+    return;
+  command_buffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe,
+                                 m_current->query_pool, zone * 2 + 1);
+}
+
+void GpuProfiler::collect(SlotData &slot) {
+  std::array<uint64_t, max_gpu_zones_per_frame * 2> timestamps;
+  auto result = m_context.device().getQueryPoolResults(
+      slot.query_pool, 0, slot.zone_count * 2,
+      slot.zone_count * 2 * sizeof(uint64_t), timestamps.data(),
+      sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+  if (result != vk::Result::eSuccess)
+    return;
+
+  const uint64_t mask = m_timestamp_valid_bits >= 64
+                            ? ~0ull
+                            : (1ull << m_timestamp_valid_bits) - 1;
+  // GPU ticks are anchored at the CPU submit time of the frame; only the
+  // offsets between zones come from the device clock.
+  const uint64_t origin = timestamps[0] & mask;
+  auto to_ns = [&](uint64_t timestamp) {
+    const uint64_t ticks = ((timestamp & mask) - origin) & mask;
+    return slot.submit_ns +
+           static_cast<uint64_t>(static_cast<double>(ticks) *
+                                 m_timestamp_period);
+  };
+
+  FrameRecord record{
+      .frame_index = slot.frame_index,
+      .start_ns = to_ns(timestamps[0]),
+      .end_ns = to_ns(timestamps[1]),
+      .zone_count = slot.zone_count,
+  };
+  for (uint32_t i = 0; i < slot.zone_count; i++) {
+    record.zones[i] = Zone{
+        .name = slot.names[i],
+        .start_ns = to_ns(timestamps[i * 2]),
+        .end_ns = to_ns(timestamps[i * 2 + 1]),
+    };
+  }
+  Profiler::get().publish_gpu_frame(record);
+}
+} // namespace bs::engine::profiler
@@ -0,0 +1,160 @@
+#include <engine/profiler/profiler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+namespace bs::engine::profiler {
+namespace {
+// Trace viewers need a stable thread id for the GPU track.
+constexpr uint32_t gpu_track_id = 1000;
+
+std::string escape_json(const char *text) {
+  std::string out;
+  for (const char *c = text; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\')
+      out.push_back('\\');
+    out.push_back(*c);
+  }
+  return out;
+}
+} // namespace
+
+uint64_t now_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+uint32_t current_thread_id() {
+  static std::atomic<uint32_t> next_thread_id{0};
+  thread_local uint32_t thread_id = next_thread_id.fetch_add(1);
+  return thread_id;
+}
+
+void FrameRing::push(const FrameRecord &record) {
+  const uint64_t write_index = m_write_index.load(std::memory_order_relaxed);
+  Slot &slot = m_slots[write_index % frame_history];
+  const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  // Odd sequence numbers mark a slot that is being written.
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.record = record;
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+  m_write_index.store(write_index + 1, std::memory_order_release);
+}
+
+std::vector<FrameRecord> FrameRing::snapshot() const {
+  const uint64_t end = m_write_index.load(std::memory_order_acquire);
+  const uint64_t begin = end > frame_history ? end - frame_history : 0;
+  std::vector<FrameRecord> out;
+  out.reserve(end - begin);
+  for (uint64_t i = begin; i < end; i++) {
+    const Slot &slot = m_slots[i % frame_history];
+    FrameRecord record;
+    uint64_t before;
+    uint64_t after;
+    do {
+      before = slot.sequence.load(std::memory_order_acquire);
+      record = slot.record;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = slot.sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    // Slot sequences advance by two per push, so this identifies the push.
+    if (after / 2 - 1 != i / frame_history)
+      continue;
+    out.push_back(record);
+  }
+  return out;
+}
+
+Profiler &Profiler::get() {
+  static Profiler profiler;
+  return profiler;
+}
+
+void Profiler::begin_frame() {
+  m_current.frame_index = m_next_frame_index++;
+  m_current.start_ns = now_ns();
+  m_current.thread_id = current_thread_id();
+  m_zone_count.store(0, std::memory_order_relaxed);
+}
+
+void Profiler::end_frame() {
+  m_current.end_ns = now_ns();
+  m_current.zone_count =
+      std::min(m_zone_count.load(std::memory_order_acquire),
+               max_zones_per_frame);
+  m_cpu_frames.push(m_current);
+}
+
+uint32_t Profiler::begin_zone(const char *name) {
+  const uint32_t zone = m_zone_count.fetch_add(1, std::memory_order_relaxed);
+  if (zone >= max_zones_per_frame)
+    return zone;
+  m_current.zones[zone] = Zone{
+      .name = name,
+      .start_ns = now_ns(),
+      .end_ns = 0,
+      .thread_id = current_thread_id(),
+  };
+  return zone;
+}
+
+void Profiler::end_zone(uint32_t zone) {
+  if (zone >= max_zones_per_frame)
+    return;
+  m_current.zones[zone].end_ns = now_ns();
+}
+
+bool Profiler::export_chrome_trace(const std::string &path) const {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file.is_open()) {
+    spdlog::error("Failed to open trace file: {0}", path);
+    return false;
+  }
+
+  const auto cpu_frames = m_cpu_frames.snapshot();
+  const auto gpu_frames = m_gpu_frames.snapshot();
+  const uint64_t origin_ns =
+      cpu_frames.empty() ? 0 : cpu_frames.front().start_ns;
+  auto to_us = [origin_ns](uint64_t ns) {
+    return ns >= origin_ns ? (ns - origin_ns) / 1000.0 : 0.0;
+  };
+
+  file << "{\"traceEvents\":[\n";
+  file << fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                      "\"tid\":{0},\"args\":{{\"name\":\"GPU\"}}}}",
+                      gpu_track_id);
+  auto write_event = [&](const char *name, uint64_t start_ns, uint64_t end_ns,
+                         uint32_t thread_id, uint64_t frame_index) {
+    file << fmt::format(",\n{{\"name\":\"{0}\",\"ph\":\"X\",\"pid\":0,"
+                        "\"tid\":{1},\"ts\":{2:.3f},\"dur\":{3:.3f},"
+                        "\"args\":{{\"frame\":{4}}}}}",
+                        escape_json(name), thread_id, to_us(start_ns),
+                        end_ns > start_ns ? (end_ns - start_ns) / 1000.0 : 0.0,
+                        frame_index);
+  };
+  for (const auto &frame : cpu_frames) {
+    write_event("frame", frame.start_ns, frame.end_ns, frame.thread_id,
+                frame.frame_index);
+    for (uint32_t i = 0; i < frame.zone_count; i++) {
+      const Zone &zone = frame.zones[i];
+      write_event(zone.name, zone.start_ns, zone.end_ns, zone.thread_id,
+                  frame.frame_index);
+    }
+  }
+  for (const auto &frame : gpu_frames) {
+    for (uint32_t i = 0; i < frame.zone_count; i++) {
+      const Zone &zone = frame.zones[i];
+      write_event(zone.name, zone.start_ns, zone.end_ns, gpu_track_id,
+                  frame.frame_index);
+    }
+  }
+  file << "\n]}\n";
+  return file.good();
+}
+} // namespace bs::engine::profiler
@@ -0,0 +1,214 @@
+#include <engine/renderer/bindless_heap.hpp>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace bs::engine::renderer {
+uint32_t IndexAllocator::allocate() {
+  if (!m_free.empty()) {
+    const uint32_t index = m_free.back();
+    m_free.pop_back();
+    return index;
+  }
+  if (m_next == m_capacity)
+    throw std::runtime_error(
+        fmt::format("All {0} bindless descriptors are in use", m_capacity));
+  return m_next++;
+}
+
+BindlessHeap::BindlessHeap(context::Context &context,
+                           const BindlessHeapCreateInfo &create_info)
+    : m_context(context) {
+  const auto properties =
+      m_context.physical_device()
+          .getProperties2<vk::PhysicalDeviceProperties2,
+                          vk::PhysicalDeviceVulkan12Properties>();
+  const vk::PhysicalDeviceVulkan12Properties &limits =
+      properties.get<vk::PhysicalDeviceVulkan12Properties>();
+  // Every binding also counts against the per-stage limit.
+  const uint32_t per_stage =
+      limits.maxPerStageDescriptorUpdateAfterBindResources;
+  std::array<uint32_t, 3> counts{
+      std::min({create_info.storage_buffers,
+                limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers}),
+      std::min({create_info.sampled_images,
+                limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                limits.maxPerStageDescriptorUpdateAfterBindSampledImages}),
+      std::min({create_info.samplers,
+                limits.maxDescriptorSetUpdateAfterBindSamplers,
+                limits.maxPerStageDescriptorUpdateAfterBindSamplers}),
+  };
+  // Each binding is visible to every stage, so together they must fit the
+  // per-stage limit; shrink them in proportion when they don't.
+  const uint64_t total = uint64_t{counts[0]} + counts[1] + counts[2];
+  if (total > per_stage) {
+    for (uint32_t &count : counts) {
+      count = static_cast<uint32_t>(count * uint64_t{per_stage} / total);
+    }
+    spdlog::warn("Bindless heap shrunk to {0} storage buffers, {1} sampled "
+                 "images and {2} samplers to fit the {3} descriptors a stage "
+                 "may access",
+                 counts[0], counts[1], counts[2], per_stage);
+  }
+  const std::array<vk::DescriptorType, 3> types{
+      vk::DescriptorType::eStorageBuffer,
+      vk::DescriptorType::eSampledImage,
+      vk::DescriptorType::eSampler,
+  };
+
+  std::array<vk::DescriptorSetLayoutBinding, 3> bindings;
+  std::array<vk::DescriptorBindingFlags, 3> binding_flags;
+  std::array<vk::DescriptorPoolSize, 3> pool_sizes;
+  for (uint32_t binding = 0; binding < bindings.size(); binding++) {
+    bindings[binding] = vk::DescriptorSetLayoutBinding{
+        .binding = binding,
+        .descriptorType = types[binding],
+        .descriptorCount = counts[binding],
+        .stageFlags = vk::ShaderStageFlagBits::eAll,
+    };
+    binding_flags[binding] =
+        vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+        vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending |
+        vk::DescriptorBindingFlagBits::ePartiallyBound;
+    pool_sizes[binding] = vk::DescriptorPoolSize{
+        .type = types[binding],
+        .descriptorCount = counts[binding],
+    };
+    m_allocators.emplace_back(counts[binding]);
+  }
+  m_layout = m_context.device().createDescriptorSetLayout(
+      vk::StructureChain<vk::DescriptorSetLayoutCreateInfo,
+                         vk::DescriptorSetLayoutBindingFlagsCreateInfo>(
+          vk::DescriptorSetLayoutCreateInfo{
+              .flags = vk::DescriptorSetLayoutCreateFlagBits::
+                  eUpdateAfterBindPool,
+              .bindingCount = bindings.size(),
+              .pBindings = bindings.data(),
+          },
+          vk::DescriptorSetLayoutBindingFlagsCreateInfo{
+              .bindingCount = binding_flags.size(),
+              .pBindingFlags = binding_flags.data(),
+          })
+          .get());
+  m_pool =
+      m_context.device().createDescriptorPool(vk::DescriptorPoolCreateInfo{
+          .flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+          .maxSets = 1,
+          .poolSizeCount = pool_sizes.size(),
+          .pPoolSizes = pool_sizes.data(),
+      });
+  m_set = m_context.device()
+              .allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+                  .descriptorPool = m_pool,
+                  .descriptorSetCount = 1,
+                  .pSetLayouts = &m_layout,
+              })
+              .front();
+  spdlog::info("Bindless heap: {0} storage buffers, {1} sampled images, {2} "
+               "samplers",
+               counts[0], counts[1], counts[2]);
+}
+BindlessHeap::~BindlessHeap() {
+  m_context.device().destroyDescriptorPool(m_pool);
+  m_context.device().destroyDescriptorSetLayout(m_layout);
+}
+
+IndexAllocator &BindlessHeap::allocator(uint32_t binding) {
+  return m_allocators[binding];
+}
+
+uint32_t BindlessHeap::add_storage_buffer(vk::Buffer buffer,
+                                          vk::DeviceSize offset,
+                                          vk::DeviceSize range) {
+  const uint32_t index = allocator(storage_buffer_binding).allocate();
+  const vk::DescriptorBufferInfo buffer_info{
+      .buffer = buffer,
+      .offset = offset,
+      .range = range,
+  };
+  m_context.device().updateDescriptorSets(
+      vk::WriteDescriptorSet{
+          .dstSet = m_set,
+          .dstBinding = storage_buffer_binding,
+          .dstArrayElement = index,
+          .descriptorCount = 1,
+          .descriptorType = vk::DescriptorType::eStorageBuffer,
+          .pBufferInfo = &buffer_info,
+      },
+      {});
+  return index;
+}
+
+uint32_t BindlessHeap::add_sampled_image(vk::ImageView image_view,
+                                         vk::ImageLayout layout) {
+  const uint32_t index = allocator(sampled_image_binding).allocate();
+  const vk::DescriptorImageInfo image_info{
+      .imageView = image_view,
+      .imageLayout = layout,
+  };
+  m_context.device().updateDescriptorSets(
+      vk::WriteDescriptorSet{
+          .dstSet = m_set,
+          .dstBinding = sampled_image_binding,
+          .dstArrayElement = index,
+          .descriptorCount = 1,
+          .descriptorType = vk::DescriptorType::eSampledImage,
+          .pImageInfo = &image_info,
+      },
+      {});
+  return index;
+}
+
+uint32_t BindlessHeap::add_sampler(vk::Sampler sampler) {
+  const uint32_t index = allocator(sampler_binding).allocate();
+  const vk::DescriptorImageInfo image_info{
+      .sampler = sampler,
+  };
+  m_context.device().updateDescriptorSets(
+      vk::WriteDescriptorSet{
+          .dstSet = m_set,
+          .dstBinding = sampler_binding,
+          .dstArrayElement = index,
+          .descriptorCount = 1,
+          .descriptorType = vk::DescriptorType::eSampler,
+          .pImageInfo = &image_info,
+      },
+      {});
+  return index;
+}
+
+void BindlessHeap::retire(uint32_t binding, uint32_t index) {
+  m_retired.push_back(RetiredIndex{
+      .binding = binding,
+      .index = index,
+      .frame = m_frame,
+  });
+}
+
+void BindlessHeap::remove_storage_buffer(uint32_t index) {
+  retire(storage_buffer_binding, index);
+}
+
+void BindlessHeap::remove_sampled_image(uint32_t index) {
+  retire(sampled_image_binding, index);
+}
+
+void BindlessHeap::remove_sampler(uint32_t index) {
+  retire(sampler_binding, index);
+}
+
+void BindlessHeap::begin_frame(uint64_t frame, uint64_t completed_frame) {
+  m_frame = frame;
+  std::erase_if(m_retired, [&](const RetiredIndex &retired) {
+    if (retired.frame > completed_frame)
+      return false;
+    allocator(retired.binding).free(retired.index);
+    return true;
+  });
+}
+} // namespace bs::engine::renderer
@@ -0,0 +1,48 @@
+#include <engine/renderer/draw_list.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <utility>
+
+namespace bs::engine::renderer {
+uint32_t draw_key::quantize_depth(float depth) {
+  // Also maps NaN to 0.
+  if (!(depth > 0.f))
+    return 0;
+  return std::bit_cast<uint32_t>(depth) >> (32 - depth_bits);
+}
+
+void sort_draws(std::vector<SortedDraw> &draws,
+                std::vector<SortedDraw> &scratch) {
+  if (draws.size() < 2)
+    return;
+  constexpr uint32_t digit_bits = 8;
+  constexpr uint32_t digit_count = 64 / digit_bits;
+
+  // One histogram per digit, all filled in a single pass.
+  std::array<std::array<uint32_t, 256>, digit_count> histograms{};
+  for (const SortedDraw &draw : draws) {
+    for (uint32_t digit = 0; digit < digit_count; digit++) {
+      histograms[digit][(draw.key >> (digit * digit_bits)) & 0xff]++;
+    }
+  }
+
+  scratch.resize(draws.size());
+  const uint32_t size = static_cast<uint32_t>(draws.size());
+  for (uint32_t digit = 0; digit < digit_count; digit++) {
+    std::array<uint32_t, 256> &histogram = histograms[digit];
+    const uint32_t shift = digit * digit_bits;
+    if (histogram[(draws.front().key >> shift) & 0xff] == size)
+      continue;
+    uint32_t offset = 0;
+    for (uint32_t &count : histogram) {
+      offset += std::exchange(count, offset);
+    }
+    for (const SortedDraw &draw : draws) {
+      scratch[histogram[(draw.key >> shift) & 0xff]++] = draw;
+    }
+    draws.swap(scratch);
+  }
+}
+} // namespace bs::engine::renderer
@@ -0,0 +1,68 @@
+#include <engine/renderer/frame_allocator.hpp>
+
+#include <algorithm>
+
+namespace bs::engine::renderer {
+namespace {
+// Regions start at a multiple of this, so allocations with up to this
+// alignment are aligned within their region too.
+constexpr vk::DeviceSize region_alignment = 256;
+
+vk::DeviceSize align_up(vk::DeviceSize value, vk::DeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+FrameAllocator::FrameAllocator(context::Context &context,
+                               uint32_t frames_in_flight,
+                               vk::DeviceSize frame_size)
+    : m_context(context) {
+  const vk::PhysicalDeviceLimits limits =
+      m_context.physical_device().getProperties().limits;
+  // 16 keeps vec4 members aligned even where the device allows less.
+  m_alignment = std::max({limits.minUniformBufferOffsetAlignment,
+                          limits.minStorageBufferOffsetAlignment,
+                          vk::DeviceSize{16}});
+  m_frame_size =
+      align_up(frame_size, std::max(m_alignment, region_alignment));
+
+  m_buffer = m_context.create_buffer(
+      vk::BufferCreateInfo{
+          .size = m_frame_size * frames_in_flight,
+          .usage = vk::BufferUsageFlagBits::eUniformBuffer |
+                   vk::BufferUsageFlagBits::eStorageBuffer,
+      },
+      vma::AllocationCreateInfo{
+          .flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite |
+                   vma::AllocationCreateFlagBits::eMapped,
+          .usage = vma::MemoryUsage::eAuto,
+          .requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible |
+                           vk::MemoryPropertyFlagBits::eHostCoherent,
+      });
+  m_mapped = static_cast<uint8_t *>(m_context.buffer(m_buffer)->mapped);
+}
+FrameAllocator::~FrameAllocator() { m_context.destroy_buffer(m_buffer); }
+
+void FrameAllocator::begin_frame(uint32_t frame_index) {
+  m_frame_begin = frame_offset(frame_index);
+  m_head = m_frame_begin;
+}
+
+FrameAllocation FrameAllocator::allocate(vk::DeviceSize size) {
+  return allocate(size, m_alignment);
+}
+
+FrameAllocation FrameAllocator::allocate(vk::DeviceSize size,
+                                         vk::DeviceSize alignment) {
+  const vk::DeviceSize offset =
+      align_up(m_head, std::max(alignment, m_alignment));
+  const vk::DeviceSize end = align_up(offset + size, m_alignment);
+  if (end > m_frame_begin + m_frame_size)
+    return FrameAllocation{};
+  m_head = end;
+  return FrameAllocation{
+      .mapped = m_mapped + offset,
+      .offset = static_cast<uint32_t>(offset),
+  };
+}
+} // namespace bs::engine::renderer
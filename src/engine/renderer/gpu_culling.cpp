@@ -0,0 +1,317 @@
+#include <engine/renderer/gpu_culling.hpp>
+
+#include <engine/profiler/profiler.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace bs::engine::renderer {
+namespace {
+constexpr uint32_t workgroup_size = 64;
+// Objects per slot before the first prepare() grows it.
+constexpr uint32_t initial_capacity = 1024;
+} // namespace
+
+GpuCulling::GpuCulling(context::Context &context,
+                       ShaderLibrary &shader_library,
+                       PipelineCache &pipeline_cache,
+                       uint32_t frames_in_flight)
+    : m_context(context) {
+  const Shader &shader = shader_library.load("./shaders/cull.comp.glsl.spv");
+
+  std::vector<vk::DescriptorSetLayoutBinding> bindings;
+  std::vector<vk::DescriptorPoolSize> pool_sizes;
+  for (const DescriptorBinding &binding : shader.reflection.bindings) {
+    if (binding.set != 0)
+      throw std::runtime_error("The cull shader may only use descriptor set 0");
+    bindings.push_back(vk::DescriptorSetLayoutBinding{
+        .binding = binding.binding,
+        .descriptorType = binding.type,
+        .descriptorCount = binding.count,
+        .stageFlags = binding.stages,
+    });
+    pool_sizes.push_back(vk::DescriptorPoolSize{
+        .type = binding.type,
+        .descriptorCount = binding.count * frames_in_flight,
+    });
+  }
+  m_descriptor_set_layout = m_context.device().createDescriptorSetLayout(
+      vk::DescriptorSetLayoutCreateInfo{
+          .bindingCount = static_cast<uint32_t>(bindings.size()),
+          .pBindings = bindings.data(),
+      });
+  m_descriptor_pool =
+      m_context.device().createDescriptorPool(vk::DescriptorPoolCreateInfo{
+          .maxSets = frames_in_flight,
+          .poolSizeCount = static_cast<uint32_t>(pool_sizes.size()),
+          .pPoolSizes = pool_sizes.data(),
+      });
+  m_pipeline_layout =
+      m_context.device().createPipelineLayout(vk::PipelineLayoutCreateInfo{
+          .setLayoutCount = 1,
+          .pSetLayouts = &m_descriptor_set_layout,
+          .pushConstantRangeCount = static_cast<uint32_t>(
+              shader.reflection.push_constant_ranges.size()),
+          .pPushConstantRanges = shader.reflection.push_constant_ranges.data(),
+      });
+  m_pipeline = pipeline_cache.create_compute_pipeline(
+      vk::ComputePipelineCreateInfo{
+          .stage =
+              vk::PipelineShaderStageCreateInfo{
+                  .stage = shader.reflection.stage,
+                  .module = shader.module,
+                  .pName = shader.reflection.entry_point.c_str(),
+              },
+          .layout = m_pipeline_layout,
+      });
+
+  const std::vector<vk::DescriptorSetLayout> set_layouts(
+      frames_in_flight, m_descriptor_set_layout);
+  const std::vector<vk::DescriptorSet> descriptor_sets =
+      m_context.device().allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+          .descriptorPool = m_descriptor_pool,
+          .descriptorSetCount = static_cast<uint32_t>(set_layouts.size()),
+          .pSetLayouts = set_layouts.data(),
+      });
+  m_frames.resize(frames_in_flight);
+  for (uint32_t i = 0; i < frames_in_flight; i++) {
+    m_frames[i].descriptor_set = descriptor_sets[i];
+    m_frames[i].counts = m_context.create_buffer(
+        vk::BufferCreateInfo{
+            .size = sizeof(uint32_t) * 2,
+            .usage = vk::BufferUsageFlagBits::eStorageBuffer |
+                     vk::BufferUsageFlagBits::eIndirectBuffer |
+                     vk::BufferUsageFlagBits::eTransferDst,
+        },
+        vma::AllocationCreateInfo{
+            .flags = vma::AllocationCreateFlagBits::eHostAccessRandom |
+                     vma::AllocationCreateFlagBits::eMapped,
+            .usage = vma::MemoryUsage::eAuto,
+        });
+    allocate(m_frames[i], initial_capacity);
+  }
+}
+GpuCulling::~GpuCulling() {
+  for (auto &frame : m_frames) {
+    m_context.destroy_buffer(frame.objects);
+    m_context.destroy_buffer(frame.commands);
+    m_context.destroy_buffer(frame.counts);
+  }
+  m_context.device().destroyPipeline(m_pipeline);
+  m_context.device().destroyPipelineLayout(m_pipeline_layout);
+  m_context.device().destroyDescriptorPool(m_descriptor_pool);
+  m_context.device().destroyDescriptorSetLayout(m_descriptor_set_layout);
+}
+
+void GpuCulling::allocate(Frame &frame, uint32_t capacity) {
+  if (frame.objects) {
+    m_context.destroy_buffer(frame.objects);
+    m_context.destroy_buffer(frame.commands);
+  }
+  frame.capacity = capacity;
+  // With async compute the cull shader reads the objects on the compute
+  // family and mesh.vert on the graphics family, every frame, so they're
+  // shared rather than transferred back and forth.
+  const std::array<uint32_t, 2> families{m_context.graphics_queue_family(),
+                                         m_context.compute_queue_family()};
+  const bool concurrent = m_context.async_compute();
+  frame.objects = m_context.create_buffer(
+      vk::BufferCreateInfo{
+          .size = sizeof(GpuObject) * capacity,
+          .usage = vk::BufferUsageFlagBits::eStorageBuffer,
+          .sharingMode = concurrent ? vk::SharingMode::eConcurrent
+                                    : vk::SharingMode::eExclusive,
+          .queueFamilyIndexCount = concurrent ? 2u : 0u,
+          .pQueueFamilyIndices = concurrent ? families.data() : nullptr,
+      },
+      vma::AllocationCreateInfo{
+          .flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite |
+                   vma::AllocationCreateFlagBits::eMapped,
+          .usage = vma::MemoryUsage::eAuto,
+      });
+  frame.commands = m_context.create_buffer(
+      vk::BufferCreateInfo{
+          .size = sizeof(vk::DrawIndexedIndirectCommand) * capacity,
+          .usage = vk::BufferUsageFlagBits::eStorageBuffer |
+                   vk::BufferUsageFlagBits::eIndirectBuffer,
+      },
+      vma::AllocationCreateInfo{
+          .usage = vma::MemoryUsage::eAutoPreferDevice,
+      });
+  write_descriptor_set(frame);
+}
+
+void GpuCulling::write_descriptor_set(const Frame &frame) {
+  const std::array<vk::DescriptorBufferInfo, 3> buffer_infos{
+      vk::DescriptorBufferInfo{
+          .buffer = m_context.buffer(frame.objects)->buffer,
+          .offset = 0,
+          .range = VK_WHOLE_SIZE,
+      },
+      vk::DescriptorBufferInfo{
+          .buffer = m_context.buffer(frame.commands)->buffer,
+          .offset = 0,
+          .range = VK_WHOLE_SIZE,
+      },
+      vk::DescriptorBufferInfo{
+          .buffer = m_context.buffer(frame.counts)->buffer,
+          .offset = 0,
+          .range = VK_WHOLE_SIZE,
+      },
+  };
+  std::array<vk::WriteDescriptorSet, 3> writes;
+  for (uint32_t binding = 0; binding < writes.size(); binding++) {
+    writes[binding] = vk::WriteDescriptorSet{
+        .dstSet = frame.descriptor_set,
+        .dstBinding = binding,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eStorageBuffer,
+        .pBufferInfo = &buffer_infos[binding],
+    };
+  }
+  m_context.device().updateDescriptorSets(writes, {});
+}
+
+bool GpuCulling::prepare(uint32_t frame_index,
+                         std::span<const GpuObject> objects,
+                         const std::array<uint32_t, 2> &format_counts) {
+  Frame &frame = m_frames[frame_index];
+  const uint32_t count = static_cast<uint32_t>(objects.size());
+  bool replaced = false;
+  if (count > frame.capacity) {
+    allocate(frame, std::max(count, frame.capacity * 2));
+    replaced = true;
+  }
+  types::Buffer *buffer = m_context.buffer(frame.objects);
+  std::memcpy(buffer->mapped, objects.data(), objects.size_bytes());
+  m_context.allocator().flushAllocation(buffer->allocation, 0,
+                                        objects.size_bytes());
+  frame.object_count = count;
+  frame.format_counts = format_counts;
+  return replaced;
+}
+
+void GpuCulling::record_cull(vk::CommandBuffer command_buffer,
+                             uint32_t frame_index,
+                             const culling::Frustum &frustum) {
+  BS_PROFILE_ZONE("GpuCulling::record_cull");
+  const Frame &frame = m_frames[frame_index];
+  const vk::Buffer counts = m_context.buffer(frame.counts)->buffer;
+  command_buffer.fillBuffer(counts, 0, VK_WHOLE_SIZE, 0);
+  const vk::MemoryBarrier2 clear_barrier{
+      .srcStageMask = vk::PipelineStageFlagBits2::eClear,
+      .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+      .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead |
+                       vk::AccessFlagBits2::eShaderStorageWrite,
+  };
+  command_buffer.pipelineBarrier2(vk::DependencyInfo{
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &clear_barrier,
+  });
+
+  if (frame.object_count > 0) {
+    const GpuCullConstants constants{
+        .planes = frustum.planes,
+        .object_count = frame.object_count,
+        .command_base = {0, frame.format_counts[0]},
+    };
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+    command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+                                      m_pipeline_layout, 0,
+                                      frame.descriptor_set, {});
+    command_buffer.pushConstants(m_pipeline_layout,
+                                 vk::ShaderStageFlagBits::eCompute, 0,
+                                 sizeof(constants), &constants);
+    command_buffer.dispatch(
+        (frame.object_count + workgroup_size - 1) / workgroup_size, 1, 1);
+  }
+}
+
+void GpuCulling::record_release(vk::CommandBuffer command_buffer,
+                                uint32_t frame_index, uint32_t src_family,
+                                uint32_t dst_family) {
+  record_ownership_transfer(command_buffer, frame_index, src_family,
+                            dst_family, true);
+}
+
+void GpuCulling::record_acquire(vk::CommandBuffer command_buffer,
+                                uint32_t frame_index, uint32_t src_family,
+                                uint32_t dst_family) {
+  record_ownership_transfer(command_buffer, frame_index, src_family,
+                            dst_family, false);
+}
+
+void GpuCulling::record_ownership_transfer(vk::CommandBuffer command_buffer,
+                                           uint32_t frame_index,
+                                           uint32_t src_family,
+                                           uint32_t dst_family, bool release) {
+  const Frame &frame = m_frames[frame_index];
+  // Each half only fills in the scope of its own queue.
+  vk::BufferMemoryBarrier2 barrier{
+      .srcQueueFamilyIndex = src_family,
+      .dstQueueFamilyIndex = dst_family,
+      .offset = 0,
+      .size = VK_WHOLE_SIZE,
+  };
+  if (release) {
+    barrier.srcStageMask = vk::PipelineStageFlagBits2::eClear |
+                           vk::PipelineStageFlagBits2::eComputeShader;
+    barrier.srcAccessMask = vk::AccessFlagBits2::eTransferWrite |
+                            vk::AccessFlagBits2::eShaderStorageWrite;
+  } else {
+    barrier.dstStageMask = vk::PipelineStageFlagBits2::eDrawIndirect;
+    barrier.dstAccessMask = vk::AccessFlagBits2::eIndirectCommandRead;
+  }
+  std::array<vk::BufferMemoryBarrier2, 2> barriers{barrier, barrier};
+  barriers[0].buffer = m_context.buffer(frame.commands)->buffer;
+  barriers[1].buffer = m_context.buffer(frame.counts)->buffer;
+  if (!release) {
+    // For visible_count(); nothing writes the counts after the acquire.
+    barriers[1].dstStageMask |= vk::PipelineStageFlagBits2::eHost;
+    barriers[1].dstAccessMask |= vk::AccessFlagBits2::eHostRead;
+  }
+  command_buffer.pipelineBarrier2(vk::DependencyInfo{
+      .bufferMemoryBarrierCount = static_cast<uint32_t>(barriers.size()),
+      .pBufferMemoryBarriers = barriers.data(),
+  });
+}
+
+void GpuCulling::record_draw(vk::CommandBuffer command_buffer,
+                             uint32_t frame_index,
+                             types::VertexFormat format) {
+  const Frame &frame = m_frames[frame_index];
+  const uint32_t index = static_cast<uint32_t>(format);
+  if (frame.format_counts[index] == 0)
+    return;
+  const uint32_t command_base = index == 0 ? 0 : frame.format_counts[0];
+  command_buffer.drawIndexedIndirectCount(
+      m_context.buffer(frame.commands)->buffer,
+      command_base * sizeof(vk::DrawIndexedIndirectCommand),
+      m_context.buffer(frame.counts)->buffer, index * sizeof(uint32_t),
+      frame.format_counts[index], sizeof(vk::DrawIndexedIndirectCommand));
+}
+
+vk::Buffer GpuCulling::object_buffer(uint32_t frame_index) const {
+  return m_context.buffer(m_frames[frame_index].objects)->buffer;
+}
+
+vk::Buffer GpuCulling::draw_command_buffer(uint32_t frame_index) const {
+  return m_context.buffer(m_frames[frame_index].commands)->buffer;
+}
+
+vk::Buffer GpuCulling::draw_count_buffer(uint32_t frame_index) const {
+  return m_context.buffer(m_frames[frame_index].counts)->buffer;
+}
+
+uint32_t GpuCulling::visible_count(uint32_t frame_index) const {
+  const types::Buffer *buffer = m_context.buffer(m_frames[frame_index].counts);
+  m_context.allocator().invalidateAllocation(buffer->allocation, 0,
+                                             VK_WHOLE_SIZE);
+  std::array<uint32_t, 2> counts;
+  std::memcpy(counts.data(), buffer->mapped, sizeof(counts));
+  return counts[0] + counts[1];
+}
+} // namespace bs::engine::renderer
@@ -0,0 +1,230 @@
+#include <engine/renderer/mesh_arena.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace bs::engine::renderer {
+RangeAllocator::RangeAllocator(uint32_t capacity) {
+  if (capacity > 0)
+    m_free.emplace(0, capacity);
+}
+
+std::optional<uint32_t> RangeAllocator::allocate(uint32_t size) {
+  for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+    if (it->second < size)
+      continue;
+    const uint32_t offset = it->first;
+    const uint32_t remaining = it->second - size;
+    m_free.erase(it);
+    if (remaining > 0)
+      m_free.emplace(offset + size, remaining);
+    return offset;
+  }
+  return std::nullopt;
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t size) {
+  if (size == 0)
+    return;
+  auto next = m_free.lower_bound(offset);
+  if (next != m_free.begin()) {
+    auto previous = std::prev(next);
+    if (previous->first + previous->second == offset) {
+      offset = previous->first;
+      size += previous->second;
+      m_free.erase(previous);
+    }
+  }
+  if (next != m_free.end() && offset + size == next->first) {
+    size += next->second;
+    m_free.erase(next);
+  }
+  m_free.emplace(offset, size);
+}
+
+MeshArena::MeshArena(context::Context &context, Uploader &uploader,
+                     const MeshArenaCreateInfo &create_info)
+    : m_context(context), m_uploader(uploader),
+      m_vertex_ranges{RangeAllocator(create_info.vertex_capacity),
+                      RangeAllocator(create_info.vertex_capacity)},
+      m_index_ranges(create_info.index_capacity) {
+  for (types::VertexFormat format :
+       {types::VertexFormat::eFull, types::VertexFormat::eQuantized}) {
+    m_vertex_buffers[static_cast<size_t>(format)] = m_uploader.create_buffer(
+        vk::DeviceSize{create_info.vertex_capacity} *
+            types::vertex_stride(format),
+        vk::BufferUsageFlagBits::eVertexBuffer);
+  }
+  m_index_buffer = m_uploader.create_buffer(
+      vk::DeviceSize{create_info.index_capacity} * sizeof(uint32_t),
+      vk::BufferUsageFlagBits::eIndexBuffer);
+}
+MeshArena::~MeshArena() {
+  for (types::BufferHandle buffer : m_vertex_buffers) {
+    m_context.destroy_buffer(buffer);
+  }
+  m_context.destroy_buffer(m_index_buffer);
+}
+
+vk::Buffer MeshArena::vertex_buffer(types::VertexFormat format) const {
+  return m_context.buffer(m_vertex_buffers[static_cast<size_t>(format)])
+      ->buffer;
+}
+
+vk::Buffer MeshArena::index_buffer() const {
+  return m_context.buffer(m_index_buffer)->buffer;
+}
+
+types::MeshRange MeshArena::allocate(types::VertexFormat format,
+                                     uint32_t vertex_count,
+                                     uint32_t index_count) {
+  RangeAllocator &vertex_ranges = m_vertex_ranges[static_cast<size_t>(format)];
+  const std::optional<uint32_t> first_vertex =
+      vertex_ranges.allocate(vertex_count);
+  if (!first_vertex)
+    throw std::runtime_error(fmt::format(
+        "Mesh arena has no room for {0} more vertices", vertex_count));
+  const std::optional<uint32_t> first_index =
+      m_index_ranges.allocate(index_count);
+  if (!first_index) {
+    vertex_ranges.free(*first_vertex, vertex_count);
+    throw std::runtime_error(fmt::format(
+        "Mesh arena has no room for {0} more indices", index_count));
+  }
+  return types::MeshRange{
+      .first_vertex = *first_vertex,
+      .vertex_count = vertex_count,
+      .first_index = *first_index,
+      .index_count = index_count,
+  };
+}
+
+void MeshArena::upload(types::Mesh &mesh) {
+  const auto &vertices = mesh.vertices();
+  if (vertices.empty())
+    return;
+  // Uploader::upload() copies into the ring right away, so the encoded
+  // vertices only need to live until it returns.
+  std::vector<types::QuantizedVertex> quantized;
+  const void *vertex_data = vertices.data();
+  mesh.set_bounds(types::compute_bounds(vertices));
+  if (mesh.vertex_format() == types::VertexFormat::eQuantized) {
+    quantized = types::quantize_vertices(vertices, mesh.bounds());
+    vertex_data = quantized.data();
+  }
+
+  const auto &indices = mesh.indices();
+  const uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+  const uint32_t index_count =
+      indices.empty() ? vertex_count : static_cast<uint32_t>(indices.size());
+  const types::MeshRange range =
+      allocate(mesh.vertex_format(), vertex_count, index_count);
+  const vk::DeviceSize stride = types::vertex_stride(mesh.vertex_format());
+  m_uploader.upload(vertex_buffer(mesh.vertex_format()),
+                    range.first_vertex * stride, vertex_data,
+                    vertex_count * stride);
+
+  const vk::DeviceSize index_offset =
+      vk::DeviceSize{range.first_index} * sizeof(uint32_t);
+  const vk::DeviceSize index_size =
+      vk::DeviceSize{index_count} * sizeof(uint32_t);
+  uint64_t value;
+  if (indices.empty()) {
+    // Unindexed meshes draw their vertices in order.
+    value = m_uploader.upload(
+        index_buffer(), index_offset, index_size,
+        [](void *destination, vk::DeviceSize offset, vk::DeviceSize size) {
+          uint32_t *out = static_cast<uint32_t *>(destination);
+          std::iota(out, out + size / sizeof(uint32_t),
+                    static_cast<uint32_t>(offset / sizeof(uint32_t)));
+        });
+  } else {
+    value = m_uploader.upload(index_buffer(), index_offset, indices.data(),
+                              index_size);
+  }
+  mesh.set_range(range, value);
+}
+
+void MeshArena::upload(types::Mesh &mesh, const types::MeshAssetView &asset) {
+  if (asset.vertex_count == 0)
+    return;
+  mesh.set_vertex_format(asset.vertex_format);
+  mesh.set_bounds(asset.bounds);
+  mesh.set_lods(
+      std::vector<types::MeshLod>(asset.lods.begin(), asset.lods.end()));
+
+  const uint32_t index_count =
+      asset.index_size == 0 ? asset.vertex_count : asset.index_count;
+  const types::MeshRange range =
+      allocate(asset.vertex_format, asset.vertex_count, index_count);
+  const vk::DeviceSize stride = types::vertex_stride(asset.vertex_format);
+  m_uploader.upload(vertex_buffer(asset.vertex_format),
+                    range.first_vertex * stride, asset.vertices.data(),
+                    asset.vertices.size());
+
+  const vk::DeviceSize index_offset =
+      vk::DeviceSize{range.first_index} * sizeof(uint32_t);
+  const vk::DeviceSize index_size =
+      vk::DeviceSize{index_count} * sizeof(uint32_t);
+  const uint8_t *source = asset.indices.data();
+  const uint32_t source_size = asset.index_size;
+  // Chunk offsets are multiples of 16 bytes, so every chunk starts on a
+  // whole index.
+  const uint64_t value = m_uploader.upload(
+      index_buffer(), index_offset, index_size,
+      [source, source_size](void *destination, vk::DeviceSize offset,
+                            vk::DeviceSize size) {
+        uint32_t *out = static_cast<uint32_t *>(destination);
+        const size_t first = offset / sizeof(uint32_t);
+        const size_t count = size / sizeof(uint32_t);
+        if (source_size == sizeof(uint32_t)) {
+          std::memcpy(out, source + offset, size);
+        } else if (source_size == sizeof(uint16_t)) {
+          for (size_t i = 0; i < count; i++) {
+            uint16_t index;
+            std::memcpy(&index, source + (first + i) * sizeof(uint16_t),
+                        sizeof(index));
+            out[i] = index;
+          }
+        } else {
+          std::iota(out, out + count, static_cast<uint32_t>(first));
+        }
+      });
+  mesh.set_range(range, value);
+}
+
+void MeshArena::free(const types::Mesh &mesh) {
+  if (!mesh.uploaded())
+    return;
+  // A pending upload still writes the range, so it also waits for that.
+  m_retired.push_back(RetiredRange{
+      .format = mesh.vertex_format(),
+      .range = mesh.range(),
+      .frame = m_frame,
+      .upload_value = mesh.upload_value(),
+  });
+}
+
+void MeshArena::release(types::VertexFormat format,
+                        const types::MeshRange &range) {
+  m_vertex_ranges[static_cast<size_t>(format)].free(range.first_vertex,
+                                                    range.vertex_count);
+  m_index_ranges.free(range.first_index, range.index_count);
+}
+
+void MeshArena::begin_frame(uint64_t frame, uint64_t completed_frame,
+                            uint64_t completed_upload_value) {
+  m_frame = frame;
+  std::erase_if(m_retired, [&](const RetiredRange &retired) {
+    if (retired.frame > completed_frame ||
+        retired.upload_value > completed_upload_value)
+      return false;
+    release(retired.format, retired.range);
+    return true;
+  });
+}
+} // namespace bs::engine::renderer
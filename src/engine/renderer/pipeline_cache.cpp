@@ -0,0 +1,206 @@
+#include <engine/renderer/pipeline_cache.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+
+namespace bs::engine::renderer {
+namespace {
+constexpr std::array<char, 4> file_magic{'B', 'S', 'P', 'C'};
+constexpr uint32_t file_version = 1;
+
+uint64_t hash_bytes(const uint8_t *data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+} // namespace
+
+PipelineCache::PipelineCache(context::Context &context, std::string path)
+    : m_context(context), m_path(std::move(path)) {
+  std::vector<uint8_t> initial_data = load();
+  m_stats.loaded_bytes = initial_data.size();
+  m_cache = m_context.device().createPipelineCache(vk::PipelineCacheCreateInfo{
+      .initialDataSize = initial_data.size(),
+      .pInitialData = initial_data.empty() ? nullptr : initial_data.data(),
+  });
+}
+PipelineCache::~PipelineCache() {
+  m_context.device().destroyPipelineCache(m_cache);
+}
+
+PipelineCache::FileHeader PipelineCache::expected_header() const {
+  auto properties = m_context.physical_device()
+                        .getProperties2<vk::PhysicalDeviceProperties2,
+                                        vk::PhysicalDeviceVulkan11Properties>();
+  const auto &device_properties =
+      properties.get<vk::PhysicalDeviceProperties2>().properties;
+  const auto &vulkan_11_properties =
+      properties.get<vk::PhysicalDeviceVulkan11Properties>();
+
+  FileHeader header{
+      .magic = file_magic,
+      .version = file_version,
+      .vendor_id = device_properties.vendorID,
+      .device_id = device_properties.deviceID,
+      .driver_version = device_properties.driverVersion,
+      .reserved = 0,
+      .data_size = 0,
+      .data_hash = 0,
+  };
+  std::copy(device_properties.pipelineCacheUUID.begin(),
+            device_properties.pipelineCacheUUID.end(),
+            header.pipeline_cache_uuid.begin());
+  std::copy(vulkan_11_properties.driverUUID.begin(),
+            vulkan_11_properties.driverUUID.end(),
+            header.driver_uuid.begin());
+  return header;
+}
+
+std::vector<uint8_t> PipelineCache::load() {
+  if (m_path.empty())
+    return {};
+  std::ifstream file(m_path, std::ios::binary);
+  if (!file.is_open()) {
+    spdlog::info("No pipeline cache at {0}, starting empty", m_path);
+    return {};
+  }
+
+  FileHeader header;
+  const FileHeader expected = expected_header();
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      header.magic != expected.magic || header.version != expected.version) {
+    spdlog::warn("Pipeline cache {0} is not a valid cache file, ignoring it",
+                 m_path);
+    return {};
+  }
+  if (header.vendor_id != expected.vendor_id ||
+      header.device_id != expected.device_id ||
+      header.driver_version != expected.driver_version ||
+      header.pipeline_cache_uuid != expected.pipeline_cache_uuid ||
+      header.driver_uuid != expected.driver_uuid) {
+    spdlog::info("Pipeline cache {0} was written by a different device or "
+                 "driver, ignoring it",
+                 m_path);
+    return {};
+  }
+
+  // Checked before allocating, so a corrupt size can't ask for more memory
+  // than the file holds.
+  std::error_code error;
+  const uintmax_t file_size = std::filesystem::file_size(m_path, error);
+  if (error || file_size < sizeof(header) ||
+      header.data_size != file_size - sizeof(header)) {
+    spdlog::warn("Pipeline cache {0} is truncated or corrupt, ignoring it",
+                 m_path);
+    return {};
+  }
+  std::vector<uint8_t> data(header.data_size);
+  if (!file.read(reinterpret_cast<char *>(data.data()), data.size()) ||
+      hash_bytes(data.data(), data.size()) != header.data_hash) {
+    spdlog::warn("Pipeline cache {0} is truncated or corrupt, ignoring it",
+                 m_path);
+    return {};
+  }
+  return data;
+}
+
+bool PipelineCache::save() {
+  if (m_path.empty())
+    return false;
+  std::vector<uint8_t> data = m_context.device().getPipelineCacheData(m_cache);
+
+  FileHeader header = expected_header();
+  header.data_size = data.size();
+  header.data_hash = hash_bytes(data.data(), data.size());
+
+  const std::string temporary_path = m_path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    // Closing flushes, and its failure is what catches a full disk.
+    file.flush();
+    file.close();
+    if (file.fail()) {
+      spdlog::error("Failed to write pipeline cache {0}", temporary_path);
+      std::filesystem::remove(temporary_path);
+      return false;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary_path, m_path, error);
+  if (error) {
+    spdlog::error("Failed to replace pipeline cache {0}: {1}", m_path,
+                  error.message());
+    std::filesystem::remove(temporary_path, error);
+    return false;
+  }
+  spdlog::info("Saved {0} bytes of pipeline cache to {1}", data.size(),
+               m_path);
+  return true;
+}
+
+vk::Pipeline
+PipelineCache::create_graphics_pipeline(vk::GraphicsPipelineCreateInfo info) {
+  vk::PipelineCreationFeedback feedback{};
+  vk::PipelineCreationFeedbackCreateInfo feedback_create_info{
+      .pNext = info.pNext,
+      .pPipelineCreationFeedback = &feedback,
+  };
+  info.pNext = &feedback_create_info;
+
+  vk::Pipeline pipeline;
+  auto result = m_context.device().createGraphicsPipelines(m_cache, 1, &info,
+                                                           nullptr, &pipeline);
+  if (result != vk::Result::eSuccess)
+    throw std::runtime_error("Failed to create graphics pipeline");
+  record(feedback);
+  return pipeline;
+}
+
+vk::Pipeline
+PipelineCache::create_compute_pipeline(vk::ComputePipelineCreateInfo info) {
+  vk::PipelineCreationFeedback feedback{};
+  vk::PipelineCreationFeedbackCreateInfo feedback_create_info{
+      .pNext = info.pNext,
+      .pPipelineCreationFeedback = &feedback,
+  };
+  info.pNext = &feedback_create_info;
+
+  vk::Pipeline pipeline;
+  auto result = m_context.device().createComputePipelines(m_cache, 1, &info,
+                                                          nullptr, &pipeline);
+  if (result != vk::Result::eSuccess)
+    throw std::runtime_error("Failed to create compute pipeline");
+  record(feedback);
+  return pipeline;
+}
+
+void PipelineCache::record(const vk::PipelineCreationFeedback &feedback) {
+  if (!(feedback.flags & vk::PipelineCreationFeedbackFlagBits::eValid))
+    return;
+  std::lock_guard lock(m_stats_mutex);
+  if (feedback.flags &
+      vk::PipelineCreationFeedbackFlagBits::eApplicationPipelineCacheHit) {
+    m_stats.hits++;
+  } else {
+    m_stats.misses++;
+  }
+  m_stats.creation_ns += feedback.duration;
+}
+
+void PipelineCache::log_stats() const {
+  std::lock_guard lock(m_stats_mutex);
+  spdlog::info("Pipeline cache: {0} bytes loaded, {1} hits, {2} misses, "
+               "{3:.3f}ms spent creating pipelines",
+               m_stats.loaded_bytes, m_stats.hits, m_stats.misses,
+               m_stats.creation_ns / 1e6);
+}
+} // namespace bs::engine::renderer
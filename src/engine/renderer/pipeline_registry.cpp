@@ -0,0 +1,275 @@
+#include <engine/renderer/pipeline_registry.hpp>
+#include <engine/types/mesh.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <spdlog/spdlog.h>
+
+namespace bs::engine::renderer {
+namespace {
+// FNV-1a over 64-bit words, like the shader and pipeline cache hashes.
+void combine(uint64_t &hash, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    hash ^= (value >> (i * 8)) & 0xff;
+    hash *= 0x100000001b3ull;
+  }
+}
+} // namespace
+
+size_t GraphicsPipelineStateHash::operator()(
+    const GraphicsPipelineState &state) const {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  // Identical binaries share one Shader, so its content hash identifies it.
+  combine(hash, state.vertex_shader ? state.vertex_shader->hash : 0);
+  combine(hash, state.fragment_shader ? state.fragment_shader->hash : 0);
+  combine(hash, std::hash<vk::PipelineLayout>{}(state.layout));
+  combine(hash, state.specialization_count);
+  for (uint32_t value : state.specialization) {
+    combine(hash, value);
+  }
+  combine(hash, state.vertex_format
+                    ? static_cast<uint64_t>(*state.vertex_format) + 1
+                    : 0);
+  combine(hash, static_cast<VkCullModeFlags>(state.cull_mode));
+  combine(hash, (state.depth_test ? 1 : 0) | (state.depth_write ? 2 : 0));
+  combine(hash, static_cast<uint64_t>(state.color_format));
+  combine(hash, static_cast<uint64_t>(state.depth_format));
+  return static_cast<size_t>(hash);
+}
+
+PipelineRegistry::PipelineRegistry(context::Context &context,
+                                   PipelineCache &pipeline_cache,
+                                   uint32_t thread_count)
+    : m_context(context), m_pipeline_cache(pipeline_cache) {
+  for (uint32_t i = 0; i < std::max(thread_count, 1u); i++) {
+    m_threads.emplace_back([this]() { thread_main(); });
+  }
+}
+PipelineRegistry::~PipelineRegistry() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+  for (const Entry &entry : m_entries) {
+    m_context.device().destroyPipeline(entry.pipeline);
+  }
+}
+
+PipelineId PipelineRegistry::request(const GraphicsPipelineState &state) {
+  std::lock_guard lock(m_mutex);
+  m_stats.requests++;
+  const auto found = m_ids.find(state);
+  if (found != m_ids.end())
+    return PipelineId{found->second};
+
+  const uint32_t index = static_cast<uint32_t>(m_entries.size());
+  m_entries.push_back(Entry{.state = state});
+  m_ids.emplace(state, index);
+  m_stats.unique_states++;
+  m_queue.push_back(index);
+  m_wake.notify_one();
+  return PipelineId{index};
+}
+
+vk::Pipeline PipelineRegistry::get(PipelineId id) const {
+  if (!id)
+    return {};
+  std::lock_guard lock(m_mutex);
+  return m_entries[id.index].pipeline;
+}
+
+void PipelineRegistry::wait_idle() {
+  std::unique_lock lock(m_mutex);
+  m_idle.wait(lock, [this]() { return m_queue.empty() && m_compiling == 0; });
+}
+
+PipelineRegistryStats PipelineRegistry::stats() const {
+  std::lock_guard lock(m_mutex);
+  return m_stats;
+}
+
+void PipelineRegistry::log_stats() const {
+  const PipelineRegistryStats stats = this->stats();
+  spdlog::info("Pipelines: {0} requests, {1} unique states, {2} compiled, "
+               "{3} failed, {4:.3f}ms spent compiling",
+               stats.requests, stats.unique_states, stats.compiled,
+               stats.failed, stats.compile_ns / 1e6);
+}
+
+void PipelineRegistry::thread_main() {
+  std::unique_lock lock(m_mutex);
+  while (true) {
+    m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+    if (m_stop)
+      return;
+    const uint32_t index = m_queue.front();
+    m_queue.pop_front();
+    m_compiling++;
+    // Entries never move, and a state is never written after its request.
+    const GraphicsPipelineState &state = m_entries[index].state;
+    lock.unlock();
+
+    const auto start = std::chrono::steady_clock::now();
+    vk::Pipeline pipeline;
+    try {
+      pipeline = compile(state);
+    } catch (std::exception &err) {
+      spdlog::error("Failed to compile pipeline {0}: {1}", index, err.what());
+    }
+    const std::chrono::duration<uint64_t, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    lock.lock();
+    m_entries[index].pipeline = pipeline;
+    (pipeline ? m_stats.compiled : m_stats.failed)++;
+    m_stats.compile_ns += elapsed.count();
+    if (--m_compiling == 0 && m_queue.empty())
+      m_idle.notify_all();
+  }
+}
+
+vk::Pipeline PipelineRegistry::compile(const GraphicsPipelineState &state) {
+  std::array<vk::SpecializationMapEntry, max_specialization_constants>
+      specialization_entries;
+  for (uint32_t i = 0; i < state.specialization_count; i++) {
+    specialization_entries[i] = vk::SpecializationMapEntry{
+        .constantID = i,
+        .offset = i * static_cast<uint32_t>(sizeof(uint32_t)),
+        .size = sizeof(uint32_t),
+    };
+  }
+  const vk::SpecializationInfo specialization_info{
+      .mapEntryCount = state.specialization_count,
+      .pMapEntries = specialization_entries.data(),
+      .dataSize = state.specialization_count * sizeof(uint32_t),
+      .pData = state.specialization.data(),
+  };
+  const vk::SpecializationInfo *specialization =
+      state.specialization_count > 0 ? &specialization_info : nullptr;
+  const std::array<vk::PipelineShaderStageCreateInfo, 2> stages{
+      vk::PipelineShaderStageCreateInfo{
+          .stage = state.vertex_shader->reflection.stage,
+          .module = state.vertex_shader->module,
+          .pName = state.vertex_shader->reflection.entry_point.c_str(),
+          .pSpecializationInfo = specialization,
+      },
+      vk::PipelineShaderStageCreateInfo{
+          .stage = state.fragment_shader->reflection.stage,
+          .module = state.fragment_shader->module,
+          .pName = state.fragment_shader->reflection.entry_point.c_str(),
+          .pSpecializationInfo = specialization,
+      },
+  };
+
+  vk::VertexInputBindingDescription binding;
+  std::vector<vk::VertexInputAttributeDescription> attributes;
+  vk::PipelineVertexInputStateCreateInfo vertex_input_state{};
+  if (state.vertex_format) {
+    binding = types::vertex_binding(*state.vertex_format);
+    attributes = types::vertex_attributes(*state.vertex_format);
+    vertex_input_state = vk::PipelineVertexInputStateCreateInfo{
+        .vertexBindingDescriptionCount = 1,
+        .pVertexBindingDescriptions = &binding,
+        .vertexAttributeDescriptionCount =
+            static_cast<uint32_t>(attributes.size()),
+        .pVertexAttributeDescriptions = attributes.data(),
+    };
+  }
+
+  const vk::PipelineInputAssemblyStateCreateInfo input_assembly_state{
+      .topology = vk::PrimitiveTopology::eTriangleList,
+  };
+  const vk::PipelineViewportStateCreateInfo viewport_state{
+      .viewportCount = 1,
+      .pViewports = nullptr,
+      .scissorCount = 1,
+      .pScissors = nullptr,
+  };
+  const vk::PipelineRasterizationStateCreateInfo rasterization_state{
+      .depthClampEnable = false,
+      .rasterizerDiscardEnable = false,
+      .polygonMode = vk::PolygonMode::eFill,
+      .cullMode = state.cull_mode,
+      .frontFace = vk::FrontFace::eClockwise,
+      .depthBiasEnable = false,
+      .depthBiasConstantFactor = 0.f,
+      .depthBiasClamp = 0.f,
+      .depthBiasSlopeFactor = 0.f,
+      .lineWidth = 1.f,
+  };
+  const vk::PipelineMultisampleStateCreateInfo multisample_state{
+      .rasterizationSamples = vk::SampleCountFlagBits::e1,
+  };
+  const vk::StencilOpState stencil_op_state{
+      vk::StencilOp::eKeep,
+      vk::StencilOp::eKeep,
+      vk::StencilOp::eKeep,
+      vk::CompareOp::eAlways,
+  };
+  const vk::PipelineDepthStencilStateCreateInfo depth_stencil_state{
+      .depthTestEnable = state.depth_test,
+      .depthWriteEnable = state.depth_write,
+      .depthCompareOp = vk::CompareOp::eLessOrEqual,
+      .depthBoundsTestEnable = false,
+      .stencilTestEnable = false,
+      .front = stencil_op_state,
+      .back = stencil_op_state,
+  };
+  const vk::PipelineColorBlendAttachmentState color_blend_attachment_state{
+      .blendEnable = false,
+      .srcColorBlendFactor = vk::BlendFactor::eZero,
+      .dstColorBlendFactor = vk::BlendFactor::eZero,
+      .colorBlendOp = vk::BlendOp::eAdd,
+      .srcAlphaBlendFactor = vk::BlendFactor::eZero,
+      .dstAlphaBlendFactor = vk::BlendFactor::eZero,
+      .alphaBlendOp = vk::BlendOp::eAdd,
+      .colorWriteMask =
+          vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+          vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
+  };
+  const vk::PipelineColorBlendStateCreateInfo color_blend_state{
+      .logicOpEnable = false,
+      .logicOp = vk::LogicOp::eNoOp,
+      .attachmentCount = 1,
+      .pAttachments = &color_blend_attachment_state,
+      .blendConstants =
+          {
+              {1.f, 1.f, 1.f, 1.f},
+          },
+  };
+  const std::array<vk::DynamicState, 2> dynamic_states{
+      vk::DynamicState::eViewport,
+      vk::DynamicState::eScissor,
+  };
+  const vk::PipelineDynamicStateCreateInfo dynamic_state{
+      .dynamicStateCount = dynamic_states.size(),
+      .pDynamicStates = dynamic_states.data(),
+  };
+  const vk::PipelineRenderingCreateInfo rendering_info{
+      .colorAttachmentCount = 1,
+      .pColorAttachmentFormats = &state.color_format,
+      .depthAttachmentFormat = state.depth_format,
+      .stencilAttachmentFormat = vk::Format::eUndefined,
+  };
+  return m_pipeline_cache.create_graphics_pipeline(
+      vk::GraphicsPipelineCreateInfo{
+          .pNext = &rendering_info,
+          .stageCount = static_cast<uint32_t>(stages.size()),
+          .pStages = stages.data(),
+          .pVertexInputState = &vertex_input_state,
+          .pInputAssemblyState = &input_assembly_state,
+          .pTessellationState = nullptr,
+          .pViewportState = &viewport_state,
+          .pRasterizationState = &rasterization_state,
+          .pMultisampleState = &multisample_state,
+          .pDepthStencilState = &depth_stencil_state,
+          .pColorBlendState = &color_blend_state,
+          .pDynamicState = &dynamic_state,
+          .layout = state.layout,
+      });
+}
+} // namespace bs::engine::renderer
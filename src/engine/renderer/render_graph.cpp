@@ -0,0 +1,678 @@
+#include <engine/renderer/render_graph.hpp>
+
+#include <engine/profiler/profiler.hpp>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace bs::engine::renderer {
+namespace {
+constexpr vk::AccessFlags2 write_access_flags =
+    vk::AccessFlagBits2::eShaderWrite |
+    vk::AccessFlagBits2::eShaderStorageWrite |
+    vk::AccessFlagBits2::eColorAttachmentWrite |
+    vk::AccessFlagBits2::eDepthStencilAttachmentWrite |
+    vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eHostWrite |
+    vk::AccessFlagBits2::eMemoryWrite;
+
+constexpr vk::PipelineStageFlags2 shader_stages =
+    vk::PipelineStageFlagBits2::eVertexShader |
+    vk::PipelineStageFlagBits2::eFragmentShader |
+    vk::PipelineStageFlagBits2::eComputeShader;
+
+// Where and how a usage touches a resource.
+struct UsageScope {
+  vk::PipelineStageFlags2 stages;
+  vk::AccessFlags2 read_access;
+  // Empty if the usage is read only.
+  vk::AccessFlags2 write_access;
+  vk::ImageLayout read_layout = vk::ImageLayout::eUndefined;
+  vk::ImageLayout write_layout = vk::ImageLayout::eUndefined;
+  bool images = true;
+  bool buffers = true;
+};
+
+UsageScope usage_scope(ResourceUsage usage) {
+  switch (usage) {
+  case ResourceUsage::eColorAttachment:
+    return UsageScope{
+        .stages = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+        .read_access = vk::AccessFlagBits2::eColorAttachmentRead,
+        .write_access = vk::AccessFlagBits2::eColorAttachmentWrite,
+        .read_layout = vk::ImageLayout::eAttachmentOptimal,
+        .write_layout = vk::ImageLayout::eAttachmentOptimal,
+        .buffers = false,
+    };
+  case ResourceUsage::eDepthAttachment:
+    return UsageScope{
+        .stages = vk::PipelineStageFlagBits2::eEarlyFragmentTests |
+                  vk::PipelineStageFlagBits2::eLateFragmentTests,
+        .read_access = vk::AccessFlagBits2::eDepthStencilAttachmentRead,
+        // Depth testing reads what it writes.
+        .write_access = vk::AccessFlagBits2::eDepthStencilAttachmentRead |
+                        vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+        .read_layout = vk::ImageLayout::eReadOnlyOptimal,
+        .write_layout = vk::ImageLayout::eAttachmentOptimal,
+        .buffers = false,
+    };
+  case ResourceUsage::eSampled:
+    return UsageScope{
+        .stages = shader_stages,
+        .read_access = vk::AccessFlagBits2::eShaderSampledRead,
+        .read_layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        .buffers = false,
+    };
+  case ResourceUsage::eStorage:
+    return UsageScope{
+        .stages = shader_stages,
+        .read_access = vk::AccessFlagBits2::eShaderStorageRead,
+        .write_access = vk::AccessFlagBits2::eShaderStorageWrite,
+        .read_layout = vk::ImageLayout::eGeneral,
+        .write_layout = vk::ImageLayout::eGeneral,
+    };
+  case ResourceUsage::eIndirect:
+    return UsageScope{
+        .stages = vk::PipelineStageFlagBits2::eDrawIndirect,
+        .read_access = vk::AccessFlagBits2::eIndirectCommandRead,
+        .images = false,
+    };
+  case ResourceUsage::eTransfer:
+    return UsageScope{
+        .stages = vk::PipelineStageFlagBits2::eTransfer,
+        .read_access = vk::AccessFlagBits2::eTransferRead,
+        .write_access = vk::AccessFlagBits2::eTransferWrite,
+        .read_layout = vk::ImageLayout::eTransferSrcOptimal,
+        .write_layout = vk::ImageLayout::eTransferDstOptimal,
+    };
+  }
+  return UsageScope{};
+}
+
+const char *usage_name(ResourceUsage usage) {
+  switch (usage) {
+  case ResourceUsage::eColorAttachment:
+    return "color attachment";
+  case ResourceUsage::eDepthAttachment:
+    return "depth attachment";
+  case ResourceUsage::eSampled:
+    return "sampled";
+  case ResourceUsage::eStorage:
+    return "storage";
+  case ResourceUsage::eIndirect:
+    return "indirect";
+  case ResourceUsage::eTransfer:
+    return "transfer";
+  }
+  return "unknown";
+}
+
+bool is_attachment_layout(vk::ImageLayout layout) {
+  return layout == vk::ImageLayout::eAttachmentOptimal ||
+         layout == vk::ImageLayout::eReadOnlyOptimal;
+}
+} // namespace
+
+PassBuilder &PassBuilder::read(GraphImage image, ResourceUsage usage) {
+  m_graph.use(m_pass, image.index, usage, false);
+  return *this;
+}
+
+PassBuilder &PassBuilder::write(GraphImage image, ResourceUsage usage) {
+  m_graph.use(m_pass, image.index, usage, true);
+  return *this;
+}
+
+PassBuilder &PassBuilder::read(GraphBuffer buffer, ResourceUsage usage) {
+  m_graph.use(m_pass, buffer.index, usage, false);
+  return *this;
+}
+
+PassBuilder &PassBuilder::write(GraphBuffer buffer, ResourceUsage usage) {
+  m_graph.use(m_pass, buffer.index, usage, true);
+  return *this;
+}
+
+PassBuilder &PassBuilder::side_effects() {
+  m_graph.m_passes[m_pass].side_effects = true;
+  return *this;
+}
+
+RenderGraph::RenderGraph(context::Context &context) : m_context(context) {}
+
+RenderGraph::~RenderGraph() {
+  // The owner has waited for the device to go idle.
+  destroy(m_transients, m_blocks);
+  for (auto &retired : m_retired) {
+    destroy(retired.transients, retired.blocks);
+  }
+}
+
+void RenderGraph::begin_frame(uint64_t frame, uint64_t completed_frame) {
+  m_frame = frame;
+  std::erase_if(m_retired, [&](Retired &retired) {
+    if (retired.frame > completed_frame)
+      return false;
+    destroy(retired.transients, retired.blocks);
+    return true;
+  });
+  m_passes.clear();
+  m_resources.clear();
+}
+
+GraphImage RenderGraph::import_image(const char *name, vk::Image image,
+                                     vk::ImageView image_view,
+                                     vk::ImageAspectFlags aspect,
+                                     const ResourceState &initial,
+                                     const ResourceState &final) {
+  m_resources.push_back(Resource{
+      .name = name,
+      .is_image = true,
+      .imported = true,
+      .image = image,
+      .image_view = image_view,
+      .aspect = aspect,
+      .initial = initial,
+      .final = final,
+  });
+  return GraphImage{static_cast<uint32_t>(m_resources.size() - 1)};
+}
+
+GraphBuffer RenderGraph::import_buffer(const char *name, vk::Buffer buffer,
+                                       const ResourceState &initial,
+                                       const ResourceState &final) {
+  m_resources.push_back(Resource{
+      .name = name,
+      .is_image = false,
+      .imported = true,
+      .buffer = buffer,
+      .initial = initial,
+      .final = final,
+  });
+  return GraphBuffer{static_cast<uint32_t>(m_resources.size() - 1)};
+}
+
+GraphImage RenderGraph::create_image(const char *name,
+                                     const TransientImageInfo &info) {
+  m_resources.push_back(Resource{
+      .name = name,
+      .is_image = true,
+      .imported = false,
+      .aspect = info.aspect,
+      .info = info,
+  });
+  return GraphImage{static_cast<uint32_t>(m_resources.size() - 1)};
+}
+
+PassBuilder RenderGraph::add_pass(const char *name, PassFunction record) {
+  m_passes.push_back(Pass{
+      .name = name,
+      .record = std::move(record),
+  });
+  return PassBuilder(*this, static_cast<uint32_t>(m_passes.size() - 1));
+}
+
+void RenderGraph::use(uint32_t pass_index, uint32_t resource,
+                      ResourceUsage usage, bool write) {
+  Pass &pass = m_passes[pass_index];
+  const Resource &r = m_resources[resource];
+  const UsageScope scope = usage_scope(usage);
+  if ((r.is_image ? !scope.images : !scope.buffers) ||
+      (write && !scope.write_access))
+    throw std::runtime_error(fmt::format(
+        "Pass '{0}' can't {1} {2} '{3}' as {4}", pass.name,
+        write ? "write" : "read", r.is_image ? "image" : "buffer", r.name,
+        usage_name(usage)));
+
+  const vk::ImageLayout layout = !r.is_image ? vk::ImageLayout::eUndefined
+                                 : write     ? scope.write_layout
+                                             : scope.read_layout;
+  const vk::AccessFlags2 access =
+      write ? scope.write_access : scope.read_access;
+  for (Use &existing : pass.uses) {
+    if (existing.resource != resource)
+      continue;
+    if (existing.layout != layout) {
+      // Reading an attachment the pass also writes needs no layout of its
+      // own.
+      if (!is_attachment_layout(existing.layout) ||
+          !is_attachment_layout(layout))
+        throw std::runtime_error(
+            fmt::format("Pass '{0}' uses image '{1}' in two layouts",
+                        pass.name, r.name));
+      existing.layout = vk::ImageLayout::eAttachmentOptimal;
+    }
+    existing.stages |= scope.stages;
+    existing.access |= access;
+    existing.read = existing.read || !write;
+    existing.write = existing.write || write;
+    return;
+  }
+  pass.uses.push_back(Use{
+      .resource = resource,
+      .stages = scope.stages,
+      .access = access,
+      .layout = layout,
+      .read = !write,
+      .write = write,
+  });
+}
+
+void RenderGraph::cull_passes() {
+  // Walking backwards, a pass is live if a live pass after it, or the
+  // world outside the graph, reads something it writes.
+  std::vector<bool> needed(m_resources.size());
+  for (uint32_t i = 0; i < m_resources.size(); i++) {
+    needed[i] = m_resources[i].imported;
+  }
+  for (auto pass = m_passes.rbegin(); pass != m_passes.rend(); pass++) {
+    pass->live = pass->side_effects ||
+                 std::any_of(pass->uses.begin(), pass->uses.end(),
+                             [&](const Use &use) {
+                               return use.write && needed[use.resource];
+                             });
+    if (!pass->live)
+      continue;
+    for (const Use &use : pass->uses) {
+      if (use.read)
+        needed[use.resource] = true;
+    }
+  }
+
+  uint32_t order = 0;
+  for (const Pass &pass : m_passes) {
+    if (!pass.live)
+      continue;
+    for (const Use &use : pass.uses) {
+      Resource &resource = m_resources[use.resource];
+      resource.first_use = std::min(resource.first_use, order);
+      resource.last_use = std::max(resource.last_use, order);
+    }
+    order++;
+  }
+  m_stats.passes = order;
+  m_stats.culled_passes = static_cast<uint32_t>(m_passes.size()) - order;
+}
+
+void RenderGraph::place_transients() {
+  std::vector<uint32_t> transients;
+  for (uint32_t i = 0; i < m_resources.size(); i++) {
+    const Resource &resource = m_resources[i];
+    if (!resource.imported && resource.first_use != UINT32_MAX)
+      transients.push_back(i);
+  }
+  const auto unchanged = [&] {
+    if (transients.size() != m_transients.size())
+      return false;
+    for (uint32_t i = 0; i < transients.size(); i++) {
+      const Resource &resource = m_resources[transients[i]];
+      const Transient &transient = m_transients[i];
+      if (!(resource.info == transient.info) ||
+          resource.first_use != transient.first_use ||
+          resource.last_use != transient.last_use)
+        return false;
+    }
+    return true;
+  };
+
+  const bool replaced = !unchanged();
+  if (replaced) {
+    retire_transients();
+    vk::Device device = m_context.device();
+    std::vector<vk::MemoryRequirements> requirements;
+    for (uint32_t resource_index : transients) {
+      const Resource &resource = m_resources[resource_index];
+      const vk::Image image = device.createImage(vk::ImageCreateInfo{
+          .imageType = vk::ImageType::e2D,
+          .format = resource.info.format,
+          .extent = vk::Extent3D{resource.info.extent.width,
+                                 resource.info.extent.height, 1},
+          .mipLevels = 1,
+          .arrayLayers = 1,
+          .samples = vk::SampleCountFlagBits::e1,
+          .tiling = vk::ImageTiling::eOptimal,
+          .usage = resource.info.usage,
+      });
+      requirements.push_back(device.getImageMemoryRequirements(image));
+      m_transients.push_back(Transient{
+          .info = resource.info,
+          .first_use = resource.first_use,
+          .last_use = resource.last_use,
+          .image = image,
+          .size = requirements.back().size,
+      });
+    }
+
+    // Largest first, each into the first block of compatible memory that
+    // no image with an overlapping lifetime is in. Every image of a block
+    // starts at its beginning.
+    std::vector<uint32_t> order(m_transients.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      return requirements[a].size > requirements[b].size;
+    });
+    std::vector<vk::MemoryRequirements> block_requirements;
+    std::vector<std::vector<uint32_t>> block_transients;
+    for (uint32_t i : order) {
+      Transient &transient = m_transients[i];
+      const vk::MemoryRequirements &required = requirements[i];
+      uint32_t block = 0;
+      for (; block < block_transients.size(); block++) {
+        if (!(block_requirements[block].memoryTypeBits &
+              required.memoryTypeBits))
+          continue;
+        const bool overlaps = std::any_of(
+            block_transients[block].begin(), block_transients[block].end(),
+            [&](uint32_t other) {
+              return m_transients[other].first_use <= transient.last_use &&
+                     transient.first_use <= m_transients[other].last_use;
+            });
+        if (!overlaps)
+          break;
+      }
+      if (block == block_transients.size()) {
+        block_requirements.push_back(required);
+        block_transients.emplace_back();
+      } else {
+        vk::MemoryRequirements &merged = block_requirements[block];
+        merged.size = std::max(merged.size, required.size);
+        merged.alignment = std::max(merged.alignment, required.alignment);
+        merged.memoryTypeBits &= required.memoryTypeBits;
+      }
+      block_transients[block].push_back(i);
+      transient.block = block;
+    }
+
+    for (uint32_t block = 0; block < block_requirements.size(); block++) {
+      // allocateMemory() knows nothing of the images, so it can't pick the
+      // memory type from usage.
+      m_blocks.push_back(Block{
+          .allocation = m_context.allocator().allocateMemory(
+              block_requirements[block],
+              vma::AllocationCreateInfo{
+                  .preferredFlags = vk::MemoryPropertyFlagBits::eDeviceLocal,
+              }),
+          .size = block_requirements[block].size,
+      });
+      for (uint32_t i : block_transients[block]) {
+        m_context.allocator().bindImageMemory(m_blocks.back().allocation,
+                                              m_transients[i].image);
+      }
+    }
+    for (Transient &transient : m_transients) {
+      transient.image_view = device.createImageView(vk::ImageViewCreateInfo{
+          .image = transient.image,
+          .viewType = vk::ImageViewType::e2D,
+          .format = transient.info.format,
+          .subresourceRange =
+              {
+                  .aspectMask = transient.info.aspect,
+                  .baseMipLevel = 0,
+                  .levelCount = 1,
+                  .baseArrayLayer = 0,
+                  .layerCount = 1,
+              },
+      });
+    }
+  }
+
+  for (uint32_t i = 0; i < transients.size(); i++) {
+    m_resources[transients[i]].transient = i;
+  }
+  m_stats.transient_images = static_cast<uint32_t>(m_transients.size());
+  for (const Transient &transient : m_transients) {
+    m_stats.unaliased_bytes += transient.size;
+  }
+  for (const Block &block : m_blocks) {
+    m_stats.transient_bytes += block.size;
+  }
+  if (replaced && !m_transients.empty())
+    spdlog::info("Render graph: {0} transient images in {1} blocks, {2} KiB "
+                 "({3} KiB without aliasing)",
+                 m_transients.size(), m_blocks.size(),
+                 m_stats.transient_bytes / 1024,
+                 m_stats.unaliased_bytes / 1024);
+}
+
+void RenderGraph::retire_transients() {
+  if (m_transients.empty() && m_blocks.empty())
+    return;
+  // Frames still in flight may be using them.
+  m_retired.push_back(Retired{
+      .transients = std::move(m_transients),
+      .blocks = std::move(m_blocks),
+      .frame = m_frame,
+  });
+  m_transients.clear();
+  m_blocks.clear();
+}
+
+void RenderGraph::destroy(std::vector<Transient> &transients,
+                          std::vector<Block> &blocks) {
+  for (Transient &transient : transients) {
+    m_context.device().destroyImageView(transient.image_view);
+    m_context.device().destroyImage(transient.image);
+  }
+  for (Block &block : blocks) {
+    m_context.allocator().freeMemory(block.allocation);
+  }
+  transients.clear();
+  blocks.clear();
+}
+
+void RenderGraph::sync(const Resource &resource, const Use &use,
+                       SyncState &state, vk::MemoryBarrier2 &memory_barrier) {
+  const vk::AccessFlags2 write_access = use.access & write_access_flags;
+  if (resource.is_image && use.layout != state.layout) {
+    // Layout transitions are writes, so they wait for every earlier access.
+    m_image_barriers.push_back(vk::ImageMemoryBarrier2{
+        .srcStageMask = state.write_stages | state.read_stages,
+        .srcAccessMask = state.write_access,
+        .dstStageMask = use.stages,
+        .dstAccessMask = use.access,
+        .oldLayout = state.layout,
+        .newLayout = use.layout,
+        .image = resource.transient == UINT32_MAX
+                     ? resource.image
+                     : m_transients[resource.transient].image,
+        .subresourceRange =
+            {
+                .aspectMask = resource.aspect,
+                .baseMipLevel = 0,
+                .levelCount = VK_REMAINING_MIP_LEVELS,
+                .baseArrayLayer = 0,
+                .layerCount = VK_REMAINING_ARRAY_LAYERS,
+            },
+    });
+    // Later accesses only need to wait for the transition's stages; its
+    // writes are already visible to this use.
+    state.write_stages = use.stages;
+    state.write_access = write_access;
+    state.read_stages = {};
+    state.visible_stages = write_access ? vk::PipelineStageFlags2{}
+                                        : use.stages;
+    state.visible_access = write_access ? vk::AccessFlags2{} : use.access;
+    state.layout = use.layout;
+    return;
+  }
+
+  // Everything else is a global memory barrier: buffers have no layouts,
+  // and an image keeping its layout needs nothing a memory barrier lacks.
+  if (use.write) {
+    // Write after write or read; the earlier reads only need to finish.
+    if (state.write_stages || state.read_stages) {
+      memory_barrier.srcStageMask |= state.write_stages | state.read_stages;
+      memory_barrier.srcAccessMask |= state.write_access;
+      memory_barrier.dstStageMask |= use.stages;
+      memory_barrier.dstAccessMask |= use.access;
+    }
+    state.write_stages = use.stages;
+    state.write_access = write_access;
+    state.read_stages = {};
+    state.visible_stages = {};
+    state.visible_access = {};
+    return;
+  }
+
+  // Read after write, unless an earlier barrier already made the write
+  // visible here.
+  if (state.write_stages &&
+      ((use.stages & ~state.visible_stages) ||
+       (use.access & ~state.visible_access))) {
+    // Widened to everything visible so far, which keeps what's visible a
+    // plain product of stages and accesses.
+    const vk::PipelineStageFlags2 stages = state.visible_stages | use.stages;
+    const vk::AccessFlags2 access = state.visible_access | use.access;
+    memory_barrier.srcStageMask |= state.write_stages;
+    memory_barrier.srcAccessMask |= state.write_access;
+    memory_barrier.dstStageMask |= stages;
+    memory_barrier.dstAccessMask |= access;
+    state.visible_stages = stages;
+    state.visible_access = access;
+  }
+  state.read_stages |= use.stages;
+}
+
+void RenderGraph::compile() {
+  BS_PROFILE_ZONE("RenderGraph::compile");
+  m_stats = {};
+  m_image_barriers.clear();
+  m_memory_barriers.clear();
+  cull_passes();
+  place_transients();
+
+  // Imported resources start from the state they were handed in with.
+  // Transient images share their block's, carried over from the previous
+  // frame, so the first image to use a block waits for the last one to use
+  // it; none of them has a layout yet.
+  std::vector<SyncState> states(m_resources.size());
+  for (uint32_t i = 0; i < m_resources.size(); i++) {
+    const ResourceState &initial = m_resources[i].initial;
+    states[i] = SyncState{
+        .write_stages = initial.stages,
+        .write_access = initial.access & write_access_flags,
+        .layout = initial.layout,
+    };
+  }
+  for (Block &block : m_blocks) {
+    block.state.owner = UINT32_MAX;
+  }
+
+  // Adds the batch accumulated since `image_barrier_begin`, returning the
+  // index of its memory barrier.
+  const auto end_batch = [&](uint32_t image_barrier_begin,
+                             const vk::MemoryBarrier2 &memory_barrier) {
+    uint32_t index = UINT32_MAX;
+    if (memory_barrier.srcStageMask || memory_barrier.dstStageMask) {
+      index = static_cast<uint32_t>(m_memory_barriers.size());
+      m_memory_barriers.push_back(memory_barrier);
+      m_stats.memory_barriers++;
+    }
+    if (index != UINT32_MAX || m_image_barriers.size() > image_barrier_begin)
+      m_stats.barrier_batches++;
+    return index;
+  };
+
+  for (Pass &pass : m_passes) {
+    if (!pass.live)
+      continue;
+    pass.image_barrier_begin = static_cast<uint32_t>(m_image_barriers.size());
+    vk::MemoryBarrier2 memory_barrier{};
+    for (const Use &use : pass.uses) {
+      const Resource &resource = m_resources[use.resource];
+      SyncState *state = &states[use.resource];
+      if (resource.transient != UINT32_MAX) {
+        state = &m_blocks[m_transients[resource.transient].block].state;
+        if (state->owner != use.resource) {
+          state->owner = use.resource;
+          state->layout = vk::ImageLayout::eUndefined;
+        }
+      }
+      sync(resource, use, *state, memory_barrier);
+    }
+    pass.memory_barrier = end_batch(pass.image_barrier_begin, memory_barrier);
+    pass.image_barrier_count = static_cast<uint32_t>(m_image_barriers.size()) -
+                               pass.image_barrier_begin;
+  }
+
+  m_final_image_barrier_begin = static_cast<uint32_t>(m_image_barriers.size());
+  vk::MemoryBarrier2 memory_barrier{};
+  for (uint32_t i = 0; i < m_resources.size(); i++) {
+    const Resource &resource = m_resources[i];
+    if (!resource.imported)
+      continue;
+    const ResourceState &final = resource.final;
+    const Use use{
+        .resource = i,
+        .stages = final.stages,
+        .access = final.access,
+        .layout = final.layout == vk::ImageLayout::eUndefined
+                      ? states[i].layout
+                      : final.layout,
+        .read = true,
+        .write = false,
+    };
+    if (!use.stages && (!resource.is_image || use.layout == states[i].layout))
+      continue;
+    sync(resource, use, states[i], memory_barrier);
+  }
+  m_final_memory_barrier =
+      end_batch(m_final_image_barrier_begin, memory_barrier);
+  m_final_image_barrier_count =
+      static_cast<uint32_t>(m_image_barriers.size()) -
+      m_final_image_barrier_begin;
+  m_stats.image_barriers = static_cast<uint32_t>(m_image_barriers.size());
+}
+
+void RenderGraph::record_barriers(vk::CommandBuffer command_buffer,
+                                  uint32_t image_barrier_begin,
+                                  uint32_t image_barrier_count,
+                                  uint32_t memory_barrier) {
+  if (image_barrier_count == 0 && memory_barrier == UINT32_MAX)
+    return;
+  command_buffer.pipelineBarrier2(vk::DependencyInfo{
+      .memoryBarrierCount = memory_barrier == UINT32_MAX ? 0u : 1u,
+      .pMemoryBarriers = memory_barrier == UINT32_MAX
+                             ? nullptr
+                             : &m_memory_barriers[memory_barrier],
+      .imageMemoryBarrierCount = image_barrier_count,
+      .pImageMemoryBarriers = m_image_barriers.data() + image_barrier_begin,
+  });
+}
+
+void RenderGraph::execute(vk::CommandBuffer command_buffer,
+                          [[maybe_unused]] profiler::GpuProfiler *profiler) {
+  BS_PROFILE_ZONE("RenderGraph::execute");
+  for (const Pass &pass : m_passes) {
+    if (!pass.live)
+      continue;
+    record_barriers(command_buffer, pass.image_barrier_begin,
+                    pass.image_barrier_count, pass.memory_barrier);
+    BS_PROFILE_GPU_ZONE(profiler, command_buffer, pass.name);
+    pass.record(command_buffer);
+  }
+  record_barriers(command_buffer, m_final_image_barrier_begin,
+                  m_final_image_barrier_count, m_final_memory_barrier);
+}
+
+vk::Image RenderGraph::image(GraphImage image) const {
+  const Resource &resource = m_resources[image.index];
+  if (resource.imported)
+    return resource.image;
+  return resource.transient == UINT32_MAX
+             ? vk::Image{}
+             : m_transients[resource.transient].image;
+}
+
+vk::ImageView RenderGraph::image_view(GraphImage image) const {
+  const Resource &resource = m_resources[image.index];
+  if (resource.imported)
+    return resource.image_view;
+  return resource.transient == UINT32_MAX
+             ? vk::ImageView{}
+             : m_transients[resource.transient].image_view;
+}
+} // namespace bs::engine::renderer
@@ -1,6 +1,13 @@
 #include <engine/renderer/renderer.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fmt/format.h>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
+#include <tuple>
 
 #include "vulkan/vulkan.hpp"
 #include "vulkan/vulkan_core.h"
@@ -9,167 +16,140 @@
 #include "vulkan/vulkan_structs.hpp"
 
 namespace bs::engine::renderer {
-Renderer::Renderer()
-    : m_context(std::make_unique<context::Context>()),
-      m_camera(std::make_unique<camera::Camera>()) {
+namespace {
+context::ContextCreateInfo
+with_offscreen_images(context::ContextCreateInfo context_create_info,
+                      uint32_t frames_in_flight) {
+  // Each in-flight frame renders into its own offscreen image.
+  context_create_info.offscreen_image_count = std::max(
+      context_create_info.offscreen_image_count, frames_in_flight);
+  return context_create_info;
+}
+
+// Optimal tiling D16 depth attachments are required of every device.
+constexpr vk::Format depth_format = vk::Format::eD16Unorm;
+
+// mesh.vert.glsl reads the camera as the first three matrices of the
+// frame's region.
+static_assert(sizeof(types::CameraUBO) == 3 * sizeof(glm::mat4));
+
+// The descriptor type of each of BindlessHeap's bindings.
+vk::DescriptorType bindless_type(uint32_t binding) {
+  switch (binding) {
+  case BindlessHeap::storage_buffer_binding:
+    return vk::DescriptorType::eStorageBuffer;
+  case BindlessHeap::sampled_image_binding:
+    return vk::DescriptorType::eSampledImage;
+  case BindlessHeap::sampler_binding:
+    return vk::DescriptorType::eSampler;
+  default:
+    throw std::runtime_error(
+        fmt::format("Mesh shaders use binding {0}, which the bindless heap "
+                    "doesn't have",
+                    binding));
+  }
+}
+} // namespace
+
+Renderer::Renderer(jobs::JobSystem &job_system,
+                   const context::ContextCreateInfo &context_create_info,
+                   const RendererCreateInfo &create_info)
+    : m_job_system(job_system),
+      m_context(std::make_unique<context::Context>(with_offscreen_images(
+          context_create_info, std::max(create_info.frames_in_flight, 1u)))),
+      m_camera(std::make_unique<camera::Camera>()),
+      m_parallel_recording_threshold(create_info.parallel_recording_threshold),
+      m_draws_per_recording_job(
+          std::max(create_info.draws_per_recording_job, 1u)) {
   try {
-    m_command_pool =
-        m_context->device().createCommandPool(vk::CommandPoolCreateInfo{
-            .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-            .queueFamilyIndex = 0,
-        });
-    m_command_buffer =
-        m_context->device()
-            .allocateCommandBuffers(vk::CommandBufferAllocateInfo{
-                .commandPool = m_command_pool,
-                .level = vk::CommandBufferLevel::ePrimary,
-                .commandBufferCount = 1,
-            })
-            .front();
-    auto [m_camera_ubo, m_camera_ubo_allocation] =
-        m_context->allocator().createBuffer(
-            vk::BufferCreateInfo{
-                .size = sizeof(m_camera->camera_data()),
-                .usage = vk::BufferUsageFlagBits::eUniformBuffer,
-            },
-            vma::AllocationCreateInfo{});
+    create_frames(std::max(create_info.frames_in_flight, 1u));
+#ifdef BS_ENGINE_PROFILING
+    m_gpu_profiler = std::make_unique<profiler::GpuProfiler>(
+        *m_context, frames_in_flight());
+#endif
 
-    m_pipeline_layouts.push_back(m_context->device().createPipelineLayout(
-        vk::PipelineLayoutCreateInfo{}));
-    m_pipelines.reserve(1);
-    m_shader_modules.push_back(
-        m_context->load_shader("./shaders/triangle.vert.spv"));
-    m_shader_modules.push_back(
-        m_context->load_shader("./shaders/triangle.frag.spv"));
-    std::array<vk::PipelineShaderStageCreateInfo, 2>
-        pipeline_shader_stage_create_infos{
-            vk::PipelineShaderStageCreateInfo{
-                .stage = vk::ShaderStageFlagBits::eVertex,
-                .module = m_shader_modules[0],
-                .pName = "main"},
-            vk::PipelineShaderStageCreateInfo{
-                .stage = vk::ShaderStageFlagBits::eFragment,
-                .module = m_shader_modules[1],
-                .pName = "main"},
-        };
-    vk::PipelineVertexInputStateCreateInfo
-        pipeline_vertex_input_state_create_info{};
-    vk::PipelineInputAssemblyStateCreateInfo
-        pipeline_input_assembly_state_create_info{
-            .topology = vk::PrimitiveTopology::eTriangleList,
-        };
-    vk::PipelineViewportStateCreateInfo pipeline_viewport_state_create_info{
-        .viewportCount = 1,
-        .pViewports = nullptr,
-        .scissorCount = 1,
-        .pScissors = nullptr,
-    };
-    vk::PipelineRasterizationStateCreateInfo
-        pipeline_rasterization_state_create_info{
-            .depthClampEnable = false,
-            .rasterizerDiscardEnable = false,
-            .polygonMode = vk::PolygonMode::eFill,
-            .cullMode = vk::CullModeFlagBits::eBack,
-            .frontFace = vk::FrontFace::eClockwise,
-            .depthBiasEnable = false,
-            .depthBiasConstantFactor = 0.f,
-            .depthBiasClamp = 0.f,
-            .depthBiasSlopeFactor = 0.f,
-            .lineWidth = 1.f,
-        };
-    vk::PipelineMultisampleStateCreateInfo
-        pipeline_multisample_state_create_info{
-            .rasterizationSamples = vk::SampleCountFlagBits::e1,
-        };
-    vk::StencilOpState stencil_op_state{
-        vk::StencilOp::eKeep,
-        vk::StencilOp::eKeep,
-        vk::StencilOp::eKeep,
-        vk::CompareOp::eAlways,
-    };
-    vk::PipelineDepthStencilStateCreateInfo
-        pipeline_depth_stencil_state_create_info{
-            .depthTestEnable = true,
-            .depthWriteEnable = true,
-            .depthCompareOp = vk::CompareOp::eLessOrEqual,
-            .depthBoundsTestEnable = false,
-            .stencilTestEnable = false,
-            .front = stencil_op_state,
-            .back = stencil_op_state,
-        };
-    vk::ColorComponentFlags color_component_flags{
-        vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
-        vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA};
-    vk::PipelineColorBlendAttachmentState pipeline_color_blend_attachment_state{
-        .blendEnable = false,
-        .srcColorBlendFactor = vk::BlendFactor::eZero,
-        .dstColorBlendFactor = vk::BlendFactor::eZero,
-        .colorBlendOp = vk::BlendOp::eAdd,
-        .srcAlphaBlendFactor = vk::BlendFactor::eZero,
-        .dstAlphaBlendFactor = vk::BlendFactor::eZero,
-        .alphaBlendOp = vk::BlendOp::eAdd,
-        .colorWriteMask = color_component_flags,
-    };
-    vk::PipelineColorBlendStateCreateInfo
-        pipeline_color_blend_state_create_info{
-            .logicOpEnable = false,
-            .logicOp = vk::LogicOp::eNoOp,
-            .attachmentCount = 1,
-            .pAttachments = &pipeline_color_blend_attachment_state,
-            .blendConstants =
-                {
-                    {1.f, 1.f, 1.f, 1.f},
-                },
-        };
-    std::array<vk::DynamicState, 2> dynamic_states{
-        vk::DynamicState::eViewport,
-        vk::DynamicState::eScissor,
-    };
-    vk::PipelineDynamicStateCreateInfo pipeline_dynamic_state_create_info{
-        .dynamicStateCount = dynamic_states.size(),
-        .pDynamicStates = dynamic_states.data(),
-    };
-    vk::GraphicsPipelineCreateInfo graphics_pipeline_create_info{
-        .stageCount = pipeline_shader_stage_create_infos.size(),
-        .pStages = pipeline_shader_stage_create_infos.data(),
-        .pVertexInputState = &pipeline_vertex_input_state_create_info,
-        .pInputAssemblyState = &pipeline_input_assembly_state_create_info,
-        .pTessellationState = nullptr,
-        .pViewportState = &pipeline_viewport_state_create_info,
-        .pRasterizationState = &pipeline_rasterization_state_create_info,
-        .pMultisampleState = &pipeline_multisample_state_create_info,
-        .pDepthStencilState = &pipeline_depth_stencil_state_create_info,
-        .pColorBlendState = &pipeline_color_blend_state_create_info,
-        .pDynamicState = &pipeline_dynamic_state_create_info,
-        .layout = m_pipeline_layouts[0],
-    };
-    vk::Format format = m_context->color_attachment_format();
-    vk::PipelineRenderingCreateInfo pipeline_rendering_create_info{
-        .colorAttachmentCount = 1,
-        .pColorAttachmentFormats = &format,
-        .depthAttachmentFormat = vk::Format::eD16Unorm,
-        .stencilAttachmentFormat = vk::Format::eD16Unorm,
+    m_pipeline_cache = std::make_unique<PipelineCache>(
+        *m_context, create_info.pipeline_cache_path);
+    m_pipeline_registry = std::make_unique<PipelineRegistry>(
+        *m_context, *m_pipeline_cache, create_info.pipeline_compile_threads);
+
+    m_uploader = std::make_unique<Uploader>(*m_context, create_info.uploader);
+    m_mesh_arena = std::make_unique<MeshArena>(*m_context, *m_uploader,
+                                               create_info.mesh_arena);
+    m_frame_allocator = std::make_unique<FrameAllocator>(
+        *m_context, frames_in_flight(), create_info.frame_allocator_size);
+    m_bindless_heap =
+        std::make_unique<BindlessHeap>(*m_context, create_info.bindless_heap);
+    m_render_graph = std::make_unique<RenderGraph>(*m_context);
+    m_thread_command_pools = std::make_unique<ThreadCommandPools>(
+        *m_context, m_job_system, frames_in_flight());
+    for (uint32_t i = 0; i < frames_in_flight(); i++) {
+      m_frames[i].frame_data_index = m_bindless_heap->add_storage_buffer(
+          m_frame_allocator->buffer(), m_frame_allocator->frame_offset(i),
+          m_frame_allocator->frame_size());
+    }
+    m_shader_library =
+        std::make_unique<ShaderLibrary>(*m_context, m_job_system);
+    const std::array<std::string, 2> shader_paths{
+        "./shaders/triangle.vert.spv",
+        "./shaders/triangle.frag.spv",
     };
-    auto chained_pipeline_create_info =
-        vk::StructureChain<vk::GraphicsPipelineCreateInfo,
-                           vk::PipelineRenderingCreateInfo>(
-            graphics_pipeline_create_info, pipeline_rendering_create_info)
-            .get();
-    auto result = m_context->device().createGraphicsPipelines(
-        nullptr, 1, &chained_pipeline_create_info, nullptr, m_pipelines.data());
+    m_shader_library->load(shader_paths);
+    m_shader_library->log_stats();
+    const Shader &vertex_shader = m_shader_library->get(shader_paths[0]);
+    const Shader &fragment_shader = m_shader_library->get(shader_paths[1]);
 
-    switch (result) {
-    case vk::Result::eSuccess:
-      break;
-    default:
-      throw std::runtime_error("Failed to create graphics pipeline");
+    m_pipeline_layouts.push_back(m_context->device().createPipelineLayout(
+        vk::PipelineLayoutCreateInfo{}));
+    m_background_pipeline = m_pipeline_registry->request(
+        pipeline_state(vertex_shader, fragment_shader, m_pipeline_layouts[0]));
+    if (create_info.gpu_driven && !m_context->draw_indirect_count()) {
+      spdlog::warn("Indirect draw features are unsupported, culling on the "
+                   "CPU");
+    } else if (create_info.gpu_driven) {
+      try {
+        m_gpu_culling = std::make_unique<GpuCulling>(
+            *m_context, *m_shader_library, *m_pipeline_cache,
+            frames_in_flight());
+        for (uint32_t i = 0; i < frames_in_flight(); i++) {
+          m_frames[i].object_buffer_index =
+              m_bindless_heap->add_storage_buffer(
+                  m_gpu_culling->object_buffer(i));
+        }
+      } catch (std::exception &err) {
+        spdlog::warn("GPU culling unavailable, culling on the CPU: {0}",
+                     err.what());
+      }
     }
+    if (m_gpu_culling && create_info.async_compute &&
+        m_context->async_compute()) {
+      for (auto &frame : m_frames) {
+        frame.compute_command_pool =
+            m_context->device().createCommandPool(vk::CommandPoolCreateInfo{
+                .flags = vk::CommandPoolCreateFlagBits::eTransient,
+                .queueFamilyIndex = m_context->compute_queue_family(),
+            });
+        frame.compute_command_buffer =
+            m_context->device()
+                .allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+                    .commandPool = frame.compute_command_pool,
+                    .level = vk::CommandBufferLevel::ePrimary,
+                    .commandBufferCount = 1,
+                })
+                .front();
+      }
+      const vk::SemaphoreTypeCreateInfo timeline_info{
+          .semaphoreType = vk::SemaphoreType::eTimeline,
+          .initialValue = 0,
+      };
+      m_compute_timeline =
+          m_context->device().createSemaphore(vk::SemaphoreCreateInfo{
+              .pNext = &timeline_info,
+          });
+      spdlog::info("Culling on the async compute queue");
+    }
+    request_mesh_pipelines();
 
-    m_render_semaphore = m_context->device().createSemaphore({});
-    m_present_semaphore = m_context->device().createSemaphore({});
-    m_fence = m_context->device().createFence(vk::FenceCreateInfo{
-        .flags = vk::FenceCreateFlagBits::eSignaled,
-    });
   } catch (std::exception &err) {
     spdlog::error("System error encountered: {0}", err.what());
     exit(-1);
@@ -182,166 +162,1074 @@ Renderer::Renderer()
   }
 }
 Renderer::~Renderer() {
-  m_context->device().freeCommandBuffers(m_command_pool, m_command_buffer);
-  m_context->device().destroyCommandPool(m_command_pool);
-  m_context->allocator().destroyBuffer(m_camera_ubo, m_camera_ubo_allocation);
-  m_context->allocator().freeMemory(m_camera_ubo_allocation);
+  m_context->device().waitIdle();
+  m_gpu_profiler.reset();
+  for (auto &frame : m_frames) {
+    m_context->device().destroyCommandPool(frame.command_pool);
+    m_context->device().destroyFence(frame.fence);
+    m_context->device().destroySemaphore(frame.image_available_semaphore);
+    m_context->device().destroyCommandPool(frame.compute_command_pool);
+  }
+  m_context->device().destroySemaphore(m_compute_timeline);
+  destroy_render_finished_semaphores();
+  // Before the layouts, shaders and cache its compiles use.
+  m_pipeline_registry->log_stats();
+  m_pipeline_registry.reset();
+  for (auto &pipeline_layout : m_pipeline_layouts) {
+    m_context->device().destroyPipelineLayout(pipeline_layout);
+  }
+  m_thread_command_pools.reset();
+  m_render_graph.reset();
+  m_gpu_culling.reset();
+  m_bindless_heap.reset();
+  m_shader_library.reset();
+  m_mesh_arena.reset();
+  m_frame_allocator.reset();
+  m_uploader.reset();
+  m_pipeline_cache->log_stats();
+  m_pipeline_cache->save();
+  m_pipeline_cache.reset();
 }
 
-void Renderer::render() {
-  auto result =
-      m_context->device().waitForFences(1, &m_fence, true, 1000000000);
+GraphicsPipelineState
+Renderer::pipeline_state(const Shader &vertex_shader,
+                         const Shader &fragment_shader,
+                         vk::PipelineLayout layout) const {
+  return GraphicsPipelineState{
+      .vertex_shader = &vertex_shader,
+      .fragment_shader = &fragment_shader,
+      .layout = layout,
+      // Kept across swapchain recreation, so pipelines stay valid.
+      .color_format = m_context->color_attachment_format(),
+      .depth_format = depth_format,
+  };
+}
 
-  switch (result) {
-  case vk::Result::eSuccess:
-    break;
-  default:
-    std::runtime_error("Error while waiting for fences");
+void Renderer::request_mesh_pipelines() {
+  const std::array<std::string, 2> shader_paths{
+      "./shaders/mesh.vert.glsl.spv",
+      "./shaders/mesh.frag.glsl.spv",
+  };
+  try {
+    m_shader_library->load(shader_paths);
+  } catch (std::exception &err) {
+    spdlog::warn("Mesh shaders unavailable, mesh draws are disabled: {0}",
+                 err.what());
+    return;
   }
+  const Shader &vertex_shader = m_shader_library->get(shader_paths[0]);
+  const Shader &fragment_shader = m_shader_library->get(shader_paths[1]);
 
-  result = m_context->device().resetFences(1, &m_fence);
-  switch (result) {
-  case vk::Result::eSuccess:
-    break;
-  default:
-    std::runtime_error("Error while waiting for fences");
+  // Set 0 is the bindless heap; the shaders' reflection data has to agree
+  // with it.
+  const std::array<const ShaderReflection *, 2> reflections{
+      &vertex_shader.reflection, &fragment_shader.reflection};
+  for (const DescriptorBinding &binding : merge_bindings(reflections)) {
+    if (binding.set != 0)
+      throw std::runtime_error("Mesh shaders may only use descriptor set 0");
+    if (binding.type != bindless_type(binding.binding))
+      throw std::runtime_error(fmt::format(
+          "Mesh shader binding {0} doesn't match the bindless heap's type",
+          binding.binding));
+  }
+  std::vector<vk::PushConstantRange> push_constant_ranges;
+  for (const ShaderReflection *reflection : reflections) {
+    for (const vk::PushConstantRange &range :
+         reflection->push_constant_ranges) {
+      push_constant_ranges.push_back(range);
+      m_mesh_push_constant_stages |= range.stageFlags;
+    }
   }
 
-  result = m_context->device().acquireNextImageKHR(
-      m_context->swapchain(), 1000000000, m_present_semaphore, nullptr,
-      &m_swapchain_image_index);
-  switch (result) {
-  case vk::Result::eSuccess:
-    break;
-  default:
-    std::runtime_error("Error while waiting for fences");
+  const vk::DescriptorSetLayout heap_layout = m_bindless_heap->layout();
+  m_pipeline_layouts.push_back(
+      m_context->device().createPipelineLayout(vk::PipelineLayoutCreateInfo{
+          .setLayoutCount = 1,
+          .pSetLayouts = &heap_layout,
+          .pushConstantRangeCount =
+              static_cast<uint32_t>(push_constant_ranges.size()),
+          .pPushConstantRanges = push_constant_ranges.data(),
+      }));
+
+  // One pipeline per vertex format and draw path; the vertex shader picks
+  // its decode (constant 0) and where its constants come from (constant 1)
+  // by specialization.
+  for (bool gpu_driven : {false, true}) {
+    if (gpu_driven && !m_gpu_culling)
+      continue;
+    for (types::VertexFormat format :
+         {types::VertexFormat::eFull, types::VertexFormat::eQuantized}) {
+      GraphicsPipelineState state = pipeline_state(
+          vertex_shader, fragment_shader, m_pipeline_layouts[1]);
+      state.specialization_count = 2;
+      state.specialization[0] = format == types::VertexFormat::eQuantized;
+      state.specialization[1] = gpu_driven;
+      state.vertex_format = format;
+      (gpu_driven ? m_indirect_mesh_pipelines
+                  : m_mesh_pipelines)[static_cast<size_t>(format)] =
+          m_pipeline_registry->request(state);
+    }
+  }
+}
+
+void Renderer::create_frames(uint32_t frames_in_flight) {
+  m_frames.resize(frames_in_flight);
+  for (auto &frame : m_frames) {
+    frame.command_pool =
+        m_context->device().createCommandPool(vk::CommandPoolCreateInfo{
+            .flags = vk::CommandPoolCreateFlagBits::eTransient,
+            .queueFamilyIndex = m_context->graphics_queue_family(),
+        });
+    frame.command_buffer =
+        m_context->device()
+            .allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+                .commandPool = frame.command_pool,
+                .level = vk::CommandBufferLevel::ePrimary,
+                .commandBufferCount = 1,
+            })
+            .front();
+    frame.fence = m_context->device().createFence(vk::FenceCreateInfo{
+        .flags = vk::FenceCreateFlagBits::eSignaled,
+    });
+    frame.image_available_semaphore = m_context->device().createSemaphore({});
+
+  }
+  create_render_finished_semaphores();
+  m_framebuffer_extent = m_context->framebuffer_extent();
+}
+
+void Renderer::create_render_finished_semaphores() {
+  // Present may still be reading a render-finished semaphore when the frame
+  // slot comes around again, so those are tracked per swapchain image.
+  m_render_finished_semaphores.resize(m_context->swapchain_images().size());
+  for (auto &semaphore : m_render_finished_semaphores) {
+    semaphore = m_context->device().createSemaphore({});
+  }
+}
+
+void Renderer::destroy_render_finished_semaphores() {
+  for (auto &semaphore : m_render_finished_semaphores) {
+    m_context->device().destroySemaphore(semaphore);
+  }
+  m_render_finished_semaphores.clear();
+}
+
+bool Renderer::recreate_swapchain() {
+  BS_PROFILE_ZONE("recreate_swapchain");
+  {
+    // Presents only wait on the graphics queue, so once it's idle nothing
+    // uses the old swapchain or its semaphores.
+    std::lock_guard queue_lock(m_context->graphics_queue_mutex());
+    m_context->queues()[0].waitIdle();
+  }
+  // Present ids belong to the old swapchain.
+  m_pending_presents.clear();
+  m_framebuffer_extent = m_context->framebuffer_extent();
+  if (!m_context->recreate_swapchain())
+    return false;
+  destroy_render_finished_semaphores();
+  create_render_finished_semaphores();
+  m_swapchain_dirty = false;
+  return true;
+}
+
+void Renderer::poll_presents() {
+  while (!m_pending_presents.empty()) {
+    const vk::Result result = m_context->wait_for_present(
+        m_pending_presents.front().present_id, 0);
+    if (result == vk::Result::eTimeout)
+      return;
+    if (result == vk::Result::eSuccess ||
+        result == vk::Result::eSuboptimalKHR) {
+      record_latency(m_pending_presents.front().input_time);
+    } else {
+      // Out of date: the frame may never be shown, so it isn't counted.
+      m_swapchain_dirty = true;
+    }
+    m_pending_presents.pop_front();
+  }
+}
+
+void Renderer::record_latency(
+    std::chrono::steady_clock::time_point input_time) {
+  const double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - input_time)
+                        .count();
+  LatencyStats &stats = m_latency_stats;
+  stats.min_ms = stats.frames == 0 ? ms : std::min(stats.min_ms, ms);
+  stats.max_ms = stats.frames == 0 ? ms : std::max(stats.max_ms, ms);
+  stats.total_ms += ms;
+  stats.frames++;
+  stats.present_wait = m_context->present_wait();
+}
+
+void Renderer::render() {
+  BS_PROFILE_ZONE("Renderer::render");
+  // The render thread records through thread 0's command pools while it
+  // helps the recording jobs; check before the frame's fence is reset.
+  if (m_job_system.thread_index() != 0)
+    throw std::runtime_error("Frames must be rendered on the thread that "
+                             "created the job system");
+  FrameData &frame = m_frames[m_frame_index];
+  vk::CommandBuffer &command_buffer = frame.command_buffer;
+
+  vk::Result result;
+  {
+    BS_PROFILE_ZONE("wait_for_frame");
+    result =
+        m_context->device().waitForFences(1, &frame.fence, true, 1000000000);
   }
-  m_command_buffer.reset();
-  m_command_buffer.begin(vk::CommandBufferBeginInfo{
+
+  if (result != vk::Result::eSuccess)
+    throw std::runtime_error(fmt::format("Error while waiting for fences: {0}",
+                                         vk::to_string(result)));
+  const std::chrono::steady_clock::time_point input_time =
+      m_input_time.value_or(std::chrono::steady_clock::now());
+  m_input_time.reset();
+
+  if (m_context->headless()) {
+    m_swapchain_image_index =
+        m_frame_index % m_context->swapchain_images().size();
+  } else {
+    if (m_context->present_wait())
+      poll_presents();
+    if (m_swapchain_dirty ||
+        m_context->framebuffer_extent() != m_framebuffer_extent) {
+      if (!recreate_swapchain()) {
+        // Minimized: the frame is dropped, draws and all.
+        m_draw_list.clear();
+        return;
+      }
+    }
+    result = m_context->device().acquireNextImageKHR(
+        m_context->swapchain(), 1000000000, frame.image_available_semaphore,
+        nullptr, &m_swapchain_image_index);
+    switch (result) {
+    case vk::Result::eSuccess:
+      break;
+    case vk::Result::eSuboptimalKHR:
+      // Still presentable; recreated before the next frame.
+      m_swapchain_dirty = true;
+      break;
+    case vk::Result::eErrorOutOfDateKHR:
+      // Nothing was acquired and the fence is still signaled, so the next
+      // render() recreates the swapchain and retries with this slot.
+      m_swapchain_dirty = true;
+      m_draw_list.clear();
+      return;
+    default:
+      throw std::runtime_error(fmt::format(
+          "Error while acquiring a swapchain image: {0}",
+          vk::to_string(result)));
+    }
+  }
+
+  result = m_context->device().resetFences(1, &frame.fence);
+  if (result != vk::Result::eSuccess)
+    throw std::runtime_error(fmt::format("Error while resetting fences: {0}",
+                                         vk::to_string(result)));
+
+  m_draw_stats = {};
+  // Meshes whose upload_value() is at most this are safe to draw.
+  const uint64_t upload_value = m_uploader->completed_value();
+  // Waiting on this slot's fence retired every frame up to the one that
+  // last used the slot.
+  m_frame_number++;
+  const uint64_t completed_frame = m_frame_number > m_frames.size()
+                                       ? m_frame_number - m_frames.size()
+                                       : 0;
+  m_context->begin_frame(m_frame_number, completed_frame, upload_value);
+  m_mesh_arena->begin_frame(m_frame_number, completed_frame, upload_value);
+  m_bindless_heap->begin_frame(m_frame_number, completed_frame);
+
+  m_frame_allocator->begin_frame(m_frame_index);
+  m_thread_command_pools->begin_frame(m_frame_index);
+  // The first allocation of the frame, so it always fits and starts the
+  // region, where the shaders look for it.
+  m_frame_allocator->push(m_camera->camera_data());
+
+  m_context->device().resetCommandPool(frame.command_pool);
+  command_buffer.begin(vk::CommandBufferBeginInfo{
       .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
   });
+#ifdef BS_ENGINE_PROFILING
+  m_gpu_profiler->begin_frame(command_buffer, m_frame_index,
+                              profiler::Profiler::get().frame_index());
+#endif
+
+  // Rebuilt every frame; the depth image is transient, so the graph keeps
+  // it across frames and recreates it when the extent changes.
+  const vk::Extent2D extent = m_context->extent();
+  m_render_graph->begin_frame(m_frame_number, completed_frame);
+  const GraphImage color = m_render_graph->import_image(
+      "color", m_context->swapchain_images()[m_swapchain_image_index],
+      m_context->swapchain_image_views()[m_swapchain_image_index],
+      vk::ImageAspectFlagBits::eColor,
+      // Acquire's semaphore is waited on at this stage.
+      ResourceState{
+          .stages = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+      },
+      m_context->headless()
+          ? ResourceState{
+                .stages = vk::PipelineStageFlagBits2::eTransfer,
+                .access = vk::AccessFlagBits2::eTransferRead,
+                .layout = vk::ImageLayout::eTransferSrcOptimal,
+            }
+          : ResourceState{
+                .layout = vk::ImageLayout::ePresentSrcKHR,
+            });
+  const GraphImage depth = m_render_graph->create_image(
+      "depth", TransientImageInfo{
+                   .format = depth_format,
+                   .extent = extent,
+                   .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment,
+                   .aspect = vk::ImageAspectFlagBits::eDepth,
+               });
+
+  GraphBuffer draw_commands;
+  GraphBuffer draw_counts;
+  bool async_cull = false;
+  if (m_gpu_culling && m_mesh_pipelines[0]) {
+    prepare_gpu_objects(upload_value);
+    draw_commands = m_render_graph->import_buffer(
+        "draw_commands", m_gpu_culling->draw_command_buffer(m_frame_index));
+    // gpu_visible_count() reads the counts back on the host.
+    draw_counts = m_render_graph->import_buffer(
+        "draw_counts", m_gpu_culling->draw_count_buffer(m_frame_index), {},
+        ResourceState{
+            .stages = vk::PipelineStageFlagBits2::eHost,
+            .access = vk::AccessFlagBits2::eHostRead,
+        });
+    const culling::Frustum frustum =
+        culling::Frustum::from_camera(m_camera->camera_data());
+    if (m_compute_timeline) {
+      // Runs while the graphics queue is still busy with earlier frames;
+      // the buffers arrive through the acquire recorded before the graph.
+      submit_async_cull(frustum);
+      async_cull = true;
+    } else {
+      m_render_graph
+          ->add_pass("cull_pass",
+                     [this, frustum](vk::CommandBuffer command_buffer) {
+                       m_gpu_culling->record_cull(command_buffer,
+                                                  m_frame_index, frustum);
+                     })
+          .write(draw_commands, ResourceUsage::eStorage)
+          .write(draw_counts, ResourceUsage::eTransfer)
+          .write(draw_counts, ResourceUsage::eStorage);
+    }
+  }
 
-  const vk::ImageMemoryBarrier2 image_memory_barrier_rendering{
-      .dstStageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-      .dstAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
-      .oldLayout = vk::ImageLayout::eUndefined,
-      .newLayout = vk::ImageLayout::eColorAttachmentOptimal,
-      .image = m_context->swapchain_images()[m_swapchain_image_index],
-      .subresourceRange =
-          {
-              .aspectMask = vk::ImageAspectFlagBits::eColor,
-              .baseMipLevel = 0,
-              .levelCount = 1,
-              .baseArrayLayer = 0,
-              .layerCount = 1,
-          },
+  PassBuilder main_pass = m_render_graph->add_pass(
+      "main_pass", [this, color, depth, extent,
+                    upload_value](vk::CommandBuffer command_buffer) {
+        // Culling and sorting come first: how many draws there are decides
+        // whether they're recorded inline or in parallel.
+        if (!m_gpu_culling)
+          prepare_draws(upload_value);
+        const bool parallel =
+            !m_gpu_culling && m_parallel_recording_threshold != 0 &&
+            m_draw_runs.size() >= m_parallel_recording_threshold;
+
+        const vk::RenderingAttachmentInfo color_attachment_info{
+            .imageView = m_render_graph->image_view(color),
+            .imageLayout = vk::ImageLayout::eAttachmentOptimal,
+            .loadOp = vk::AttachmentLoadOp::eClear,
+            .storeOp = vk::AttachmentStoreOp::eStore,
+            .clearValue =
+                vk::ClearValue{
+                    .color =
+                        {
+                            std::array<float, 4>{1.f, 1.f, 1.f, 1.f},
+                        },
+                },
+        };
+        // Only this pass uses depth, so nothing needs it stored.
+        const vk::RenderingAttachmentInfo depth_attachment_info{
+            .imageView = m_render_graph->image_view(depth),
+            .imageLayout = vk::ImageLayout::eAttachmentOptimal,
+            .loadOp = vk::AttachmentLoadOp::eClear,
+            .storeOp = vk::AttachmentStoreOp::eDontCare,
+            .clearValue =
+                vk::ClearValue{
+                    .depthStencil = vk::ClearDepthStencilValue{1.f, 0},
+                },
+        };
+        command_buffer.beginRendering(vk::RenderingInfo{
+            .flags =
+                parallel
+                    ? vk::RenderingFlagBits::eContentsSecondaryCommandBuffers
+                    : vk::RenderingFlags{},
+            .renderArea = vk::Rect2D{vk::Offset2D{0, 0}, extent},
+            .layerCount = 1,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &color_attachment_info,
+            .pDepthAttachment = &depth_attachment_info,
+        });
+        if (parallel) {
+          record_draws_parallel(command_buffer, extent);
+        } else {
+          set_viewport(command_buffer, extent);
+          record_background(command_buffer);
+          if (m_gpu_culling) {
+            draw_meshes_indirect(command_buffer);
+          } else {
+            record_draws(command_buffer, 0,
+                         static_cast<uint32_t>(m_draw_runs.size()),
+                         m_draw_stats);
+          }
+        }
+        command_buffer.endRendering();
+        if (!m_gpu_culling)
+          m_draw_stats.draws_saved = m_draw_stats.visible - m_draw_stats.draws;
+      });
+  main_pass.write(color, ResourceUsage::eColorAttachment)
+      .write(depth, ResourceUsage::eDepthAttachment);
+  if (draw_commands) {
+    main_pass.read(draw_commands, ResourceUsage::eIndirect)
+        .read(draw_counts, ResourceUsage::eIndirect);
+  }
+  m_render_graph->compile();
+  if (async_cull) {
+    m_gpu_culling->record_acquire(command_buffer, m_frame_index,
+                                  m_context->compute_queue_family(),
+                                  m_context->graphics_queue_family());
+  }
+  m_render_graph->execute(command_buffer, m_gpu_profiler.get());
+
+  m_draw_stats_total.items += m_draw_stats.items;
+  m_draw_stats_total.visible += m_draw_stats.visible;
+  m_draw_stats_total.draws += m_draw_stats.draws;
+  m_draw_stats_total.draws_saved += m_draw_stats.draws_saved;
+  m_draw_stats_total.pipeline_binds += m_draw_stats.pipeline_binds;
+  m_draw_stats_total.pipeline_binds_unsorted +=
+      m_draw_stats.pipeline_binds_unsorted;
+  m_draw_stats_total.secondary_command_buffers +=
+      m_draw_stats.secondary_command_buffers;
+  m_draw_stats_frames++;
+
+#ifdef BS_ENGINE_PROFILING
+  m_gpu_profiler->end_frame(command_buffer);
+#endif
+  command_buffer.end();
+
+  m_uploader->flush();
+  // Only uploads that had already completed when the frame started may be
+  // used by it, so this wait never blocks; it makes the transfer queue's
+  // writes visible to this submission.
+  std::vector<vk::SemaphoreSubmitInfo> wait_infos{
+      vk::SemaphoreSubmitInfo{
+          .semaphore = m_uploader->timeline_semaphore(),
+          .value = upload_value,
+          .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+      },
   };
-  const vk::DependencyInfo dependency_info_rendering{
-      .imageMemoryBarrierCount = 1,
-      .pImageMemoryBarriers = &image_memory_barrier_rendering,
+  if (async_cull) {
+    wait_infos.push_back(vk::SemaphoreSubmitInfo{
+        .semaphore = m_compute_timeline,
+        .value = m_frame_number,
+        .stageMask = vk::PipelineStageFlagBits2::eDrawIndirect,
+    });
+  }
+  std::vector<vk::SemaphoreSubmitInfo> signal_infos;
+  if (!m_context->headless()) {
+    wait_infos.push_back(vk::SemaphoreSubmitInfo{
+        .semaphore = frame.image_available_semaphore,
+        .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+    });
+    signal_infos.push_back(vk::SemaphoreSubmitInfo{
+        .semaphore = m_render_finished_semaphores[m_swapchain_image_index],
+        .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+    });
+  }
+  const vk::CommandBufferSubmitInfo command_buffer_info{
+      .commandBuffer = command_buffer,
   };
-  m_command_buffer.pipelineBarrier2(dependency_info_rendering);
-
-  const vk::RenderingAttachmentInfo color_attachment_info{
-      .imageView = m_context->swapchain_image_views()[m_swapchain_image_index],
-      .imageLayout = vk::ImageLayout::eAttachmentOptimal,
-      .loadOp = vk::AttachmentLoadOp::eClear,
-      .storeOp = vk::AttachmentStoreOp::eStore,
-      .clearValue =
-          vk::ClearValue{
-              .color =
-                  {
-                      std::array<float, 4>{1.f, 1.f, 1.f, 1.f},
-                  },
-          },
+  std::unique_lock queue_lock(m_context->graphics_queue_mutex());
+  m_context->queues()[0].submit2(
+      vk::SubmitInfo2{
+          .waitSemaphoreInfoCount = static_cast<uint32_t>(wait_infos.size()),
+          .pWaitSemaphoreInfos = wait_infos.data(),
+          .commandBufferInfoCount = 1,
+          .pCommandBufferInfos = &command_buffer_info,
+          .signalSemaphoreInfoCount =
+              static_cast<uint32_t>(signal_infos.size()),
+          .pSignalSemaphoreInfos = signal_infos.data(),
+      },
+      frame.fence);
+  m_frame_index = (m_frame_index + 1) % m_frames.size();
+  if (m_context->headless())
+    return;
+
+  // Frame numbers only increase, as present ids must.
+  const vk::PresentIdKHR present_id{
+      .swapchainCount = 1,
+      .pPresentIds = &m_frame_number,
   };
-  const vk::RenderingAttachmentInfoKHR depth_attachment_info{
-      .imageView = m_context->depth_image_view(),
-      .imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
-      .loadOp = vk::AttachmentLoadOp::eClear,
-      .storeOp = vk::AttachmentStoreOp::eStore,
-      .clearValue =
-          vk::ClearValue{
-              .depthStencil = vk::ClearDepthStencilValue{1.f, 0},
-          },
+  const vk::PresentInfoKHR present_info{
+      .pNext = m_context->present_wait() ? &present_id : nullptr,
+      .waitSemaphoreCount = 1,
+      .pWaitSemaphores = &m_render_finished_semaphores[m_swapchain_image_index],
+      .swapchainCount = 1,
+      .pSwapchains = &m_context->swapchain(),
+      .pImageIndices = &m_swapchain_image_index,
+  };
+  try {
+    result = m_context->queues()[0].presentKHR(present_info);
+  } catch (vk::OutOfDateKHRError &) {
+    // The present's semaphore wait still happens; the frame is dropped.
+    m_swapchain_dirty = true;
+    return;
+  }
+  if (result == vk::Result::eSuboptimalKHR)
+    m_swapchain_dirty = true;
+  if (m_context->present_wait()) {
+    m_pending_presents.push_back(PendingPresent{
+        .present_id = m_frame_number,
+        .input_time = input_time,
+    });
+  } else {
+    // Without present wait the best available bound is the present call
+    // returning, which omits the time the image spends queued for display.
+    record_latency(input_time);
+  }
+}
+
+types::MeshHandle Renderer::add_mesh(types::Mesh mesh) {
+  m_mesh_arena->upload(mesh);
+  return m_meshes.create(std::move(mesh));
+}
+
+types::Model Renderer::load_model(const std::string &path) {
+  BS_PROFILE_ZONE("Renderer::load_model");
+  const types::MeshAsset asset(path);
+  std::vector<types::MeshHandle> meshes;
+  meshes.reserve(asset.meshes().size());
+  for (const types::MeshAssetView &view : asset.meshes()) {
+    types::Mesh mesh;
+    m_mesh_arena->upload(mesh, view);
+    meshes.push_back(m_meshes.create(std::move(mesh)));
+  }
+  spdlog::info("Loaded {0} meshes ({1} bytes) from {2}", meshes.size(),
+               asset.size(), path);
+  return types::Model(std::move(meshes));
+}
+
+void Renderer::destroy(types::MeshHandle handle) {
+  std::optional<types::Mesh> mesh = m_meshes.destroy(handle);
+  if (!mesh) {
+    if (handle)
+      spdlog::warn("Ignoring destroy of stale mesh handle {0:#x}",
+                   handle.value());
+    return;
+  }
+  m_mesh_arena->free(*mesh);
+}
+
+void Renderer::destroy(const types::Model &model) {
+  for (types::MeshHandle mesh : model.meshes()) {
+    destroy(mesh);
+  }
+}
+
+uint32_t Renderer::gpu_visible_count() const {
+  if (!m_gpu_culling)
+    return 0;
+  const uint32_t last_frame_index =
+      (m_frame_index + frames_in_flight() - 1) % frames_in_flight();
+  return m_gpu_culling->visible_count(last_frame_index);
+}
+
+void Renderer::log_draw_stats() const {
+  if (m_draw_stats_frames == 0)
+    return;
+  const double frames = static_cast<double>(m_draw_stats_frames);
+  spdlog::info("Draws per frame: {0:.1f} items, {1:.1f} visible, {2:.1f} "
+               "draws ({3:.1f} saved by instancing), {4:.1f} pipeline binds "
+               "({5:.1f} unsorted), {6:.1f} secondary command buffers",
+               m_draw_stats_total.items / frames,
+               m_draw_stats_total.visible / frames,
+               m_draw_stats_total.draws / frames,
+               m_draw_stats_total.draws_saved / frames,
+               m_draw_stats_total.pipeline_binds / frames,
+               m_draw_stats_total.pipeline_binds_unsorted / frames,
+               m_draw_stats_total.secondary_command_buffers / frames);
+}
+
+void Renderer::log_latency_stats() const {
+  const LatencyStats &stats = m_latency_stats;
+  if (stats.frames == 0)
+    return;
+  spdlog::info("Input to {0} latency: {1:.2f}ms mean, {2:.2f}ms min, "
+               "{3:.2f}ms max over {4} frames ({5})",
+               stats.present_wait ? "present" : "present call",
+               stats.total_ms / stats.frames, stats.min_ms, stats.max_ms,
+               stats.frames, vk::to_string(m_context->present_mode()));
+}
+
+void Renderer::cull_meshes() {
+  BS_PROFILE_ZONE("cull_meshes");
+  m_draw_spheres.clear();
+  m_draw_spheres.reserve(static_cast<uint32_t>(m_draw_list.size()));
+  for (const DrawItem &item : m_draw_list) {
+    const types::Mesh *mesh = m_meshes.get(item.mesh);
+    const glm::vec4 sphere =
+        mesh != nullptr
+            ? culling::transform_sphere(item.transform,
+                                        mesh->bounding_sphere())
+            : glm::vec4(0.f);
+    m_draw_spheres.push_back(glm::vec3(sphere), sphere.w);
+  }
+  culling::cull_spheres(m_job_system,
+                        culling::Frustum::from_camera(m_camera->camera_data()),
+                        m_draw_spheres, m_visible_draws);
+}
+
+void Renderer::write_instances() {
+  const uint32_t count = static_cast<uint32_t>(m_sorted_draws.size());
+  // Aligned to a whole mat4 from the region's start, so the shaders can
+  // index the region as an array of them.
+  const FrameAllocation allocation = m_frame_allocator->allocate(
+      sizeof(glm::mat4) * count, sizeof(glm::mat4));
+  if (!allocation) {
+    spdlog::warn("{0} instances don't fit the frame allocator, skipping "
+                 "mesh draws this frame",
+                 count);
+    m_sorted_draws.clear();
+    return;
+  }
+  m_instance_base = static_cast<uint32_t>(
+      (allocation.offset - m_frame_allocator->frame_offset(m_frame_index)) /
+      sizeof(glm::mat4));
+  glm::mat4 *transforms = static_cast<glm::mat4 *>(allocation.mapped);
+  for (uint32_t i = 0; i < count; i++) {
+    transforms[i] = m_draw_list[m_sorted_draws[i].item].transform;
+  }
+}
+
+void Renderer::bind_bindless_heap(vk::CommandBuffer command_buffer) {
+  command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+                                    m_pipeline_layouts[1], 0,
+                                    m_bindless_heap->set(), {});
+}
+
+types::DrawConstants Renderer::draw_constants() const {
+  const FrameData &frame = m_frames[m_frame_index];
+  return types::DrawConstants{
+      .frame_data = frame.frame_data_index,
+      .instance_base = m_instance_base,
+      .object_buffer = frame.object_buffer_index,
   };
-  const vk::RenderingInfo rendering_info{
-      .layerCount = 1,
+}
+
+void Renderer::prepare_draws(uint64_t upload_value) {
+  m_draw_runs.clear();
+  if (!m_mesh_pipelines[0]) {
+    m_draw_list.clear();
+    return;
+  }
+  BS_PROFILE_ZONE("prepare_draws");
+  for (size_t i = 0; i < m_mesh_pipelines.size(); i++) {
+    m_ready_mesh_pipelines[i] = m_pipeline_registry->get(m_mesh_pipelines[i]);
+  }
+  cull_meshes();
+
+  {
+    BS_PROFILE_ZONE("sort_draws");
+    // Depth along the camera's view direction, in the same space as the
+    // culled spheres.
+    const types::CameraUBO &camera = m_camera->camera_data();
+    const glm::mat4 view_model = camera.view * camera.model;
+    const glm::vec4 depth_row(view_model[0][2], view_model[1][2],
+                              view_model[2][2], view_model[3][2]);
+    m_sorted_draws.clear();
+    uint32_t previous_format = UINT32_MAX;
+    for (uint32_t draw : m_visible_draws) {
+      const DrawItem &item = m_draw_list[draw];
+      const types::Mesh *mesh = m_meshes.get(item.mesh);
+      if (mesh == nullptr || !mesh->uploaded() ||
+          mesh->upload_value() > upload_value)
+        continue;
+      const uint32_t format = static_cast<uint32_t>(mesh->vertex_format());
+      if (!m_ready_mesh_pipelines[format])
+        continue;
+      if (format != previous_format) {
+        m_draw_stats.pipeline_binds_unsorted++;
+        previous_format = format;
+      }
+      // Right-handed view space looks down -z.
+      const float depth = -glm::dot(
+          depth_row, glm::vec4(m_draw_spheres.x()[draw],
+                               m_draw_spheres.y()[draw],
+                               m_draw_spheres.z()[draw], 1.f));
+      m_sorted_draws.push_back(SortedDraw{
+          .key = draw_key::make(format, item.material, item.mesh.index(),
+                                draw_key::quantize_depth(depth)),
+          .item = draw,
+      });
+    }
+    sort_draws(m_sorted_draws, m_sort_scratch);
+  }
+  write_instances();
+
+  // Runs of equal batch keys are the same pipeline, material and mesh, so
+  // each run is one instanced draw whose instances are consecutive in the
+  // instance buffer.
+  const uint32_t count = static_cast<uint32_t>(m_sorted_draws.size());
+  for (uint32_t first = 0; first < count;) {
+    const uint64_t batch = draw_key::batch(m_sorted_draws[first].key);
+    uint32_t last = first + 1;
+    while (last < count && draw_key::batch(m_sorted_draws[last].key) == batch)
+      last++;
+    m_draw_runs.push_back(DrawRun{
+        .mesh = m_meshes.get(m_draw_list[m_sorted_draws[first].item].mesh),
+        .format = draw_key::pipeline(m_sorted_draws[first].key),
+        .first_instance = first,
+        .instance_count = last - first,
+    });
+    first = last;
+  }
+  m_draw_stats.items = static_cast<uint32_t>(m_draw_list.size());
+  m_draw_stats.visible = count;
+  m_draw_list.clear();
+}
+
+void Renderer::set_viewport(vk::CommandBuffer command_buffer,
+                            vk::Extent2D extent) {
+  command_buffer.setViewport(
+      0, vk::Viewport{0.f, 0.f, static_cast<float>(extent.width),
+                      static_cast<float>(extent.height), 0.f, 0.f});
+  command_buffer.setScissor(0, vk::Rect2D{vk::Offset2D{0, 0}, extent});
+}
+
+void Renderer::record_background(vk::CommandBuffer command_buffer) {
+  const vk::Pipeline pipeline =
+      m_pipeline_registry->get(m_background_pipeline);
+  if (!pipeline)
+    return;
+  command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+  command_buffer.draw(3, 1, 0, 0);
+}
+
+void Renderer::record_draws(vk::CommandBuffer command_buffer, uint32_t begin,
+                            uint32_t end, DrawStats &stats) {
+  if (begin == end)
+    return;
+  BS_PROFILE_ZONE("record_draws");
+  bind_bindless_heap(command_buffer);
+  // Only the mesh constants change between draws.
+  types::DrawConstants constants = draw_constants();
+  command_buffer.bindIndexBuffer(m_mesh_arena->index_buffer(), 0,
+                                 vk::IndexType::eUint32);
+  uint32_t bound_format = UINT32_MAX;
+  for (uint32_t i = begin; i < end; i++) {
+    const DrawRun &run = m_draw_runs[i];
+    if (run.format != bound_format) {
+      command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
+                                  m_ready_mesh_pipelines[run.format]);
+      command_buffer.bindVertexBuffers(
+          0, m_mesh_arena->vertex_buffer(run.mesh->vertex_format()), {0});
+      bound_format = run.format;
+      stats.pipeline_binds++;
+    }
+    constants.set_mesh(run.mesh->constants());
+    command_buffer.pushConstants(m_pipeline_layouts[1],
+                                 m_mesh_push_constant_stages, 0,
+                                 sizeof(constants), &constants);
+    command_buffer.drawIndexed(
+        run.mesh->index_count(), run.instance_count, run.mesh->first_index(),
+        static_cast<int32_t>(run.mesh->range().first_vertex),
+        run.first_instance);
+    stats.draws++;
+  }
+}
+
+vk::CommandBuffer Renderer::record_secondary(
+    const vk::CommandBufferInheritanceRenderingInfo &inheritance,
+    vk::Extent2D extent, uint32_t index, uint32_t begin, uint32_t end) {
+  const vk::CommandBuffer secondary =
+      m_thread_command_pools->begin(inheritance);
+  if (!secondary)
+    return {};
+  // Secondaries inherit no state from the primary or each other.
+  set_viewport(secondary, extent);
+  if (index == 0)
+    record_background(secondary);
+  record_draws(secondary, begin, end, m_batch_stats[index]);
+  secondary.end();
+  return secondary;
+}
+
+void Renderer::record_draws_parallel(vk::CommandBuffer command_buffer,
+                                     vk::Extent2D extent) {
+  BS_PROFILE_ZONE("record_draws_parallel");
+  const vk::Format color_format = m_context->color_attachment_format();
+  const vk::CommandBufferInheritanceRenderingInfo inheritance{
       .colorAttachmentCount = 1,
-      .pColorAttachments = &color_attachment_info,
-      .pDepthAttachment = &depth_attachment_info,
-      .pStencilAttachment = &depth_attachment_info,
+      .pColorAttachmentFormats = &color_format,
+      .depthAttachmentFormat = depth_format,
+      .rasterizationSamples = vk::SampleCountFlagBits::e1,
   };
+  // parallel_for() splits the runs at multiples of `batch`, so each batch
+  // knows its place in the primary from where it starts, whichever thread
+  // records it.
+  const uint32_t count = static_cast<uint32_t>(m_draw_runs.size());
+  const uint32_t batch =
+      m_job_system.batch_size(count, m_draws_per_recording_job);
+  const uint32_t batch_count = (count + batch - 1) / batch;
+  m_secondary_command_buffers.assign(batch_count, vk::CommandBuffer{});
+  m_batch_stats.assign(batch_count, DrawStats{});
+  m_job_system.parallel_for(
+      count,
+      [&](uint32_t begin, uint32_t end) {
+        const uint32_t index = begin / batch;
+        // Exceptions can't cross the job boundary; a batch that fails is
+        // left null and recorded again below.
+        try {
+          m_secondary_command_buffers[index] =
+              record_secondary(inheritance, extent, index, begin, end);
+        } catch (std::exception &err) {
+          spdlog::error("Failed to record draw batch {0}: {1}", index,
+                        err.what());
+        }
+      },
+      m_draws_per_recording_job);
+  // A foreign thread that ran a batch while waiting on the job system has
+  // no pool, so its batches land here too, on thread 0's pool. Failures
+  // this time propagate.
+  for (uint32_t index = 0; index < batch_count; index++) {
+    if (m_secondary_command_buffers[index])
+      continue;
+    m_batch_stats[index] = DrawStats{};
+    m_secondary_command_buffers[index] =
+        record_secondary(inheritance, extent, index, index * batch,
+                         std::min(index * batch + batch, count));
+  }
+  command_buffer.executeCommands(m_secondary_command_buffers);
+
+  for (const DrawStats &stats : m_batch_stats) {
+    m_draw_stats.draws += stats.draws;
+    m_draw_stats.pipeline_binds += stats.pipeline_binds;
+  }
+  m_draw_stats.secondary_command_buffers = batch_count;
+}
 
-  m_command_buffer.beginRendering(rendering_info);
-
-  m_command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
-                                m_pipelines[0]);
-  m_command_buffer.setViewport(
-      0, vk::Viewport{
-             0.f, 0.f, static_cast<float>(m_context->window().getWidth()),
-             static_cast<float>(m_context->window().getHeight()), 0.f, 0.f});
-  m_command_buffer.setScissor(
-      0,
-      vk::Rect2D{vk::Offset2D{0, 0},
-                 vk::Extent2D{
-                     static_cast<uint32_t>(m_context->window().getWidth()),
-                     static_cast<uint32_t>(m_context->window().getHeight())}});
-
-  m_command_buffer.draw(3, 1, 0, 0);
-
-  m_command_buffer.endRendering();
-
-  const vk::ImageMemoryBarrier2 image_memory_barrier_presenting{
-      .srcStageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-      .srcAccessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
-      .oldLayout = vk::ImageLayout::eColorAttachmentOptimal,
-      .newLayout = vk::ImageLayout::ePresentSrcKHR,
-      .image = m_context->swapchain_images()[m_swapchain_image_index],
-      .subresourceRange =
-          {
-              .aspectMask = vk::ImageAspectFlagBits::eColor,
-              .baseMipLevel = 0,
-              .levelCount = 1,
-              .baseArrayLayer = 0,
-              .layerCount = 1,
-          },
+void Renderer::submit_async_cull(const culling::Frustum &frustum) {
+  BS_PROFILE_ZONE("submit_async_cull");
+  // The slot's fence covers this too: the frame's graphics submission
+  // waited for it.
+  const FrameData &frame = m_frames[m_frame_index];
+  m_context->device().resetCommandPool(frame.compute_command_pool);
+  frame.compute_command_buffer.begin(vk::CommandBufferBeginInfo{
+      .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+  });
+  m_gpu_culling->record_cull(frame.compute_command_buffer, m_frame_index,
+                             frustum);
+  m_gpu_culling->record_release(frame.compute_command_buffer, m_frame_index,
+                                m_context->compute_queue_family(),
+                                m_context->graphics_queue_family());
+  frame.compute_command_buffer.end();
+
+  const vk::CommandBufferSubmitInfo command_buffer_info{
+      .commandBuffer = frame.compute_command_buffer,
   };
-  const vk::DependencyInfo dependency_info_presenting{
-      .imageMemoryBarrierCount = 1,
-      .pImageMemoryBarriers = &image_memory_barrier_presenting,
+  const vk::SemaphoreSubmitInfo signal_info{
+      .semaphore = m_compute_timeline,
+      .value = m_frame_number,
+      .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
   };
-  m_command_buffer.pipelineBarrier2(dependency_info_presenting);
-
-  m_command_buffer.end();
-
-  vk::PipelineStageFlags wait_stage =
-      vk::PipelineStageFlagBits::eColorAttachmentOutput;
-  m_context->queues()[0].submit(
-      vk::SubmitInfo{
-          .waitSemaphoreCount = 1,
-          .pWaitSemaphores = &m_present_semaphore,
-          .pWaitDstStageMask = &wait_stage,
-          .commandBufferCount = 1,
-          .pCommandBuffers = &m_command_buffer,
-          .signalSemaphoreCount = 1,
-          .pSignalSemaphores = &m_render_semaphore,
+  std::lock_guard queue_lock(m_context->compute_queue_mutex());
+  m_context->compute_queue().submit2(vk::SubmitInfo2{
+      .commandBufferInfoCount = 1,
+      .pCommandBufferInfos = &command_buffer_info,
+      .signalSemaphoreInfoCount = 1,
+      .pSignalSemaphoreInfos = &signal_info,
+  });
+}
+
+void Renderer::prepare_gpu_objects(uint64_t upload_value) {
+  BS_PROFILE_ZONE("prepare_gpu_objects");
+  // Sorting groups the objects by vertex format, so each format's draws
+  // read one contiguous range of commands. Depth is left out: the cull
+  // pass appends commands in whatever order its invocations finish.
+  m_sorted_draws.clear();
+  std::array<uint32_t, 2> format_counts{};
+  uint32_t previous_format = UINT32_MAX;
+  for (uint32_t draw = 0; draw < m_draw_list.size(); draw++) {
+    const DrawItem &item = m_draw_list[draw];
+    const types::Mesh *mesh = m_meshes.get(item.mesh);
+    if (mesh == nullptr || !mesh->uploaded() ||
+        mesh->upload_value() > upload_value)
+      continue;
+    const uint32_t format = static_cast<uint32_t>(mesh->vertex_format());
+    format_counts[format]++;
+    if (format != previous_format) {
+      m_draw_stats.pipeline_binds_unsorted++;
+      previous_format = format;
+    }
+    m_sorted_draws.push_back(SortedDraw{
+        .key = draw_key::make(format, item.material, item.mesh.index(), 0),
+        .item = draw,
+    });
+  }
+  sort_draws(m_sorted_draws, m_sort_scratch);
+  write_instances();
+  if (m_sorted_draws.empty())
+    format_counts = {};
+
+  // Object i is drawn with instance i, so it finds its transform at the
+  // same index.
+  m_gpu_objects.resize(m_sorted_draws.size());
+  for (uint32_t i = 0; i < m_sorted_draws.size(); i++) {
+    const DrawItem &item = m_draw_list[m_sorted_draws[i].item];
+    const types::Mesh *mesh = m_meshes.get(item.mesh);
+    const types::MeshConstants constants = mesh->constants();
+    m_gpu_objects[i] = GpuObject{
+        .sphere =
+            culling::transform_sphere(item.transform, mesh->bounding_sphere()),
+        .position_scale = constants.position_scale,
+        .position_offset = constants.position_offset,
+        .index_count = mesh->index_count(),
+        .first_index = mesh->first_index(),
+        .vertex_offset = static_cast<int32_t>(mesh->range().first_vertex),
+        .vertex_format = static_cast<uint32_t>(mesh->vertex_format()),
+    };
+  }
+  m_draw_stats.items = static_cast<uint32_t>(m_draw_list.size());
+  m_draw_stats.visible = static_cast<uint32_t>(m_gpu_objects.size());
+  m_draw_list.clear();
+  // A replaced object buffer gets a new index; the old one is released
+  // once the frames still holding it have completed.
+  if (m_gpu_culling->prepare(m_frame_index, m_gpu_objects, format_counts)) {
+    FrameData &frame = m_frames[m_frame_index];
+    m_bindless_heap->remove_storage_buffer(frame.object_buffer_index);
+    frame.object_buffer_index = m_bindless_heap->add_storage_buffer(
+        m_gpu_culling->object_buffer(m_frame_index));
+  }
+}
+
+void Renderer::draw_meshes_indirect(vk::CommandBuffer command_buffer) {
+  if (!m_mesh_pipelines[0]) {
+    m_draw_list.clear();
+    return;
+  }
+  BS_PROFILE_ZONE("draw_meshes_indirect");
+  bind_bindless_heap(command_buffer);
+  // The shader reads the mesh constants from the object buffer, so one
+  // push serves every format.
+  const types::DrawConstants constants = draw_constants();
+  command_buffer.pushConstants(m_pipeline_layouts[1],
+                               m_mesh_push_constant_stages, 0,
+                               sizeof(constants), &constants);
+  command_buffer.bindIndexBuffer(m_mesh_arena->index_buffer(), 0,
+                                 vk::IndexType::eUint32);
+  for (types::VertexFormat format :
+       {types::VertexFormat::eFull, types::VertexFormat::eQuantized}) {
+    // Culled anyway, so the counts stay right while the pipeline compiles.
+    const vk::Pipeline pipeline = m_pipeline_registry->get(
+        m_indirect_mesh_pipelines[static_cast<size_t>(format)]);
+    if (!pipeline || m_gpu_culling->object_count(m_frame_index, format) == 0)
+      continue;
+    command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+    command_buffer.bindVertexBuffers(0, m_mesh_arena->vertex_buffer(format),
+                                     {0});
+    m_gpu_culling->record_draw(command_buffer, m_frame_index, format);
+    m_draw_stats.pipeline_binds++;
+    m_draw_stats.draws++;
+  }
+  m_draw_stats.draws_saved = m_draw_stats.visible - m_draw_stats.draws;
+}
+
+std::vector<uint8_t> Renderer::read_back() {
+  if (!m_context->headless())
+    throw std::runtime_error("Frame readback requires a headless context");
+
+  m_context->device().waitIdle();
+  // The most recent frame ran in the slot before m_frame_index; reuse the
+  // next slot's command buffer, which is idle after waitIdle().
+  FrameData &frame = m_frames[m_frame_index];
+  vk::CommandBuffer &command_buffer = frame.command_buffer;
+
+  const vk::Extent2D extent = m_context->extent();
+  // Every supported offscreen format is 4 bytes per texel.
+  const vk::DeviceSize size =
+      static_cast<vk::DeviceSize>(extent.width) * extent.height * 4;
+  auto [buffer, allocation] = m_context->allocator().createBuffer(
+      vk::BufferCreateInfo{
+          .size = size,
+          .usage = vk::BufferUsageFlagBits::eTransferDst,
       },
-      m_fence);
+      vma::AllocationCreateInfo{
+          .flags = vma::AllocationCreateFlagBits::eHostAccessRandom,
+          .usage = vma::MemoryUsage::eAutoPreferHost,
+      });
 
-  const vk::PresentInfoKHR present_info{
-      .waitSemaphoreCount = 1,
-      .pWaitSemaphores = &m_render_semaphore,
-      .swapchainCount = 1,
-      .pSwapchains = &m_context->swapchain(),
-      .pImageIndices = &m_swapchain_image_index,
+  m_context->device().resetCommandPool(frame.command_pool);
+  command_buffer.begin(vk::CommandBufferBeginInfo{
+      .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+  });
+  command_buffer.copyImageToBuffer(
+      m_context->swapchain_images()[m_swapchain_image_index],
+      vk::ImageLayout::eTransferSrcOptimal, buffer,
+      vk::BufferImageCopy{
+          .bufferOffset = 0,
+          .bufferRowLength = 0,
+          .bufferImageHeight = 0,
+          .imageSubresource =
+              {
+                  .aspectMask = vk::ImageAspectFlagBits::eColor,
+                  .mipLevel = 0,
+                  .baseArrayLayer = 0,
+                  .layerCount = 1,
+              },
+          .imageOffset = {0, 0, 0},
+          .imageExtent = {extent.width, extent.height, 1},
+      });
+  const vk::BufferMemoryBarrier2 host_read_barrier{
+      .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+      .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+      .dstAccessMask = vk::AccessFlagBits2::eHostRead,
+      .buffer = buffer,
+      .offset = 0,
+      .size = size,
   };
-  result = m_context->queues()[0].presentKHR(present_info);
-  switch (result) {
-  case vk::Result::eSuccess:
-    break;
-  default:
-    std::runtime_error("Error while waiting for fences");
+  command_buffer.pipelineBarrier2(vk::DependencyInfo{
+      .bufferMemoryBarrierCount = 1,
+      .pBufferMemoryBarriers = &host_read_barrier,
+  });
+  command_buffer.end();
+
+  auto result = m_context->device().resetFences(1, &frame.fence);
+  {
+    std::lock_guard queue_lock(m_context->graphics_queue_mutex());
+    m_context->queues()[0].submit(
+        vk::SubmitInfo{
+            .commandBufferCount = 1,
+            .pCommandBuffers = &command_buffer,
+        },
+        frame.fence);
+  }
+  result = m_context->device().waitForFences(1, &frame.fence, true, UINT64_MAX);
+  if (result != vk::Result::eSuccess)
+    throw std::runtime_error("Timed out waiting for frame readback");
+
+  std::vector<uint8_t> pixels(size);
+  void *mapped = m_context->allocator().mapMemory(allocation);
+  m_context->allocator().invalidateAllocation(allocation, 0, size);
+  std::memcpy(pixels.data(), mapped, size);
+  m_context->allocator().unmapMemory(allocation);
+  m_context->allocator().destroyBuffer(buffer, allocation);
+  return pixels;
+}
+
+uint64_t Renderer::frame_checksum() {
+  // FNV-1a, stable across runs and machines for identical pixels.
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (uint8_t byte : read_back()) {
+    hash ^= byte;
+    hash *= 0x100000001b3ull;
   }
+  return hash;
 }
 } // namespace bs::engine::renderer
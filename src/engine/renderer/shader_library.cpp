@@ -0,0 +1,166 @@
+#include <engine/renderer/shader_library.hpp>
+
+#include <engine/profiler/profiler.hpp>
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+
+namespace bs::engine::renderer {
+namespace {
+// FNV-1a over whole words; SPIR-V is always a multiple of four bytes.
+uint64_t hash_words(std::span<const uint32_t> words) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (uint32_t word : words) {
+    hash ^= word;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+} // namespace
+
+ShaderLibrary::ShaderLibrary(context::Context &context,
+                             jobs::JobSystem &job_system)
+    : m_context(context), m_job_system(job_system) {}
+ShaderLibrary::~ShaderLibrary() {
+  for (auto &[hash, entry] : m_shaders) {
+    m_context.device().destroyShaderModule(entry.shader.module);
+  }
+}
+
+void ShaderLibrary::load(std::span<const std::string> paths) {
+  BS_PROFILE_ZONE("ShaderLibrary::load");
+  const uint64_t start = profiler::now_ns();
+
+  std::vector<std::string> errors(paths.size());
+  m_job_system.parallel_for(
+      static_cast<uint32_t>(paths.size()),
+      [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+          errors[i] = load_file(paths[i]);
+        }
+      });
+
+  std::lock_guard lock(m_mutex);
+  m_stats.load_ns += profiler::now_ns() - start;
+  auto failed = std::find_if(errors.begin(), errors.end(),
+                             [](const std::string &e) { return !e.empty(); });
+  if (failed != errors.end())
+    throw std::runtime_error(*failed);
+}
+
+const Shader &ShaderLibrary::load(const std::string &path) {
+  load(std::span<const std::string>(&path, 1));
+  return get(path);
+}
+
+const Shader &ShaderLibrary::get(const std::string &path) const {
+  std::lock_guard lock(m_mutex);
+  return *m_paths.at(path);
+}
+
+const Shader *ShaderLibrary::find(uint64_t hash) const {
+  std::lock_guard lock(m_mutex);
+  auto [begin, end] = m_shaders.equal_range(hash);
+  for (auto it = begin; it != end; it++) {
+    if (it->second.ready)
+      return &it->second.shader;
+  }
+  return nullptr;
+}
+
+std::string ShaderLibrary::load_file(const std::string &path) {
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_paths.contains(path))
+      return {};
+  }
+
+  try {
+    io::MappedFile file(path);
+    if (file.empty() || file.size() % sizeof(uint32_t) != 0)
+      return fmt::format("Shader {0} is not a SPIR-V binary", path);
+    // mmap returns page-aligned memory, so the words can be read in place.
+    const std::span<const uint32_t> code(
+        reinterpret_cast<const uint32_t *>(file.data()),
+        file.size() / sizeof(uint32_t));
+    const uint64_t hash = hash_words(code);
+
+    // Whoever inserts the binary first creates the module; identical
+    // binaries loaded by other jobs wait for it and point their path at it.
+    // If it fails, the entry is erased and a waiting job takes over.
+    Entry *entry = nullptr;
+    {
+      std::unique_lock lock(m_mutex);
+      m_stats.files++;
+      m_stats.mapped_bytes += file.size();
+      while (true) {
+        entry = nullptr;
+        auto [begin, end] = m_shaders.equal_range(hash);
+        for (auto it = begin; it != end && !entry; it++) {
+          const std::span<const uint8_t> bytes = it->second.file.bytes();
+          if (std::equal(file.data(), file.data() + file.size(),
+                         bytes.begin(), bytes.end()))
+            entry = &it->second;
+        }
+        if (!entry || entry->ready)
+          break;
+        m_created.wait(lock);
+      }
+      if (entry) {
+        m_paths.emplace(path, &entry->shader);
+        return {};
+      }
+      entry = &m_shaders
+                   .emplace(hash, Entry{
+                                      .shader = Shader{.hash = hash},
+                                      .file = std::move(file),
+                                  })
+                   ->second;
+    }
+
+    // Module creation is thread-safe on a shared device; only the map
+    // updates are serialised.
+    Shader &shader = entry->shader;
+    try {
+      shader.reflection = reflect_spirv(code);
+      shader.module =
+          m_context.device().createShaderModule(vk::ShaderModuleCreateInfo{
+              .codeSize = code.size_bytes(),
+              .pCode = code.data(),
+          });
+    } catch (...) {
+      {
+        std::lock_guard lock(m_mutex);
+        auto [begin, end] = m_shaders.equal_range(hash);
+        m_shaders.erase(
+            std::find_if(begin, end, [entry](const auto &candidate) {
+              return &candidate.second == entry;
+            }));
+      }
+      m_created.notify_all();
+      throw;
+    }
+
+    {
+      std::lock_guard lock(m_mutex);
+      m_stats.modules++;
+      entry->ready = true;
+      m_paths.emplace(path, &shader);
+    }
+    m_created.notify_all();
+    return {};
+  } catch (std::exception &err) {
+    return fmt::format("Failed to load shader {0}: {1}", path, err.what());
+  }
+}
+
+void ShaderLibrary::log_stats() const {
+  std::lock_guard lock(m_mutex);
+  spdlog::info("Shader library: {0} files ({1} bytes mapped), {2} unique "
+               "modules, {3:.3f}ms loading",
+               m_stats.files, m_stats.mapped_bytes, m_stats.modules,
+               m_stats.load_ns / 1e6);
+}
+} // namespace bs::engine::renderer
@@ -0,0 +1,552 @@
+#include <engine/renderer/shader_reflection.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fmt/format.h>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace bs::engine::renderer {
+namespace {
+// The handful of SPIR-V enums reflection needs, from the unified1 grammar.
+constexpr uint32_t spirv_magic = 0x07230203;
+constexpr uint32_t spirv_header_words = 5;
+// How deeply types may nest; valid SPIR-V can't refer to itself, so
+// anything deeper is a cycle.
+constexpr uint32_t max_type_depth = 64;
+
+enum Op : uint32_t {
+  op_entry_point = 15,
+  op_type_bool = 20,
+  op_type_int = 21,
+  op_type_float = 22,
+  op_type_vector = 23,
+  op_type_matrix = 24,
+  op_type_image = 25,
+  op_type_sampler = 26,
+  op_type_sampled_image = 27,
+  op_type_array = 28,
+  op_type_runtime_array = 29,
+  op_type_struct = 30,
+  op_type_pointer = 32,
+  op_constant = 43,
+  op_variable = 59,
+  op_decorate = 71,
+  op_member_decorate = 72,
+  op_type_acceleration_structure = 5341,
+};
+
+enum Decoration : uint32_t {
+  decoration_block = 2,
+  decoration_buffer_block = 3,
+  decoration_array_stride = 6,
+  decoration_matrix_stride = 7,
+  decoration_built_in = 11,
+  decoration_location = 30,
+  decoration_binding = 33,
+  decoration_descriptor_set = 34,
+  decoration_offset = 35,
+};
+
+enum StorageClass : uint32_t {
+  storage_uniform_constant = 0,
+  storage_input = 1,
+  storage_uniform = 2,
+  storage_push_constant = 9,
+  storage_storage_buffer = 12,
+};
+
+constexpr uint32_t dim_buffer = 5;
+constexpr uint32_t dim_subpass_data = 6;
+constexpr uint32_t image_sampled = 1;
+
+struct Type {
+  uint32_t op = 0;
+  // Operands after the result id, e.g. {component type, count} for vectors.
+  std::vector<uint32_t> operands;
+};
+
+// The operands reflection reads from each type; the parser rejects types
+// with fewer, so lookups by op never index past the end.
+uint32_t required_operands(uint32_t op) {
+  switch (op) {
+  case op_type_float:
+  case op_type_sampled_image:
+  case op_type_runtime_array:
+    return 1;
+  case op_type_int:
+  case op_type_vector:
+  case op_type_matrix:
+  case op_type_array:
+  case op_type_pointer:
+    return 2;
+  case op_type_image:
+    return 7;
+  default:
+    return 0;
+  }
+}
+
+struct Decorations {
+  uint32_t set = 0;
+  uint32_t binding = 0;
+  uint32_t location = 0;
+  uint32_t array_stride = 0;
+  bool has_binding = false;
+  bool has_location = false;
+  bool built_in = false;
+  bool block = false;
+  bool buffer_block = false;
+};
+
+struct MemberDecorations {
+  uint32_t offset = 0;
+  uint32_t matrix_stride = 0;
+};
+
+struct Variable {
+  uint32_t id;
+  uint32_t pointer_type;
+  uint32_t storage_class;
+};
+
+class Parser {
+public:
+  Parser(std::span<const uint32_t> code) : m_code(code) {}
+
+  ShaderReflection reflect();
+
+private:
+  void parse();
+  vk::ShaderStageFlagBits stage(uint32_t execution_model) const;
+  // Throws unless id names a type with this op.
+  const Type &expect_type(uint32_t id, uint32_t op) const;
+  uint32_t constant(uint32_t id) const;
+  // Throws past max_type_depth levels of nesting.
+  uint32_t type_size(uint32_t type_id, uint32_t depth = 0) const;
+  vk::Format vertex_format(uint32_t type_id) const;
+  void add_binding(ShaderReflection &reflection, const Variable &variable);
+
+  std::span<const uint32_t> m_code;
+  uint32_t m_execution_model = 0;
+  std::string m_entry_point;
+  std::unordered_map<uint32_t, Type> m_types;
+  std::unordered_map<uint32_t, uint32_t> m_constants;
+  std::unordered_map<uint32_t, Decorations> m_decorations;
+  std::unordered_map<uint64_t, MemberDecorations> m_member_decorations;
+  std::vector<Variable> m_variables;
+};
+
+uint64_t member_key(uint32_t type_id, uint32_t member) {
+  return (static_cast<uint64_t>(type_id) << 32) | member;
+}
+
+void Parser::parse() {
+  if (m_code.size() < spirv_header_words || m_code[0] != spirv_magic)
+    throw std::runtime_error("Not a SPIR-V module");
+
+  bool found_entry_point = false;
+  size_t offset = spirv_header_words;
+  while (offset < m_code.size()) {
+    const uint32_t word_count = m_code[offset] >> 16;
+    const uint32_t opcode = m_code[offset] & 0xffff;
+    if (word_count == 0 || offset + word_count > m_code.size())
+      throw std::runtime_error("Truncated SPIR-V instruction");
+    const uint32_t *words = m_code.data() + offset;
+
+    switch (opcode) {
+    case op_entry_point:
+      if (!found_entry_point && word_count >= 4) {
+        found_entry_point = true;
+        m_execution_model = words[1];
+        // Literal string, nul-terminated and padded to a word boundary.
+        const char *name = reinterpret_cast<const char *>(words + 3);
+        m_entry_point.assign(
+            name, strnlen(name, (word_count - 3) * sizeof(uint32_t)));
+      }
+      break;
+    case op_type_bool:
+    case op_type_int:
+    case op_type_float:
+    case op_type_vector:
+    case op_type_matrix:
+    case op_type_image:
+    case op_type_sampler:
+    case op_type_sampled_image:
+    case op_type_array:
+    case op_type_runtime_array:
+    case op_type_struct:
+    case op_type_pointer:
+    case op_type_acceleration_structure:
+      if (word_count < 2)
+        break;
+      if (word_count - 2 < required_operands(opcode))
+        throw std::runtime_error(
+            fmt::format("SPIR-V type {0} is missing operands", words[1]));
+      m_types[words[1]] =
+          Type{opcode, std::vector<uint32_t>(words + 2, words + word_count)};
+      break;
+    case op_constant:
+      if (word_count >= 4)
+        m_constants[words[2]] = words[3];
+      break;
+    case op_variable:
+      if (word_count >= 4)
+        m_variables.push_back(Variable{words[2], words[1], words[3]});
+      break;
+    case op_decorate: {
+      if (word_count < 3)
+        break;
+      Decorations &decorations = m_decorations[words[1]];
+      const uint32_t literal = word_count >= 4 ? words[3] : 0;
+      switch (words[2]) {
+      case decoration_block:
+        decorations.block = true;
+        break;
+      case decoration_buffer_block:
+        decorations.buffer_block = true;
+        break;
+      case decoration_array_stride:
+        decorations.array_stride = literal;
+        break;
+      case decoration_built_in:
+        decorations.built_in = true;
+        break;
+      case decoration_location:
+        decorations.location = literal;
+        decorations.has_location = true;
+        break;
+      case decoration_binding:
+        decorations.binding = literal;
+        decorations.has_binding = true;
+        break;
+      case decoration_descriptor_set:
+        decorations.set = literal;
+        break;
+      }
+      break;
+    }
+    case op_member_decorate: {
+      if (word_count < 5)
+        break;
+      MemberDecorations &decorations =
+          m_member_decorations[member_key(words[1], words[2])];
+      if (words[3] == decoration_offset)
+        decorations.offset = words[4];
+      else if (words[3] == decoration_matrix_stride)
+        decorations.matrix_stride = words[4];
+      break;
+    }
+    }
+    offset += word_count;
+  }
+
+  if (!found_entry_point)
+    throw std::runtime_error("SPIR-V module has no entry point");
+}
+
+vk::ShaderStageFlagBits Parser::stage(uint32_t execution_model) const {
+  switch (execution_model) {
+  case 0:
+    return vk::ShaderStageFlagBits::eVertex;
+  case 1:
+    return vk::ShaderStageFlagBits::eTessellationControl;
+  case 2:
+    return vk::ShaderStageFlagBits::eTessellationEvaluation;
+  case 3:
+    return vk::ShaderStageFlagBits::eGeometry;
+  case 4:
+    return vk::ShaderStageFlagBits::eFragment;
+  case 5:
+    return vk::ShaderStageFlagBits::eCompute;
+  case 5364:
+    return vk::ShaderStageFlagBits::eTaskEXT;
+  case 5365:
+    return vk::ShaderStageFlagBits::eMeshEXT;
+  default:
+    throw std::runtime_error(
+        fmt::format("Unsupported SPIR-V execution model {0}", execution_model));
+  }
+}
+
+const Type &Parser::expect_type(uint32_t id, uint32_t op) const {
+  auto it = m_types.find(id);
+  if (it == m_types.end() || it->second.op != op)
+    throw std::runtime_error(
+        fmt::format("SPIR-V id {0} is not the type its user expects", id));
+  return it->second;
+}
+
+uint32_t Parser::constant(uint32_t id) const {
+  auto it = m_constants.find(id);
+  // Specialization-constant sized arrays fall back to one element.
+  return it != m_constants.end() ? it->second : 1;
+}
+
+uint32_t Parser::type_size(uint32_t type_id, uint32_t depth) const {
+  if (depth > max_type_depth)
+    throw std::runtime_error("SPIR-V types nest too deeply");
+  auto it = m_types.find(type_id);
+  if (it == m_types.end())
+    return 0;
+  const Type &type = it->second;
+  switch (type.op) {
+  case op_type_bool:
+    return 4;
+  case op_type_int:
+  case op_type_float:
+    return type.operands[0] / 8;
+  case op_type_vector:
+    return type.operands[1] * type_size(type.operands[0], depth + 1);
+  case op_type_matrix:
+    return type.operands[1] * type_size(type.operands[0], depth + 1);
+  case op_type_array: {
+    auto decorations = m_decorations.find(type_id);
+    const uint32_t stride =
+        decorations != m_decorations.end() &&
+                decorations->second.array_stride != 0
+            ? decorations->second.array_stride
+            : type_size(type.operands[0], depth + 1);
+    return stride * constant(type.operands[1]);
+  }
+  case op_type_struct: {
+    uint32_t size = 0;
+    for (uint32_t member = 0; member < type.operands.size(); member++) {
+      auto decorations =
+          m_member_decorations.find(member_key(type_id, member));
+      const uint32_t offset = decorations != m_member_decorations.end()
+                                  ? decorations->second.offset
+                                  : size;
+      uint32_t member_size = type_size(type.operands[member], depth + 1);
+      auto member_type = m_types.find(type.operands[member]);
+      if (member_type != m_types.end() &&
+          member_type->second.op == op_type_matrix &&
+          decorations != m_member_decorations.end() &&
+          decorations->second.matrix_stride != 0) {
+        member_size =
+            member_type->second.operands[1] * decorations->second.matrix_stride;
+      }
+      size = std::max(size, offset + member_size);
+    }
+    return size;
+  }
+  default:
+    return 0;
+  }
+}
+
+vk::Format Parser::vertex_format(uint32_t type_id) const {
+  auto it = m_types.find(type_id);
+  if (it == m_types.end())
+    return vk::Format::eUndefined;
+  uint32_t components = 1;
+  const Type *scalar = &it->second;
+  if (scalar->op == op_type_vector) {
+    components = scalar->operands[1];
+    auto component = m_types.find(scalar->operands[0]);
+    if (component == m_types.end())
+      return vk::Format::eUndefined;
+    scalar = &component->second;
+  }
+  if (components < 1 || components > 4 || scalar->operands.empty())
+    return vk::Format::eUndefined;
+
+  const uint32_t width = scalar->operands[0];
+  if (scalar->op == op_type_float && width == 32) {
+    constexpr vk::Format formats[] = {
+        vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat,
+        vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat};
+    return formats[components - 1];
+  }
+  if (scalar->op == op_type_float && width == 16) {
+    constexpr vk::Format formats[] = {
+        vk::Format::eR16Sfloat, vk::Format::eR16G16Sfloat,
+        vk::Format::eR16G16B16Sfloat, vk::Format::eR16G16B16A16Sfloat};
+    return formats[components - 1];
+  }
+  if (scalar->op == op_type_int && width == 32) {
+    const bool is_signed = scalar->operands[1] != 0;
+    constexpr vk::Format signed_formats[] = {
+        vk::Format::eR32Sint, vk::Format::eR32G32Sint,
+        vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint};
+    constexpr vk::Format unsigned_formats[] = {
+        vk::Format::eR32Uint, vk::Format::eR32G32Uint,
+        vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint};
+    return is_signed ? signed_formats[components - 1]
+                     : unsigned_formats[components - 1];
+  }
+  return vk::Format::eUndefined;
+}
+
+void Parser::add_binding(ShaderReflection &reflection,
+                         const Variable &variable) {
+  auto decorations = m_decorations.find(variable.id);
+  if (decorations == m_decorations.end() || !decorations->second.has_binding)
+    return;
+
+  const Type &pointer = expect_type(variable.pointer_type, op_type_pointer);
+  uint32_t type_id = pointer.operands[1];
+  uint32_t count = 1;
+  const Type *type = &m_types.at(type_id);
+  for (uint32_t depth = 0;
+       type->op == op_type_array || type->op == op_type_runtime_array;
+       depth++) {
+    if (depth > max_type_depth)
+      throw std::runtime_error("SPIR-V types nest too deeply");
+    count = type->op == op_type_array ? count * constant(type->operands[1]) : 0;
+    type_id = type->operands[0];
+    type = &m_types.at(type_id);
+  }
+
+  vk::DescriptorType descriptor_type;
+  if (variable.storage_class == storage_storage_buffer) {
+    descriptor_type = vk::DescriptorType::eStorageBuffer;
+  } else if (variable.storage_class == storage_uniform) {
+    auto type_decorations = m_decorations.find(type_id);
+    descriptor_type = type_decorations != m_decorations.end() &&
+                              type_decorations->second.buffer_block
+                          ? vk::DescriptorType::eStorageBuffer
+                          : vk::DescriptorType::eUniformBuffer;
+  } else {
+    switch (type->op) {
+    case op_type_sampler:
+      descriptor_type = vk::DescriptorType::eSampler;
+      break;
+    case op_type_sampled_image: {
+      const Type &image = expect_type(type->operands[0], op_type_image);
+      descriptor_type = image.operands[1] == dim_buffer
+                            ? vk::DescriptorType::eUniformTexelBuffer
+                            : vk::DescriptorType::eCombinedImageSampler;
+      break;
+    }
+    case op_type_image: {
+      const uint32_t dim = type->operands[1];
+      const bool sampled = type->operands[5] == image_sampled;
+      if (dim == dim_subpass_data)
+        descriptor_type = vk::DescriptorType::eInputAttachment;
+      else if (dim == dim_buffer)
+        descriptor_type = sampled ? vk::DescriptorType::eUniformTexelBuffer
+                                  : vk::DescriptorType::eStorageTexelBuffer;
+      else
+        descriptor_type = sampled ? vk::DescriptorType::eSampledImage
+                                  : vk::DescriptorType::eStorageImage;
+      break;
+    }
+    case op_type_acceleration_structure:
+      descriptor_type = vk::DescriptorType::eAccelerationStructureKHR;
+      break;
+    default:
+      return;
+    }
+  }
+
+  reflection.bindings.push_back(DescriptorBinding{
+      .set = decorations->second.set,
+      .binding = decorations->second.binding,
+      .type = descriptor_type,
+      .count = count,
+      .stages = reflection.stage,
+  });
+}
+
+ShaderReflection Parser::reflect() {
+  parse();
+
+  ShaderReflection reflection;
+  reflection.stage = stage(m_execution_model);
+  reflection.entry_point = m_entry_point;
+
+  for (const Variable &variable : m_variables) {
+    switch (variable.storage_class) {
+    case storage_uniform_constant:
+    case storage_uniform:
+    case storage_storage_buffer:
+      add_binding(reflection, variable);
+      break;
+    case storage_push_constant: {
+      const Type &pointer = expect_type(variable.pointer_type, op_type_pointer);
+      const uint32_t type_id = pointer.operands[1];
+      // Members before the first used offset belong to other stages.
+      uint32_t begin = UINT32_MAX;
+      const Type &block = m_types.at(type_id);
+      for (uint32_t member = 0; member < block.operands.size(); member++) {
+        auto decorations =
+            m_member_decorations.find(member_key(type_id, member));
+        begin = std::min(begin, decorations != m_member_decorations.end()
+                                    ? decorations->second.offset
+                                    : 0u);
+      }
+      if (begin == UINT32_MAX)
+        begin = 0;
+      reflection.push_constant_ranges.push_back(vk::PushConstantRange{
+          .stageFlags = reflection.stage,
+          .offset = begin,
+          .size = type_size(type_id) - begin,
+      });
+      break;
+    }
+    case storage_input: {
+      if (reflection.stage != vk::ShaderStageFlagBits::eVertex)
+        break;
+      auto decorations = m_decorations.find(variable.id);
+      if (decorations == m_decorations.end() ||
+          decorations->second.built_in || !decorations->second.has_location)
+        break;
+      const Type &pointer = expect_type(variable.pointer_type, op_type_pointer);
+      reflection.vertex_inputs.push_back(VertexInput{
+          .location = decorations->second.location,
+          .format = vertex_format(pointer.operands[1]),
+      });
+      break;
+    }
+    }
+  }
+
+  std::sort(reflection.bindings.begin(), reflection.bindings.end(),
+            [](const DescriptorBinding &a, const DescriptorBinding &b) {
+              return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+            });
+  std::sort(reflection.vertex_inputs.begin(), reflection.vertex_inputs.end(),
+            [](const VertexInput &a, const VertexInput &b) {
+              return a.location < b.location;
+            });
+  return reflection;
+}
+} // namespace
+
+ShaderReflection reflect_spirv(std::span<const uint32_t> code) {
+  try {
+    return Parser(code).reflect();
+  } catch (std::out_of_range &) {
+    throw std::runtime_error("SPIR-V module references an undefined type");
+  }
+}
+
+std::vector<DescriptorBinding>
+merge_bindings(std::span<const ShaderReflection *const> reflections) {
+  std::vector<DescriptorBinding> merged;
+  for (const ShaderReflection *reflection : reflections) {
+    for (const DescriptorBinding &binding : reflection->bindings) {
+      auto it = std::find_if(merged.begin(), merged.end(),
+                             [&](const DescriptorBinding &other) {
+                               return other.set == binding.set &&
+                                      other.binding == binding.binding;
+                             });
+      if (it == merged.end()) {
+        merged.push_back(binding);
+        continue;
+      }
+      if (it->type != binding.type)
+        throw std::runtime_error(fmt::format(
+            "Descriptor set {0} binding {1} has conflicting types",
+            binding.set, binding.binding));
+      it->stages |= binding.stages;
+    }
+  }
+  std::sort(merged.begin(), merged.end(),
+            [](const DescriptorBinding &a, const DescriptorBinding &b) {
+              return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+            });
+  return merged;
+}
+} // namespace bs::engine::renderer
@@ -0,0 +1,64 @@
+#include <engine/renderer/thread_command_pools.hpp>
+
+namespace bs::engine::renderer {
+ThreadCommandPools::ThreadCommandPools(context::Context &context,
+                                       jobs::JobSystem &job_system,
+                                       uint32_t frames_in_flight)
+    : m_context(context), m_job_system(job_system) {
+  m_pools.resize(frames_in_flight * m_job_system.thread_count());
+  for (ThreadPool &pool : m_pools) {
+    pool.pool = m_context.device().createCommandPool(vk::CommandPoolCreateInfo{
+        .flags = vk::CommandPoolCreateFlagBits::eTransient,
+        .queueFamilyIndex = m_context.graphics_queue_family(),
+    });
+  }
+}
+
+ThreadCommandPools::~ThreadCommandPools() {
+  // Destroying a pool frees its command buffers.
+  for (ThreadPool &pool : m_pools) {
+    m_context.device().destroyCommandPool(pool.pool);
+  }
+}
+
+void ThreadCommandPools::begin_frame(uint32_t frame_index) {
+  m_frame_index = frame_index;
+  const uint32_t thread_count = m_job_system.thread_count();
+  for (uint32_t thread = 0; thread < thread_count; thread++) {
+    ThreadPool &pool = m_pools[frame_index * thread_count + thread];
+    if (pool.used == 0)
+      continue;
+    m_context.device().resetCommandPool(pool.pool);
+    pool.used = 0;
+  }
+}
+
+vk::CommandBuffer ThreadCommandPools::begin(
+    const vk::CommandBufferInheritanceRenderingInfo &inheritance) {
+  const uint32_t thread = m_job_system.thread_index();
+  if (thread >= m_job_system.thread_count())
+    return {};
+  ThreadPool &pool =
+      m_pools[m_frame_index * m_job_system.thread_count() + thread];
+  if (pool.used == pool.command_buffers.size()) {
+    pool.command_buffers.push_back(
+        m_context.device()
+            .allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+                .commandPool = pool.pool,
+                .level = vk::CommandBufferLevel::eSecondary,
+                .commandBufferCount = 1,
+            })
+            .front());
+  }
+  const vk::CommandBuffer command_buffer = pool.command_buffers[pool.used++];
+  const vk::CommandBufferInheritanceInfo inheritance_info{
+      .pNext = &inheritance,
+  };
+  command_buffer.begin(vk::CommandBufferBeginInfo{
+      .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit |
+               vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+      .pInheritanceInfo = &inheritance_info,
+  });
+  return command_buffer;
+}
+} // namespace bs::engine::renderer
@@ -0,0 +1,294 @@
+#include <engine/renderer/uploader.hpp>
+
+#include <engine/profiler/profiler.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <tuple>
+
+namespace bs::engine::renderer {
+namespace {
+// Keeps every copy source suitably aligned for any texel or index format.
+constexpr vk::DeviceSize copy_alignment = 16;
+
+vk::DeviceSize align_up(vk::DeviceSize value, vk::DeviceSize alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+} // namespace
+
+Uploader::Uploader(context::Context &context,
+                   const UploaderCreateInfo &create_info)
+    : m_context(context),
+      m_staging_size(align_up(create_info.staging_size, copy_alignment)) {
+  vma::AllocationInfo allocation_info;
+  std::tie(m_staging_buffer, m_staging_allocation) =
+      m_context.allocator().createBuffer(
+          vk::BufferCreateInfo{
+              .size = m_staging_size,
+              .usage = vk::BufferUsageFlagBits::eTransferSrc,
+          },
+          vma::AllocationCreateInfo{
+              .flags =
+                  vma::AllocationCreateFlagBits::eHostAccessSequentialWrite |
+                  vma::AllocationCreateFlagBits::eMapped,
+              .usage = vma::MemoryUsage::eAutoPreferHost,
+          },
+          &allocation_info);
+  m_staging_mapped = static_cast<uint8_t *>(allocation_info.pMappedData);
+
+  m_timeline = m_context.device().createSemaphore(
+      vk::StructureChain<vk::SemaphoreCreateInfo,
+                         vk::SemaphoreTypeCreateInfo>(
+          vk::SemaphoreCreateInfo{},
+          vk::SemaphoreTypeCreateInfo{
+              .semaphoreType = vk::SemaphoreType::eTimeline,
+              .initialValue = 0,
+          })
+          .get());
+}
+Uploader::~Uploader() {
+  flush();
+  wait(m_submitted_value);
+  for (auto &batch : m_in_flight) {
+    m_context.device().destroyCommandPool(batch.command_pool);
+  }
+  for (auto &batch : m_free_batches) {
+    m_context.device().destroyCommandPool(batch.command_pool);
+  }
+  m_context.device().destroySemaphore(m_timeline);
+  m_context.allocator().destroyBuffer(m_staging_buffer, m_staging_allocation);
+}
+
+vk::SharingMode Uploader::sharing_mode() const {
+  return m_context.graphics_queue_family() ==
+                 m_context.transfer_queue_family()
+             ? vk::SharingMode::eExclusive
+             : vk::SharingMode::eConcurrent;
+}
+
+std::vector<uint32_t> Uploader::queue_families() const {
+  if (sharing_mode() == vk::SharingMode::eExclusive)
+    return {};
+  return {m_context.graphics_queue_family(),
+          m_context.transfer_queue_family()};
+}
+
+uint64_t Uploader::upload(vk::Buffer buffer, vk::DeviceSize offset,
+                          const void *data, vk::DeviceSize size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  return upload(buffer, offset, size,
+                [bytes](void *destination, vk::DeviceSize offset,
+                        vk::DeviceSize size) {
+                  std::memcpy(destination, bytes + offset, size);
+                });
+}
+
+uint64_t Uploader::upload(vk::Buffer buffer, vk::DeviceSize offset,
+                          vk::DeviceSize size, const Writer &write) {
+  std::unique_lock lock(m_mutex);
+  // Chunks of a quarter ring keep one huge upload from draining
+  // everything else in flight.
+  const vk::DeviceSize max_chunk = (m_staging_size / 4) & ~(copy_alignment - 1);
+  for (vk::DeviceSize done = 0; done < size;) {
+    const vk::DeviceSize chunk = std::min(size - done, max_chunk);
+    const vk::DeviceSize staging_offset = reserve(lock, chunk);
+    write(m_staging_mapped + staging_offset, done, chunk);
+    m_pending.push_back(Copy{
+        .buffer = buffer,
+        .region =
+            vk::BufferCopy{
+                .srcOffset = staging_offset,
+                .dstOffset = offset + done,
+                .size = chunk,
+            },
+    });
+    done += chunk;
+  }
+  m_stats.bytes += size;
+  // The copy goes out with the next flush, whichever thread calls it.
+  return m_submitted_value + 1;
+}
+
+types::BufferHandle Uploader::create_buffer(vk::DeviceSize size,
+                                            vk::BufferUsageFlags usage) {
+  const std::vector<uint32_t> families = queue_families();
+  return m_context.create_buffer(
+      vk::BufferCreateInfo{
+          .size = size,
+          .usage = usage | vk::BufferUsageFlagBits::eTransferDst,
+          .sharingMode = sharing_mode(),
+          .queueFamilyIndexCount = static_cast<uint32_t>(families.size()),
+          .pQueueFamilyIndices = families.data(),
+      },
+      vma::AllocationCreateInfo{
+          .usage = vma::MemoryUsage::eAutoPreferDevice,
+      });
+}
+
+vk::DeviceSize Uploader::reserve(std::unique_lock<std::mutex> &lock,
+                                 vk::DeviceSize size) {
+  size = align_up(size, copy_alignment);
+  for (;;) {
+    uint64_t head = m_ring_head;
+    const vk::DeviceSize offset = head % m_staging_size;
+    // Allocations never wrap; the bytes skipped at the end of the ring are
+    // released with the batch that skipped them.
+    if (offset + size > m_staging_size)
+      head += m_staging_size - offset;
+    if (head + size - m_ring_tail <= m_staging_size) {
+      m_ring_head = head + size;
+      return head % m_staging_size;
+    }
+
+    retire_batches();
+    if (head + size - m_ring_tail <= m_staging_size)
+      continue;
+    // The ring is full of copies nobody has flushed yet.
+    if (m_in_flight.empty())
+      flush_locked();
+
+    m_stats.stalls++;
+    const uint64_t value = m_in_flight.front().value;
+    lock.unlock();
+    wait(value);
+    lock.lock();
+  }
+}
+
+uint64_t Uploader::flush() {
+  std::lock_guard lock(m_mutex);
+  return flush_locked();
+}
+
+uint64_t Uploader::flush_locked() {
+  retire_batches();
+  if (m_pending.empty())
+    return m_submitted_value;
+  BS_PROFILE_ZONE("Uploader::flush");
+
+  // One vkCmdCopyBuffer per destination buffer.
+  std::stable_sort(m_pending.begin(), m_pending.end(),
+                   [](const Copy &a, const Copy &b) {
+                     return std::less<VkBuffer>{}(a.buffer, b.buffer);
+                   });
+  Batch batch = acquire_batch();
+  batch.command_buffer.begin(vk::CommandBufferBeginInfo{
+      .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+  });
+  std::vector<vk::BufferCopy> regions;
+  for (size_t i = 0; i < m_pending.size();) {
+    const vk::Buffer buffer = m_pending[i].buffer;
+    regions.clear();
+    for (; i < m_pending.size() && m_pending[i].buffer == buffer; i++) {
+      regions.push_back(m_pending[i].region);
+    }
+    batch.command_buffer.copyBuffer(m_staging_buffer, buffer, regions);
+  }
+  batch.command_buffer.end();
+
+  batch.value = ++m_submitted_value;
+  batch.ring_end = m_ring_head;
+  const vk::CommandBufferSubmitInfo command_buffer_info{
+      .commandBuffer = batch.command_buffer,
+  };
+  const vk::SemaphoreSubmitInfo signal_info{
+      .semaphore = m_timeline,
+      .value = batch.value,
+      .stageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+  };
+  {
+    std::lock_guard queue_lock(m_context.transfer_queue_mutex());
+    m_context.transfer_queue().submit2(vk::SubmitInfo2{
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &command_buffer_info,
+        .signalSemaphoreInfoCount = 1,
+        .pSignalSemaphoreInfos = &signal_info,
+    });
+  }
+
+  m_stats.copies += static_cast<uint32_t>(m_pending.size());
+  m_stats.batches++;
+  m_pending.clear();
+  m_in_flight.push_back(batch);
+  return batch.value;
+}
+
+void Uploader::retire_batches() {
+  if (m_in_flight.empty())
+    return;
+  const uint64_t completed = poll_completed_value();
+  while (!m_in_flight.empty() && m_in_flight.front().value <= completed) {
+    m_ring_tail = m_in_flight.front().ring_end;
+    m_free_batches.push_back(m_in_flight.front());
+    m_in_flight.pop_front();
+  }
+}
+
+Uploader::Batch Uploader::acquire_batch() {
+  if (!m_free_batches.empty()) {
+    Batch batch = m_free_batches.back();
+    m_free_batches.pop_back();
+    m_context.device().resetCommandPool(batch.command_pool);
+    return batch;
+  }
+  Batch batch;
+  batch.command_pool =
+      m_context.device().createCommandPool(vk::CommandPoolCreateInfo{
+          .flags = vk::CommandPoolCreateFlagBits::eTransient,
+          .queueFamilyIndex = m_context.transfer_queue_family(),
+      });
+  batch.command_buffer =
+      m_context.device()
+          .allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+              .commandPool = batch.command_pool,
+              .level = vk::CommandBufferLevel::ePrimary,
+              .commandBufferCount = 1,
+          })
+          .front();
+  return batch;
+}
+
+uint64_t Uploader::poll_completed_value() {
+  const uint64_t completed =
+      m_context.device().getSemaphoreCounterValue(m_timeline);
+  uint64_t previous = completed_value();
+  while (previous < completed &&
+         !m_completed_value.compare_exchange_weak(previous, completed)) {
+  }
+  return std::max(previous, completed);
+}
+
+bool Uploader::is_complete(uint64_t value) {
+  return value <= completed_value() || value <= poll_completed_value();
+}
+
+void Uploader::wait(uint64_t value) {
+  if (value == 0 || is_complete(value))
+    return;
+  {
+    // Waiting on a value nobody has submitted yet would never return.
+    std::lock_guard lock(m_mutex);
+    if (value > m_submitted_value)
+      flush_locked();
+  }
+  BS_PROFILE_ZONE("Uploader::wait");
+  const vk::Result result = m_context.device().waitSemaphores(
+      vk::SemaphoreWaitInfo{
+          .semaphoreCount = 1,
+          .pSemaphores = &m_timeline,
+          .pValues = &value,
+      },
+      UINT64_MAX);
+  if (result != vk::Result::eSuccess)
+    throw std::runtime_error("Failed to wait for uploads");
+  poll_completed_value();
+}
+
+UploaderStats Uploader::stats() {
+  std::lock_guard lock(m_mutex);
+  return m_stats;
+}
+} // namespace bs::engine::renderer
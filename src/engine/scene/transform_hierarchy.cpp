@@ -0,0 +1,362 @@
+#include <engine/scene/transform_hierarchy.hpp>
+
+#include <cassert>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BS_SCENE_X86
+#include <immintrin.h>
+#endif
+
+namespace bs::engine::scene {
+namespace {
+constexpr uint32_t root_parent = UINT32_MAX;
+
+// What the kernels read and write, indexed by slot.
+struct ComposeArrays {
+  const uint32_t *parent_slot;
+  const glm::mat4 *local;
+  const glm::vec4 *bounds;
+  glm::mat4 *world;
+  culling::SphereSoA *world_spheres;
+};
+
+void compose_scalar(const ComposeArrays &arrays,
+                    std::span<const uint32_t> slots) {
+  for (uint32_t slot : slots) {
+    const uint32_t parent = arrays.parent_slot[slot];
+    const glm::mat4 world = parent == root_parent
+                                ? arrays.local[slot]
+                                : arrays.world[parent] * arrays.local[slot];
+    arrays.world[slot] = world;
+    const glm::vec4 &bounds = arrays.bounds[slot];
+    if (bounds.w < 0.f) {
+      arrays.world_spheres->set(slot, glm::vec3(0.f), bounds.w);
+      continue;
+    }
+    const glm::vec4 sphere = culling::transform_sphere(world, bounds);
+    arrays.world_spheres->set(slot, glm::vec3(sphere), sphere.w);
+  }
+}
+
+#ifdef BS_SCENE_X86
+// Same math as compose_scalar, with each column of the product in one
+// register; the sums are in glm's order, so results match it.
+void compose_sse2(const ComposeArrays &arrays,
+                  std::span<const uint32_t> slots) {
+  for (uint32_t slot : slots) {
+    const float *local = &arrays.local[slot][0][0];
+    __m128 columns[4];
+    const uint32_t parent = arrays.parent_slot[slot];
+    if (parent == root_parent) {
+      for (int j = 0; j < 4; j++) {
+        columns[j] = _mm_loadu_ps(local + 4 * j);
+      }
+    } else {
+      const float *parent_world = &arrays.world[parent][0][0];
+      const __m128 p0 = _mm_loadu_ps(parent_world);
+      const __m128 p1 = _mm_loadu_ps(parent_world + 4);
+      const __m128 p2 = _mm_loadu_ps(parent_world + 8);
+      const __m128 p3 = _mm_loadu_ps(parent_world + 12);
+      for (int j = 0; j < 4; j++) {
+        const float *column = local + 4 * j;
+        columns[j] = _mm_add_ps(
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(column[0])),
+                                  _mm_mul_ps(p1, _mm_set1_ps(column[1]))),
+                       _mm_mul_ps(p2, _mm_set1_ps(column[2]))),
+            _mm_mul_ps(p3, _mm_set1_ps(column[3])));
+      }
+    }
+    float *world = &arrays.world[slot][0][0];
+    for (int j = 0; j < 4; j++) {
+      _mm_storeu_ps(world + 4 * j, columns[j]);
+    }
+
+    const glm::vec4 &bounds = arrays.bounds[slot];
+    if (bounds.w < 0.f) {
+      arrays.world_spheres->set(slot, glm::vec3(0.f), bounds.w);
+      continue;
+    }
+    const __m128 center = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[0], _mm_set1_ps(bounds.x)),
+                              _mm_mul_ps(columns[1], _mm_set1_ps(bounds.y))),
+                   _mm_mul_ps(columns[2], _mm_set1_ps(bounds.z))),
+        columns[3]);
+    // Transposing the squared columns leaves lane j of the row sums holding
+    // the squared length of column j.
+    __m128 x = _mm_mul_ps(columns[0], columns[0]);
+    __m128 y = _mm_mul_ps(columns[1], columns[1]);
+    __m128 z = _mm_mul_ps(columns[2], columns[2]);
+    __m128 w = _mm_mul_ps(columns[3], columns[3]);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    const __m128 lengths = _mm_add_ps(_mm_add_ps(x, y), z);
+    const __m128 longest = _mm_max_ss(
+        _mm_max_ss(lengths, _mm_shuffle_ps(lengths, lengths, 1)),
+        _mm_shuffle_ps(lengths, lengths, 2));
+    alignas(16) float center_out[4];
+    _mm_store_ps(center_out, center);
+    arrays.world_spheres->set(
+        slot, glm::vec3(center_out[0], center_out[1], center_out[2]),
+        bounds.w * _mm_cvtss_f32(_mm_sqrt_ss(longest)));
+  }
+}
+#endif
+
+void compose(TransformKernel kernel, const ComposeArrays &arrays,
+             std::span<const uint32_t> slots) {
+  switch (kernel) {
+#ifdef BS_SCENE_X86
+  case TransformKernel::eSse2:
+    compose_sse2(arrays, slots);
+    return;
+#endif
+  default:
+    compose_scalar(arrays, slots);
+    return;
+  }
+}
+} // namespace
+
+TransformKernel best_transform_kernel() {
+#ifdef BS_SCENE_X86
+  return TransformKernel::eSse2;
+#else
+  return TransformKernel::eScalar;
+#endif
+}
+
+const char *transform_kernel_name(TransformKernel kernel) {
+  switch (kernel) {
+  case TransformKernel::eScalar:
+    return "scalar";
+  case TransformKernel::eSse2:
+    return "sse2";
+  }
+  return "unknown";
+}
+
+TransformHierarchy::Handle TransformHierarchy::create(Handle parent,
+                                                      const glm::mat4 &local,
+                                                      const glm::vec4 &bounds) {
+  const uint32_t slot = static_cast<uint32_t>(m_local.size());
+  const Handle node = m_nodes.create(TransformNode{.slot = slot});
+  m_handles.push_back(node);
+  m_parent_slot.push_back(root_parent);
+  m_first_child_slot.push_back(0);
+  m_child_count.push_back(0);
+  m_depth.push_back(0);
+  m_local.push_back(local);
+  m_world.push_back(local);
+  m_bounds.push_back(bounds);
+  m_dirty.push_back(1);
+  link(node, parent);
+  m_structure_changed = true;
+  return node;
+}
+
+void TransformHierarchy::destroy(Handle node) {
+  unlink(node);
+  std::vector<Handle> stack{node};
+  while (!stack.empty()) {
+    const Handle handle = stack.back();
+    stack.pop_back();
+    const TransformNode &entry = *m_nodes.get(handle);
+    for (Handle child = entry.first_child; child;
+         child = m_nodes.get(child)->next_sibling) {
+      stack.push_back(child);
+    }
+    m_handles[entry.slot] = {};
+    m_nodes.destroy(handle);
+  }
+  m_structure_changed = true;
+}
+
+void TransformHierarchy::set_parent(Handle node, Handle parent) {
+#ifndef NDEBUG
+  for (Handle ancestor = parent; ancestor;
+       ancestor = m_nodes.get(ancestor)->parent) {
+    assert(ancestor != node && "reparenting a node under itself");
+  }
+#endif
+  unlink(node);
+  link(node, parent);
+  mark_dirty(m_nodes.get(node)->slot);
+  m_structure_changed = true;
+}
+
+void TransformHierarchy::set_local(Handle node, const glm::mat4 &local) {
+  const uint32_t slot = m_nodes.get(node)->slot;
+  m_local[slot] = local;
+  mark_dirty(slot);
+}
+
+void TransformHierarchy::set_bounds(Handle node, const glm::vec4 &bounds) {
+  const uint32_t slot = m_nodes.get(node)->slot;
+  m_bounds[slot] = bounds;
+  mark_dirty(slot);
+}
+
+glm::vec4 TransformHierarchy::world_bounds(Handle node) const {
+  const uint32_t slot = m_nodes.get(node)->slot;
+  return glm::vec4(m_world_spheres.x()[slot], m_world_spheres.y()[slot],
+                   m_world_spheres.z()[slot], m_world_spheres.radius()[slot]);
+}
+
+void TransformHierarchy::mark_all_dirty() {
+  for (uint32_t slot = 0; slot < m_dirty.size(); slot++) {
+    if (m_handles[slot])
+      mark_dirty(slot);
+  }
+}
+
+void TransformHierarchy::link(Handle node, Handle parent) {
+  Handle &head = first_child(parent);
+  TransformNode &entry = *m_nodes.get(node);
+  entry.parent = parent;
+  entry.next_sibling = head;
+  head = node;
+}
+
+void TransformHierarchy::unlink(Handle node) {
+  TransformNode &entry = *m_nodes.get(node);
+  Handle *link = &first_child(entry.parent);
+  while (*link != node) {
+    link = &m_nodes.get(*link)->next_sibling;
+  }
+  *link = entry.next_sibling;
+  entry.parent = {};
+  entry.next_sibling = {};
+}
+
+void TransformHierarchy::mark_dirty(uint32_t slot) {
+  if (m_dirty[slot])
+    return;
+  m_dirty[slot] = 1;
+  // Until rebuild() the slot's depth may be stale; it requeues every dirty
+  // slot anyway.
+  if (!m_structure_changed)
+    m_queues[m_depth[slot]].push_back(slot);
+}
+
+void TransformHierarchy::rebuild() {
+  // Breadth-first order; each node's children are appended together, so
+  // they end up contiguous.
+  std::vector<Handle> order;
+  order.reserve(m_nodes.size());
+  std::vector<uint32_t> first_child_slot;
+  std::vector<uint32_t> child_count;
+  first_child_slot.reserve(m_nodes.size());
+  child_count.reserve(m_nodes.size());
+  std::vector<uint32_t> depth_begin{0};
+  for (Handle root = m_first_root; root;
+       root = m_nodes.get(root)->next_sibling) {
+    order.push_back(root);
+  }
+  for (uint32_t begin = 0; begin < order.size();) {
+    const uint32_t end = static_cast<uint32_t>(order.size());
+    depth_begin.push_back(end);
+    for (uint32_t i = begin; i < end; i++) {
+      first_child_slot.push_back(static_cast<uint32_t>(order.size()));
+      for (Handle child = m_nodes.get(order[i])->first_child; child;
+           child = m_nodes.get(child)->next_sibling) {
+        order.push_back(child);
+      }
+      child_count.push_back(static_cast<uint32_t>(order.size()) -
+                            first_child_slot.back());
+    }
+    begin = end;
+  }
+
+  const uint32_t count = static_cast<uint32_t>(order.size());
+  std::vector<uint32_t> parent_slot(count);
+  std::vector<uint32_t> depth(count);
+  std::vector<glm::mat4> local(count);
+  std::vector<glm::mat4> world(count);
+  std::vector<glm::vec4> bounds(count);
+  std::vector<uint8_t> dirty(count);
+  culling::SphereSoA world_spheres;
+  world_spheres.reserve(count);
+  for (uint32_t d = 0; d + 1 < depth_begin.size(); d++) {
+    for (uint32_t slot = depth_begin[d]; slot < depth_begin[d + 1]; slot++) {
+      TransformNode &entry = *m_nodes.get(order[slot]);
+      const uint32_t old = entry.slot;
+      // Parents come first, so theirs is already the new slot.
+      parent_slot[slot] =
+          entry.parent ? m_nodes.get(entry.parent)->slot : root_parent;
+      depth[slot] = d;
+      local[slot] = m_local[old];
+      world[slot] = m_world[old];
+      bounds[slot] = m_bounds[old];
+      dirty[slot] = m_dirty[old];
+      // Dirty nodes, including every created one, are recomputed before
+      // anything reads their sphere.
+      if (old < m_world_spheres.size() && !dirty[slot]) {
+        world_spheres.push_back(glm::vec3(m_world_spheres.x()[old],
+                                          m_world_spheres.y()[old],
+                                          m_world_spheres.z()[old]),
+                                m_world_spheres.radius()[old]);
+      } else {
+        world_spheres.push_back(glm::vec3(no_bounds), no_bounds.w);
+      }
+      entry.slot = slot;
+    }
+  }
+
+  m_handles = std::move(order);
+  m_parent_slot = std::move(parent_slot);
+  m_first_child_slot = std::move(first_child_slot);
+  m_child_count = std::move(child_count);
+  m_depth = std::move(depth);
+  m_local = std::move(local);
+  m_world = std::move(world);
+  m_bounds = std::move(bounds);
+  m_dirty = std::move(dirty);
+  m_world_spheres = std::move(world_spheres);
+  m_depth_begin = std::move(depth_begin);
+
+  m_queues.resize(depth_count());
+  for (std::vector<uint32_t> &queue : m_queues) {
+    queue.clear();
+  }
+  for (uint32_t slot = 0; slot < count; slot++) {
+    if (m_dirty[slot])
+      m_queues[m_depth[slot]].push_back(slot);
+  }
+  m_structure_changed = false;
+}
+
+uint32_t TransformHierarchy::update(TransformKernel kernel) {
+  if (m_structure_changed)
+    rebuild();
+
+  const ComposeArrays arrays{
+      .parent_slot = m_parent_slot.data(),
+      .local = m_local.data(),
+      .bounds = m_bounds.data(),
+      .world = m_world.data(),
+      .world_spheres = &m_world_spheres,
+  };
+  uint32_t updated = 0;
+  for (uint32_t d = 0; d < m_queues.size(); d++) {
+    std::vector<uint32_t> &queue = m_queues[d];
+    if (queue.empty())
+      continue;
+    compose(kernel, arrays, queue);
+    // Every child of a recomputed node has to follow it. Children already
+    // queued for their own change are skipped.
+    for (uint32_t slot : queue) {
+      m_dirty[slot] = 0;
+      const uint32_t end = m_first_child_slot[slot] + m_child_count[slot];
+      for (uint32_t child = m_first_child_slot[slot]; child < end; child++) {
+        if (m_dirty[child])
+          continue;
+        m_dirty[child] = 1;
+        m_queues[d + 1].push_back(child);
+      }
+    }
+    updated += static_cast<uint32_t>(queue.size());
+    queue.clear();
+  }
+  return updated;
+}
+} // namespace bs::engine::scene
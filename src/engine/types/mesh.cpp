@@ -1,6 +1,55 @@
 #include <engine/types/mesh.hpp>
 
+#include <cstddef>
+
 namespace bs::engine::types {
 Mesh::Mesh() {}
 Mesh::~Mesh() {}
+
+uint32_t vertex_stride(VertexFormat format) {
+  return format == VertexFormat::eQuantized ? sizeof(QuantizedVertex)
+                                            : sizeof(Vertex);
+}
+
+vk::VertexInputBindingDescription vertex_binding(VertexFormat format) {
+  return vk::VertexInputBindingDescription{
+      .binding = 0,
+      .stride = vertex_stride(format),
+      .inputRate = vk::VertexInputRate::eVertex,
+  };
+}
+
+std::vector<vk::VertexInputAttributeDescription>
+vertex_attributes(VertexFormat format) {
+  if (format == VertexFormat::eQuantized) {
+    return {
+        vk::VertexInputAttributeDescription{
+            .location = 0,
+            .binding = 0,
+            .format = vk::Format::eR16G16B16A16Unorm,
+            .offset = offsetof(QuantizedVertex, position),
+        },
+        vk::VertexInputAttributeDescription{
+            .location = 1,
+            .binding = 0,
+            .format = vk::Format::eR16G16Snorm,
+            .offset = offsetof(QuantizedVertex, normal),
+        },
+    };
+  }
+  return {
+      vk::VertexInputAttributeDescription{
+          .location = 0,
+          .binding = 0,
+          .format = vk::Format::eR32G32B32Sfloat,
+          .offset = offsetof(Vertex, position),
+      },
+      vk::VertexInputAttributeDescription{
+          .location = 1,
+          .binding = 0,
+          .format = vk::Format::eR32G32B32Sfloat,
+          .offset = offsetof(Vertex, normal),
+      },
+  };
+}
 } // namespace bs::engine::types
@@ -0,0 +1,275 @@
+#include <engine/types/mesh_asset.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <stdexcept>
+
+namespace bs::engine::types {
+namespace {
+uint64_t align_up(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+class AssetReader {
+public:
+  AssetReader(const std::string &path, std::span<const uint8_t> bytes)
+      : m_path(path), m_bytes(bytes) {}
+
+  template <typename T> const T &record(uint64_t offset) const {
+    return *reinterpret_cast<const T *>(range(offset, sizeof(T)).data());
+  }
+  // `count` elements of T; the blob must hold exactly that many.
+  template <typename T>
+  std::span<const T> array(const MeshAssetBlob &blob, uint64_t count) const {
+    if (blob.size != count * sizeof(T) || blob.offset % alignof(T) != 0)
+      fail("blob size or alignment doesn't match its element count");
+    const std::span<const uint8_t> bytes = range(blob.offset, blob.size);
+    return {reinterpret_cast<const T *>(bytes.data()), count};
+  }
+  std::span<const uint8_t> range(uint64_t offset, uint64_t size) const {
+    if (offset > m_bytes.size() || size > m_bytes.size() - offset)
+      fail("range past the end of the file");
+    return m_bytes.subspan(offset, size);
+  }
+  [[noreturn]] void fail(const char *reason) const {
+    throw std::runtime_error(
+        fmt::format("Invalid mesh asset {0}: {1}", m_path, reason));
+  }
+
+private:
+  const std::string &m_path;
+  std::span<const uint8_t> m_bytes;
+};
+
+template <typename Index>
+bool indices_in_range(std::span<const uint8_t> bytes, uint32_t vertex_count) {
+  const std::span<const Index> indices(
+      reinterpret_cast<const Index *>(bytes.data()),
+      bytes.size() / sizeof(Index));
+  return std::all_of(indices.begin(), indices.end(), [&](Index index) {
+    return index < vertex_count;
+  });
+}
+
+class AssetWriter {
+public:
+  explicit AssetWriter(const std::string &path)
+      : m_file(path, std::ios::binary | std::ios::trunc) {}
+
+  // Appends `size` bytes at the next aligned offset and returns their blob.
+  MeshAssetBlob write(const void *data, uint64_t size) {
+    pad_to(align_up(m_offset, mesh_asset_alignment));
+    const MeshAssetBlob blob{.offset = m_offset, .size = size};
+    m_file.write(static_cast<const char *>(data), size);
+    m_offset += size;
+    return blob;
+  }
+  template <typename T> MeshAssetBlob write(std::span<const T> data) {
+    return write(data.data(), data.size_bytes());
+  }
+  // Overwrites bytes written earlier.
+  void patch(uint64_t offset, const void *data, uint64_t size) {
+    m_file.seekp(offset);
+    m_file.write(static_cast<const char *>(data), size);
+    m_file.seekp(m_offset);
+  }
+  void pad_to(uint64_t offset) {
+    static constexpr char zeros[mesh_asset_alignment]{};
+    while (m_offset < offset) {
+      const uint64_t count =
+          std::min<uint64_t>(offset - m_offset, sizeof(zeros));
+      m_file.write(zeros, count);
+      m_offset += count;
+    }
+  }
+  uint64_t offset() const { return m_offset; }
+  bool finish() {
+    m_file.flush();
+    return m_file.good();
+  }
+
+private:
+  std::ofstream m_file;
+  uint64_t m_offset = 0;
+};
+
+MeshAssetEntry write_mesh(AssetWriter &writer, const MeshAssetSource &mesh) {
+  MeshAssetEntry entry{
+      .vertex_format = static_cast<uint32_t>(mesh.vertex_format),
+      .vertex_count = static_cast<uint32_t>(mesh.vertices.size()),
+      .index_count = static_cast<uint32_t>(mesh.indices.size()),
+      .index_size = 0,
+      .bounds = compute_bounds(mesh.vertices),
+      .lod_count = static_cast<uint32_t>(mesh.lods.size()),
+      .meshlet_count = 0,
+  };
+
+  if (mesh.vertex_format == VertexFormat::eQuantized) {
+    const std::vector<QuantizedVertex> quantized =
+        quantize_vertices(mesh.vertices, entry.bounds);
+    entry.vertices = writer.write(std::span<const QuantizedVertex>(quantized));
+  } else {
+    entry.vertices = writer.write(mesh.vertices);
+  }
+
+  // Same narrowing rule as Uploader::upload(Mesh &).
+  if (!mesh.indices.empty() && mesh.vertices.size() <= UINT16_MAX + 1) {
+    const std::vector<uint16_t> narrow(mesh.indices.begin(),
+                                       mesh.indices.end());
+    entry.index_size = sizeof(uint16_t);
+    entry.indices = writer.write(std::span<const uint16_t>(narrow));
+  } else if (!mesh.indices.empty()) {
+    entry.index_size = sizeof(uint32_t);
+    entry.indices = writer.write(mesh.indices);
+  }
+
+  entry.lods = writer.write(mesh.lods);
+  if (mesh.meshlets != nullptr) {
+    const Meshlets &meshlets = *mesh.meshlets;
+    entry.meshlet_count = static_cast<uint32_t>(meshlets.meshlets.size());
+    entry.meshlets = writer.write(std::span<const Meshlet>(meshlets.meshlets));
+    entry.meshlet_vertices =
+        writer.write(std::span<const uint32_t>(meshlets.vertices));
+    entry.meshlet_triangles =
+        writer.write(std::span<const uint8_t>(meshlets.triangles));
+  }
+  return entry;
+}
+} // namespace
+
+MeshAsset::MeshAsset(const std::string &path) : m_file(path) {
+  const AssetReader reader(path, m_file.bytes());
+  const auto &header = reader.record<MeshAssetHeader>(0);
+  if (header.magic != mesh_asset_magic)
+    reader.fail("bad magic");
+  if (header.version != mesh_asset_version)
+    reader.fail("unsupported version");
+  if (header.file_size != m_file.size())
+    reader.fail("truncated");
+  const std::span<const MeshAssetEntry> entries =
+      reader.array<MeshAssetEntry>(
+          MeshAssetBlob{
+              .offset = header.entries_offset,
+              .size = uint64_t{header.mesh_count} * sizeof(MeshAssetEntry),
+          },
+          header.mesh_count);
+
+  m_meshes.reserve(entries.size());
+  for (const MeshAssetEntry &entry : entries) {
+    if (entry.vertex_format > static_cast<uint32_t>(VertexFormat::eQuantized))
+      reader.fail("unknown vertex format");
+    if (entry.index_size != 0 && entry.index_size != sizeof(uint16_t) &&
+        entry.index_size != sizeof(uint32_t))
+      reader.fail("unsupported index size");
+    if (entry.vertices.offset % mesh_asset_alignment != 0 ||
+        entry.indices.offset % mesh_asset_alignment != 0)
+      reader.fail("misaligned blob");
+
+    MeshAssetView view{
+        .vertex_format = static_cast<VertexFormat>(entry.vertex_format),
+        .vertex_count = entry.vertex_count,
+        .index_count = entry.index_count,
+        .index_size = entry.index_size,
+        .bounds = entry.bounds,
+    };
+    view.vertices = reader.range(entry.vertices.offset, entry.vertices.size);
+    if (view.vertices.size() !=
+        uint64_t{entry.vertex_count} * vertex_stride(view.vertex_format))
+      reader.fail("vertex blob doesn't match the vertex count");
+    view.indices = reader.range(entry.indices.offset, entry.indices.size);
+    if (view.indices.size() != uint64_t{entry.index_count} * entry.index_size)
+      reader.fail("index blob doesn't match the index count");
+    if (!(entry.index_size == sizeof(uint16_t)
+              ? indices_in_range<uint16_t>(view.indices, entry.vertex_count)
+              : indices_in_range<uint32_t>(view.indices, entry.vertex_count)))
+      reader.fail("index past the vertex count");
+
+    view.lods = reader.array<MeshLod>(entry.lods, entry.lod_count);
+    for (const MeshLod &lod : view.lods) {
+      if (lod.first_index > entry.index_count ||
+          lod.index_count > entry.index_count - lod.first_index)
+        reader.fail("level of detail outside the index buffer");
+    }
+    view.meshlets = reader.array<Meshlet>(entry.meshlets, entry.meshlet_count);
+    view.meshlet_vertices = reader.array<uint32_t>(
+        entry.meshlet_vertices, entry.meshlet_vertices.size / sizeof(uint32_t));
+    view.meshlet_triangles = reader.range(entry.meshlet_triangles.offset,
+                                          entry.meshlet_triangles.size);
+    for (const Meshlet &meshlet : view.meshlets) {
+      if (meshlet.vertex_count > max_meshlet_vertices ||
+          meshlet.triangle_count > max_meshlet_triangles)
+        reader.fail("meshlet over the size limits");
+      if (meshlet.vertex_offset > view.meshlet_vertices.size() ||
+          meshlet.vertex_count >
+              view.meshlet_vertices.size() - meshlet.vertex_offset)
+        reader.fail("meshlet vertices outside the vertex list");
+      // Triangle offsets count triangles, three bytes each.
+      const uint64_t triangle_offset = uint64_t{meshlet.triangle_offset} * 3;
+      const uint64_t triangle_bytes = uint64_t{meshlet.triangle_count} * 3;
+      if (triangle_offset > view.meshlet_triangles.size() ||
+          triangle_bytes > view.meshlet_triangles.size() - triangle_offset)
+        reader.fail("meshlet triangles outside the triangle list");
+      for (uint32_t vertex : view.meshlet_vertices.subspan(
+               meshlet.vertex_offset, meshlet.vertex_count)) {
+        if (vertex >= entry.vertex_count)
+          reader.fail("meshlet vertex past the vertex count");
+      }
+      for (uint8_t local :
+           view.meshlet_triangles.subspan(triangle_offset, triangle_bytes)) {
+        if (local >= meshlet.vertex_count)
+          reader.fail("meshlet triangle past the meshlet's vertices");
+      }
+    }
+    m_meshes.push_back(view);
+  }
+  // Everything will be read front to back by the upload that follows.
+  m_file.will_need();
+}
+
+void write_mesh_asset(const std::string &path,
+                      std::span<const MeshAssetSource> meshes) {
+  const std::string temporary_path = path + ".tmp";
+  bool written;
+  {
+    AssetWriter writer(temporary_path);
+    MeshAssetHeader header{
+        .magic = mesh_asset_magic,
+        .version = mesh_asset_version,
+        .mesh_count = static_cast<uint32_t>(meshes.size()),
+        .reserved = 0,
+        .file_size = 0,
+        .entries_offset = align_up(sizeof(MeshAssetHeader),
+                                   mesh_asset_alignment),
+    };
+    // The entries hold the blob offsets, so they are patched in once every
+    // blob has been written.
+    std::vector<MeshAssetEntry> entries(meshes.size());
+    writer.pad_to(header.entries_offset +
+                  entries.size() * sizeof(MeshAssetEntry));
+    for (size_t i = 0; i < meshes.size(); i++) {
+      entries[i] = write_mesh(writer, meshes[i]);
+    }
+    header.file_size = writer.offset();
+    writer.patch(0, &header, sizeof(header));
+    writer.patch(header.entries_offset, entries.data(),
+                 entries.size() * sizeof(MeshAssetEntry));
+    written = writer.finish();
+  }
+  std::error_code error;
+  if (!written) {
+    std::filesystem::remove(temporary_path, error);
+    throw std::runtime_error(
+        fmt::format("Failed to write mesh asset {0}", temporary_path));
+  }
+  std::filesystem::rename(temporary_path, path, error);
+  if (error) {
+    const std::string message = error.message();
+    std::filesystem::remove(temporary_path, error);
+    throw std::runtime_error(fmt::format(
+        "Failed to replace mesh asset {0}: {1}", path, message));
+  }
+}
+} // namespace bs::engine::types
@@ -0,0 +1,485 @@
+#include <engine/types/mesh_optimizer.hpp>
+
+#include <engine/types/quantized_vertex.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace bs::engine::types {
+namespace {
+// FIFO cache keyed by the time each vertex was last inserted; a vertex is
+// resident while fewer than `size` insertions happened since.
+class FifoCache {
+public:
+  FifoCache(uint32_t vertex_count, uint32_t size)
+      : m_timestamps(vertex_count, 0), m_size(size) {}
+
+  // Returns true on a miss.
+  bool access(uint32_t vertex) {
+    if (m_time - m_timestamps[vertex] < m_size)
+      return false;
+    m_timestamps[vertex] = m_time++;
+    return true;
+  }
+  uint32_t access_triangle(const uint32_t *triangle) {
+    return access(triangle[0]) + access(triangle[1]) + access(triangle[2]);
+  }
+  void reset() { m_time += m_size; }
+
+private:
+  std::vector<uint32_t> m_timestamps;
+  // Starts past the cache size so nothing is resident initially.
+  uint32_t m_time = 1u << 16;
+  uint32_t m_size;
+};
+
+struct Adjacency {
+  // Triangles using vertex v are triangles[offsets[v]..offsets[v + 1]).
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> triangles;
+};
+
+Adjacency build_adjacency(std::span<const uint32_t> indices,
+                          uint32_t vertex_count) {
+  Adjacency adjacency;
+  adjacency.offsets.assign(vertex_count + 1, 0);
+  for (uint32_t index : indices) {
+    adjacency.offsets[index + 1]++;
+  }
+  std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(),
+                   adjacency.offsets.begin());
+  adjacency.triangles.resize(indices.size());
+  std::vector<uint32_t> cursor(adjacency.offsets.begin(),
+                               adjacency.offsets.end() - 1);
+  for (uint32_t i = 0; i < indices.size(); i++) {
+    adjacency.triangles[cursor[indices[i]]++] = i / 3;
+  }
+  return adjacency;
+}
+
+// Whether `b` holds the same triangles as `a`, in any order but with each
+// triangle's winding kept.
+bool same_triangles(std::span<const uint32_t> a, std::span<const uint32_t> b) {
+  if (a.size() != b.size())
+    return false;
+  const auto sorted = [](std::span<const uint32_t> indices) {
+    std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+    for (size_t t = 0; t < triangles.size(); t++) {
+      triangles[t] = {indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]};
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+  };
+  return sorted(a) == sorted(b);
+}
+
+struct VertexHash {
+  size_t operator()(const Vertex &vertex) const {
+    uint8_t bytes[sizeof(Vertex)];
+    std::memcpy(bytes, &vertex, sizeof(Vertex));
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint8_t byte : bytes) {
+      hash ^= byte;
+      hash *= 0x100000001b3ull;
+    }
+    return hash;
+  }
+};
+struct VertexEqual {
+  bool operator()(const Vertex &a, const Vertex &b) const {
+    return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+  }
+};
+} // namespace
+
+VertexCacheStats analyze_vertex_cache(std::span<const uint32_t> indices,
+                                      uint32_t vertex_count,
+                                      uint32_t cache_size) {
+  if (indices.size() < 3)
+    return {};
+  FifoCache cache(vertex_count, cache_size);
+  std::vector<bool> referenced(vertex_count, false);
+  uint32_t misses = 0;
+  uint32_t unique = 0;
+  for (uint32_t index : indices) {
+    misses += cache.access(index);
+    if (!referenced[index]) {
+      referenced[index] = true;
+      unique++;
+    }
+  }
+  return VertexCacheStats{
+      .acmr = static_cast<float>(misses) / (indices.size() / 3),
+      .atvr = static_cast<float>(misses) / unique,
+  };
+}
+
+std::vector<uint32_t> weld_vertices(std::vector<Vertex> &vertices) {
+  std::vector<uint32_t> indices(vertices.size());
+  std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> unique;
+  unique.reserve(vertices.size());
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < vertices.size(); i++) {
+    auto [it, inserted] = unique.try_emplace(vertices[i], count);
+    if (inserted)
+      vertices[count++] = vertices[i];
+    indices[i] = it->second;
+  }
+  vertices.resize(count);
+  return indices;
+}
+
+void optimize_vertex_cache(std::span<uint32_t> indices, uint32_t vertex_count,
+                           uint32_t cache_size) {
+  const uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+  if (triangle_count == 0)
+    return;
+  const Adjacency adjacency = build_adjacency(indices, vertex_count);
+
+  // Triangles not emitted yet per vertex.
+  std::vector<uint32_t> live(vertex_count);
+  for (uint32_t v = 0; v < vertex_count; v++) {
+    live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+  }
+  std::vector<uint32_t> cache_time(vertex_count, 0);
+  std::vector<bool> emitted(triangle_count, false);
+  std::vector<uint32_t> dead_end;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+
+  uint32_t time = cache_size + 1;
+  uint32_t cursor = 0;
+  int64_t fanning = 0;
+  while (fanning >= 0) {
+    const uint32_t vertex = static_cast<uint32_t>(fanning);
+    candidates.clear();
+    for (uint32_t a = adjacency.offsets[vertex];
+         a < adjacency.offsets[vertex + 1]; a++) {
+      const uint32_t triangle = adjacency.triangles[a];
+      if (emitted[triangle])
+        continue;
+      emitted[triangle] = true;
+      for (uint32_t corner = 0; corner < 3; corner++) {
+        const uint32_t v = indices[triangle * 3 + corner];
+        output.push_back(v);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        live[v]--;
+        if (time - cache_time[v] > cache_size)
+          cache_time[v] = time++;
+      }
+    }
+
+    // Prefer the candidate that stays in the cache longest while still
+    // having triangles left, unless fanning it would push it out anyway.
+    fanning = -1;
+    int64_t best_priority = -1;
+    for (uint32_t v : candidates) {
+      if (live[v] == 0)
+        continue;
+      int64_t priority = 0;
+      if (time - cache_time[v] + 2 * live[v] <= cache_size)
+        priority = time - cache_time[v];
+      if (priority > best_priority) {
+        best_priority = priority;
+        fanning = v;
+      }
+    }
+    if (fanning >= 0)
+      continue;
+
+    // Dead end: back up to a recently used vertex, then to the next vertex
+    // in input order that still has triangles.
+    while (!dead_end.empty() && fanning < 0) {
+      const uint32_t v = dead_end.back();
+      dead_end.pop_back();
+      if (live[v] > 0)
+        fanning = v;
+    }
+    while (fanning < 0 && cursor < vertex_count) {
+      if (live[cursor] > 0)
+        fanning = cursor;
+      cursor++;
+    }
+  }
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void optimize_overdraw(std::span<uint32_t> indices,
+                       std::span<const Vertex> vertices, float threshold,
+                       uint32_t cache_size) {
+  const uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+  if (triangle_count == 0)
+    return;
+  const uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+
+  // Hard boundaries: triangles whose three vertices all miss, i.e. where
+  // the cache-optimised order restarts anyway. The first cluster starts at
+  // the first triangle whatever it shares.
+  std::vector<uint32_t> clusters{0};
+  {
+    FifoCache cache(vertex_count, cache_size);
+    for (uint32_t t = 0; t < triangle_count; t++) {
+      if (cache.access_triangle(&indices[t * 3]) == 3 && t > 0)
+        clusters.push_back(t);
+    }
+  }
+  clusters.push_back(triangle_count);
+
+  // Soft boundaries: split a hard cluster wherever the ACMR so far is
+  // already within the threshold of the whole cluster's.
+  std::vector<uint32_t> soft_clusters;
+  for (size_t c = 0; c + 1 < clusters.size(); c++) {
+    const uint32_t begin = clusters[c];
+    const uint32_t end = clusters[c + 1];
+    FifoCache cache(vertex_count, cache_size);
+    uint32_t misses = 0;
+    for (uint32_t t = begin; t < end; t++) {
+      misses += cache.access_triangle(&indices[t * 3]);
+    }
+    const float limit =
+        threshold * static_cast<float>(misses) / (end - begin);
+
+    cache.reset();
+    uint32_t start = begin;
+    misses = 0;
+    soft_clusters.push_back(begin);
+    for (uint32_t t = begin; t < end; t++) {
+      misses += cache.access_triangle(&indices[t * 3]);
+      if (t + 1 < end &&
+          static_cast<float>(misses) / (t + 1 - start) <= limit) {
+        soft_clusters.push_back(t + 1);
+        start = t + 1;
+        misses = 0;
+        cache.reset();
+      }
+    }
+  }
+  soft_clusters.push_back(triangle_count);
+
+  // Sort by how much each cluster faces away from the mesh centre; those
+  // facing outwards occlude the rest and go first.
+  glm::vec3 mesh_centroid{0.f};
+  float mesh_area = 0.f;
+  const size_t cluster_count = soft_clusters.size() - 1;
+  std::vector<glm::vec3> centroids(cluster_count, glm::vec3{0.f});
+  std::vector<glm::vec3> normals(cluster_count, glm::vec3{0.f});
+  for (size_t c = 0; c < cluster_count; c++) {
+    float cluster_area = 0.f;
+    for (uint32_t t = soft_clusters[c]; t < soft_clusters[c + 1]; t++) {
+      const glm::vec3 &p0 = vertices[indices[t * 3 + 0]].position;
+      const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].position;
+      const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].position;
+      const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+      const float area = glm::length(normal);
+      centroids[c] += (p0 + p1 + p2) * (area / 3.f);
+      normals[c] += normal;
+      cluster_area += area;
+    }
+    mesh_centroid += centroids[c];
+    mesh_area += cluster_area;
+    centroids[c] =
+        cluster_area > 0.f ? centroids[c] / cluster_area : centroids[c];
+    const float length = glm::length(normals[c]);
+    normals[c] = length > 0.f ? normals[c] / length : normals[c];
+  }
+  if (mesh_area > 0.f)
+    mesh_centroid /= mesh_area;
+
+  std::vector<float> keys(cluster_count);
+  for (size_t c = 0; c < cluster_count; c++) {
+    keys[c] = glm::dot(centroids[c] - mesh_centroid, normals[c]);
+  }
+  std::vector<uint32_t> order(cluster_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+  for (uint32_t c : order) {
+    output.insert(output.end(), indices.begin() + soft_clusters[c] * 3,
+                  indices.begin() + soft_clusters[c + 1] * 3);
+  }
+  if (output.size() != triangle_count * 3)
+    throw std::runtime_error("optimize_overdraw lost triangles");
+  assert(same_triangles(std::span<const uint32_t>(indices.data(),
+                                                  triangle_count * 3),
+                        output) &&
+         "optimize_overdraw must only reorder triangles");
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void optimize_vertex_fetch(std::vector<Vertex> &vertices,
+                           std::span<uint32_t> indices) {
+  constexpr uint32_t unused = UINT32_MAX;
+  std::vector<uint32_t> remap(vertices.size(), unused);
+  std::vector<Vertex> reordered;
+  reordered.reserve(vertices.size());
+  for (uint32_t &index : indices) {
+    if (remap[index] == unused) {
+      remap[index] = static_cast<uint32_t>(reordered.size());
+      reordered.push_back(vertices[index]);
+    }
+    index = remap[index];
+  }
+  vertices = std::move(reordered);
+}
+
+float simplify_clustered(std::span<const uint32_t> indices,
+                         std::span<const Vertex> vertices, uint32_t grid_size,
+                         std::vector<uint32_t> &output) {
+  output.clear();
+  if (vertices.empty() || grid_size == 0)
+    return 0.f;
+  // compute_bounds() stands in 1 for a flat axis, which would give small
+  // planar meshes a unit-sized grid, so the extent is measured here.
+  glm::vec3 min = vertices.front().position;
+  glm::vec3 max = vertices.front().position;
+  for (const Vertex &vertex : vertices) {
+    min = glm::min(min, vertex.position);
+    max = glm::max(max, vertex.position);
+  }
+  const glm::vec3 size = max - min;
+  const float extent = std::max({size.x, size.y, size.z});
+  // Every vertex in one place collapses into a single cell either way.
+  const float cell_size = extent > 0.f ? extent / grid_size : 1.f;
+
+  auto cell_of = [&](const glm::vec3 &position) {
+    const glm::vec3 cell = (position - min) / cell_size;
+    const auto axis = [&](float value) {
+      return static_cast<uint64_t>(
+          std::clamp(value, 0.f, static_cast<float>(grid_size)));
+    };
+    return (axis(cell.x) << 42) | (axis(cell.y) << 21) | axis(cell.z);
+  };
+
+  std::vector<uint32_t> representative(vertices.size());
+  std::unordered_map<uint64_t, uint32_t> cells;
+  cells.reserve(vertices.size());
+  for (uint32_t v = 0; v < vertices.size(); v++) {
+    representative[v] =
+        cells.try_emplace(cell_of(vertices[v].position), v).first->second;
+  }
+
+  output.reserve(indices.size());
+  for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+    const uint32_t a = representative[indices[t + 0]];
+    const uint32_t b = representative[indices[t + 1]];
+    const uint32_t c = representative[indices[t + 2]];
+    if (a == b || b == c || a == c)
+      continue;
+    output.insert(output.end(), {a, b, c});
+  }
+  return cell_size;
+}
+
+Meshlets build_meshlets(std::span<const uint32_t> indices,
+                        std::span<const Vertex> vertices) {
+  Meshlets result;
+  constexpr uint8_t unused = 0xff;
+  // Local index of each mesh vertex in the meshlet being built.
+  std::vector<uint8_t> local(vertices.size(), unused);
+  Meshlet current;
+
+  auto finish = [&]() {
+    if (current.triangle_count == 0)
+      return;
+    glm::vec3 min = vertices[result.vertices[current.vertex_offset]].position;
+    glm::vec3 max = min;
+    for (uint32_t i = 0; i < current.vertex_count; i++) {
+      const uint32_t vertex = result.vertices[current.vertex_offset + i];
+      min = glm::min(min, vertices[vertex].position);
+      max = glm::max(max, vertices[vertex].position);
+      local[vertex] = unused;
+    }
+    current.center = (min + max) * 0.5f;
+    for (uint32_t i = 0; i < current.vertex_count; i++) {
+      const glm::vec3 &position =
+          vertices[result.vertices[current.vertex_offset + i]].position;
+      current.radius =
+          std::max(current.radius, glm::length(position - current.center));
+    }
+    result.meshlets.push_back(current);
+    current = Meshlet{
+        .vertex_offset = static_cast<uint32_t>(result.vertices.size()),
+        .triangle_offset = static_cast<uint32_t>(result.triangles.size() / 3),
+    };
+  };
+
+  for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+    const uint32_t new_vertices = (local[indices[t + 0]] == unused) +
+                                  (local[indices[t + 1]] == unused) +
+                                  (local[indices[t + 2]] == unused);
+    if (current.vertex_count + new_vertices > max_meshlet_vertices ||
+        current.triangle_count + 1 > max_meshlet_triangles)
+      finish();
+    for (size_t corner = 0; corner < 3; corner++) {
+      const uint32_t vertex = indices[t + corner];
+      if (local[vertex] == unused) {
+        local[vertex] = static_cast<uint8_t>(current.vertex_count++);
+        result.vertices.push_back(vertex);
+      }
+      result.triangles.push_back(local[vertex]);
+    }
+    current.triangle_count++;
+  }
+  finish();
+  return result;
+}
+
+MeshOptimizationReport optimize_mesh(std::vector<Vertex> &vertices,
+                                     std::vector<uint32_t> &indices,
+                                     float overdraw_threshold) {
+  MeshOptimizationReport report;
+  // Nothing to draw, and the ATVR below would divide by zero.
+  if (vertices.empty())
+    return report;
+  report.input_vertices = static_cast<uint32_t>(vertices.size());
+  if (indices.empty()) {
+    // Unindexed meshes are drawn as triangle lists of consecutive vertices.
+    indices.resize(vertices.size());
+    std::iota(indices.begin(), indices.end(), 0);
+  }
+  report.triangles = static_cast<uint32_t>(indices.size() / 3);
+  report.before = analyze_vertex_cache(
+      indices, static_cast<uint32_t>(vertices.size()));
+
+  // Welding the expanded vertex stream also merges duplicates an existing
+  // index buffer didn't catch.
+  std::vector<Vertex> expanded;
+  expanded.reserve(indices.size());
+  for (uint32_t index : indices) {
+    expanded.push_back(vertices[index]);
+  }
+  indices = weld_vertices(expanded);
+  vertices = std::move(expanded);
+  // Against the welded vertex count, so a soup reports the transforms it
+  // wastes instead of a trivially perfect 1.
+  report.before.atvr = report.before.acmr * report.triangles / vertices.size();
+
+  optimize_vertex_cache(indices, static_cast<uint32_t>(vertices.size()));
+  optimize_overdraw(indices, vertices, overdraw_threshold);
+  optimize_vertex_fetch(vertices, indices);
+
+  report.output_vertices = static_cast<uint32_t>(vertices.size());
+  report.after = analyze_vertex_cache(
+      indices, static_cast<uint32_t>(vertices.size()));
+  return report;
+}
+
+void log_report(const MeshOptimizationReport &report) {
+  spdlog::info("Mesh optimised: {0} triangles, vertices {1} -> {2}, "
+               "ACMR {3:.3f} -> {4:.3f}, ATVR {5:.3f} -> {6:.3f}",
+               report.triangles, report.input_vertices,
+               report.output_vertices, report.before.acmr, report.after.acmr,
+               report.before.atvr, report.after.atvr);
+}
+} // namespace bs::engine::types
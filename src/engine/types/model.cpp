@@ -2,6 +2,7 @@
 
 namespace bs::engine::types {
 Model::Model() {}
-Model::Model(const Mesh &mesh) {}
+Model::Model(MeshHandle mesh) : m_meshes{mesh} {}
+Model::Model(std::vector<MeshHandle> meshes) : m_meshes(std::move(meshes)) {}
 Model::~Model() {}
 } // namespace bs::engine::types
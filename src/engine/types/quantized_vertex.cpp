@@ -0,0 +1,111 @@
+#include <engine/types/quantized_vertex.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace bs::engine::types {
+namespace {
+constexpr float unorm16_max = 65535.f;
+constexpr float snorm16_max = 32767.f;
+
+uint16_t to_unorm16(float value) {
+  return static_cast<uint16_t>(
+      std::lround(std::clamp(value, 0.f, 1.f) * unorm16_max));
+}
+int16_t to_snorm16(float value) {
+  return static_cast<int16_t>(
+      std::lround(std::clamp(value, -1.f, 1.f) * snorm16_max));
+}
+float from_snorm16(int16_t value) {
+  // Matches the Vulkan SNORM conversion, where -32768 also maps to -1.
+  return std::max(static_cast<float>(value) / snorm16_max, -1.f);
+}
+float sign_not_zero(float value) { return value >= 0.f ? 1.f : -1.f; }
+} // namespace
+
+VertexBounds compute_bounds(std::span<const Vertex> vertices) {
+  if (vertices.empty())
+    return {};
+  glm::vec3 min = vertices.front().position;
+  glm::vec3 max = vertices.front().position;
+  for (const Vertex &vertex : vertices) {
+    min = glm::min(min, vertex.position);
+    max = glm::max(max, vertex.position);
+  }
+  // A flat axis still needs a non-zero scale to divide by.
+  glm::vec3 scale = max - min;
+  for (int axis = 0; axis < 3; axis++) {
+    if (scale[axis] <= 0.f)
+      scale[axis] = 1.f;
+  }
+  return VertexBounds{.offset = min, .scale = scale};
+}
+
+std::array<uint16_t, 4> quantize_position(const glm::vec3 &position,
+                                          const VertexBounds &bounds) {
+  const glm::vec3 normalized = (position - bounds.offset) / bounds.scale;
+  return {to_unorm16(normalized.x), to_unorm16(normalized.y),
+          to_unorm16(normalized.z), 0};
+}
+
+glm::vec3 dequantize_position(const std::array<uint16_t, 4> &position,
+                              const VertexBounds &bounds) {
+  const glm::vec3 normalized{position[0] / unorm16_max,
+                             position[1] / unorm16_max,
+                             position[2] / unorm16_max};
+  return bounds.offset + normalized * bounds.scale;
+}
+
+std::array<int16_t, 2> encode_octahedral(const glm::vec3 &normal) {
+  // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower
+  // hemisphere over the diagonals.
+  const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+  if (l1 <= 0.f)
+    return {0, 0};
+  float x = normal.x / l1;
+  float y = normal.y / l1;
+  if (normal.z < 0.f) {
+    const float folded_x = (1.f - std::abs(y)) * sign_not_zero(x);
+    const float folded_y = (1.f - std::abs(x)) * sign_not_zero(y);
+    x = folded_x;
+    y = folded_y;
+  }
+  return {to_snorm16(x), to_snorm16(y)};
+}
+
+glm::vec3 decode_octahedral(const std::array<int16_t, 2> &encoded) {
+  const float x = from_snorm16(encoded[0]);
+  const float y = from_snorm16(encoded[1]);
+  glm::vec3 normal{x, y, 1.f - std::abs(x) - std::abs(y)};
+  const float t = std::max(-normal.z, 0.f);
+  normal.x += normal.x >= 0.f ? -t : t;
+  normal.y += normal.y >= 0.f ? -t : t;
+  return glm::normalize(normal);
+}
+
+QuantizedVertex quantize_vertex(const Vertex &vertex,
+                                const VertexBounds &bounds) {
+  return QuantizedVertex{
+      .position = quantize_position(vertex.position, bounds),
+      .normal = encode_octahedral(vertex.normal),
+  };
+}
+
+Vertex dequantize_vertex(const QuantizedVertex &vertex,
+                         const VertexBounds &bounds) {
+  return Vertex{
+      .position = dequantize_position(vertex.position, bounds),
+      .normal = decode_octahedral(vertex.normal),
+  };
+}
+
+std::vector<QuantizedVertex> quantize_vertices(std::span<const Vertex> vertices,
+                                               const VertexBounds &bounds) {
+  std::vector<QuantizedVertex> quantized;
+  quantized.reserve(vertices.size());
+  for (const Vertex &vertex : vertices) {
+    quantized.push_back(quantize_vertex(vertex, bounds));
+  }
+  return quantized;
+}
+} // namespace bs::engine::types
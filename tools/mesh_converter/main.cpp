@@ -0,0 +1,232 @@
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <engine/types/mesh_asset.hpp>
+#include <engine/types/mesh_optimizer.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace bs::engine::types;
+
+namespace {
+struct Options {
+  std::string input;
+  std::string output;
+  VertexFormat vertex_format = VertexFormat::eFull;
+  // Levels below the full-detail one.
+  uint32_t lod_count = 3;
+  bool meshlets = true;
+};
+
+// A mesh before optimisation: a triangle soup with one vertex per corner.
+struct SourceMesh {
+  std::string name;
+  std::vector<Vertex> vertices;
+};
+
+// Everything the asset references, kept alive until it's written.
+struct ConvertedMesh {
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  std::vector<MeshLod> lods;
+  Meshlets meshlets;
+};
+
+void print_usage() {
+  fmt::print("usage: mesh_converter <input.obj> <output.bsm> [--quantize] "
+             "[--lods <count>] [--no-meshlets]\n");
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; i++) {
+    const std::string argument = argv[i];
+    if (argument == "--quantize") {
+      options.vertex_format = VertexFormat::eQuantized;
+    } else if (argument == "--no-meshlets") {
+      options.meshlets = false;
+    } else if (argument == "--lods" && i + 1 < argc) {
+      options.lod_count = static_cast<uint32_t>(std::strtoul(argv[++i],
+                                                             nullptr, 10));
+    } else if (argument.starts_with("--")) {
+      return false;
+    } else {
+      positional.push_back(argument);
+    }
+  }
+  if (positional.size() != 2)
+    return false;
+  options.input = positional[0];
+  options.output = positional[1];
+  return true;
+}
+
+// OBJ indices are 1-based and negative ones count back from the end.
+int64_t resolve_index(std::string_view token, size_t count) {
+  int64_t index = 0;
+  std::from_chars(token.data(), token.data() + token.size(), index);
+  return index < 0 ? static_cast<int64_t>(count) + index : index - 1;
+}
+
+// Positions, normals and faces of a Wavefront OBJ; every `o` or `g` starts
+// a new mesh. Faces are fan-triangulated and faces without normals get the
+// face normal.
+std::vector<SourceMesh> load_obj(const std::string &path) {
+  std::ifstream file(path);
+  if (!file.is_open())
+    throw std::runtime_error(fmt::format("Failed to open {0}", path));
+
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<SourceMesh> meshes(1);
+  std::vector<Vertex> face;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    std::string keyword;
+    stream >> keyword;
+    if (keyword == "v") {
+      glm::vec3 &position = positions.emplace_back();
+      stream >> position.x >> position.y >> position.z;
+    } else if (keyword == "vn") {
+      glm::vec3 &normal = normals.emplace_back();
+      stream >> normal.x >> normal.y >> normal.z;
+    } else if (keyword == "o" || keyword == "g") {
+      if (!meshes.back().vertices.empty())
+        meshes.emplace_back();
+      stream >> meshes.back().name;
+    } else if (keyword == "f") {
+      face.clear();
+      bool has_normals = true;
+      std::string corner;
+      while (stream >> corner) {
+        // v, v/vt, v//vn or v/vt/vn; texture coordinates are ignored.
+        const size_t first_slash = corner.find('/');
+        const size_t last_slash = corner.rfind('/');
+        const int64_t position = resolve_index(
+            std::string_view(corner).substr(0, first_slash), positions.size());
+        if (position < 0 || position >= static_cast<int64_t>(positions.size()))
+          throw std::runtime_error(
+              fmt::format("{0}: face references a missing vertex", path));
+        Vertex &vertex = face.emplace_back(Vertex{positions[position], {}});
+        if (first_slash == std::string::npos || last_slash == first_slash ||
+            last_slash + 1 == corner.size()) {
+          has_normals = false;
+          continue;
+        }
+        const int64_t normal = resolve_index(
+            std::string_view(corner).substr(last_slash + 1), normals.size());
+        if (normal < 0 || normal >= static_cast<int64_t>(normals.size()))
+          throw std::runtime_error(
+              fmt::format("{0}: face references a missing normal", path));
+        vertex.normal = normals[normal];
+      }
+      if (face.size() < 3)
+        continue;
+      if (!has_normals) {
+        const glm::vec3 cross = glm::cross(face[1].position - face[0].position,
+                                           face[2].position - face[0].position);
+        const float length = glm::length(cross);
+        const glm::vec3 normal =
+            length > 0.f ? cross / length : glm::vec3(0.f, 0.f, 1.f);
+        for (Vertex &vertex : face) {
+          vertex.normal = normal;
+        }
+      }
+      std::vector<Vertex> &vertices = meshes.back().vertices;
+      for (size_t i = 1; i + 1 < face.size(); i++) {
+        vertices.insert(vertices.end(), {face[0], face[i], face[i + 1]});
+      }
+    }
+  }
+  std::erase_if(meshes,
+                [](const SourceMesh &mesh) { return mesh.vertices.empty(); });
+  return meshes;
+}
+
+ConvertedMesh convert(SourceMesh &source, const Options &options) {
+  ConvertedMesh mesh;
+  mesh.vertices = std::move(source.vertices);
+  log_report(optimize_mesh(mesh.vertices, mesh.indices));
+
+  const uint32_t full_count = static_cast<uint32_t>(mesh.indices.size());
+  mesh.lods.push_back(MeshLod{.first_index = 0, .index_count = full_count});
+  if (options.meshlets)
+    mesh.meshlets = build_meshlets(mesh.indices, mesh.vertices);
+
+  // Each level halves the grid resolution, starting where a grid cell is
+  // roughly the size of an average edge of the full mesh.
+  uint32_t grid_size = static_cast<uint32_t>(
+      std::max(2.0, std::sqrt(static_cast<double>(full_count / 3))));
+  std::vector<uint32_t> lod;
+  for (uint32_t level = 0; level < options.lod_count && grid_size >= 2;
+       level++, grid_size /= 2) {
+    const MeshLod &previous = mesh.lods.back();
+    const float error = simplify_clustered(
+        std::span<const uint32_t>(mesh.indices).first(full_count),
+        mesh.vertices, grid_size, lod);
+    // Not worth a level unless it drops at least a quarter of the triangles.
+    if (lod.empty() || lod.size() * 4 > previous.index_count * 3)
+      continue;
+    optimize_vertex_cache(lod, static_cast<uint32_t>(mesh.vertices.size()));
+    mesh.lods.push_back(MeshLod{
+        .first_index = static_cast<uint32_t>(mesh.indices.size()),
+        .index_count = static_cast<uint32_t>(lod.size()),
+        .error = error,
+    });
+    mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+  }
+  return mesh;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+  try {
+    std::vector<SourceMesh> sources = load_obj(options.input);
+    std::vector<ConvertedMesh> meshes;
+    meshes.reserve(sources.size());
+    for (SourceMesh &source : sources) {
+      spdlog::info("Converting mesh '{0}'", source.name);
+      meshes.push_back(convert(source, options));
+      for (const MeshLod &lod : meshes.back().lods) {
+        spdlog::info("  LOD: {0} triangles, error {1:.4f}",
+                     lod.index_count / 3, lod.error);
+      }
+      spdlog::info("  {0} meshlets", meshes.back().meshlets.meshlets.size());
+    }
+
+    std::vector<MeshAssetSource> asset_sources;
+    asset_sources.reserve(meshes.size());
+    for (const ConvertedMesh &mesh : meshes) {
+      asset_sources.push_back(MeshAssetSource{
+          .vertices = mesh.vertices,
+          .indices = mesh.indices,
+          .lods = mesh.lods,
+          .meshlets = options.meshlets ? &mesh.meshlets : nullptr,
+          .vertex_format = options.vertex_format,
+      });
+    }
+    write_mesh_asset(options.output, asset_sources);
+    spdlog::info("Wrote {0} meshes to {1}", asset_sources.size(),
+                 options.output);
+  } catch (std::exception &err) {
+    spdlog::error("{0}", err.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
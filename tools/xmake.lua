@@ -0,0 +1,7 @@
+target("mesh_converter")
+  set_kind("binary")
+  add_files("./mesh_converter/**.cpp")
+  add_includedirs("../include/", "../external/vkfw/include/")
+  add_deps("bs_engine_cpp")
+  add_packages("vulkan-hpp", "vulkan-memory-allocator", "glm", "fmt", "spdlog")
+  add_cxflags("-g")